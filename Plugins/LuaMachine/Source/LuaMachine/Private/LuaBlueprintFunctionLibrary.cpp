@@ -358,6 +358,16 @@ FString ULuaBlueprintFunctionLibrary::LuaValueToUTF16(const FLuaValue& Value)
 	return ReturnValue;
 }
 
+FLuaValue ULuaBlueprintFunctionLibrary::LuaValueFromBytes(const TArray<uint8>& Bytes)
+{
+	return FLuaValue::NewBytes(Bytes);
+}
+
+TArray<uint8> ULuaBlueprintFunctionLibrary::LuaValueToBytes(const FLuaValue& Value)
+{
+	return Value.ToBytes();
+}
+
 FLuaValue ULuaBlueprintFunctionLibrary::LuaValueFromUTF8(const FString& String)
 {
 	FTCHARToUTF8 UTF8String(*String);
@@ -539,14 +549,20 @@ FLuaValue ULuaBlueprintFunctionLibrary::LuaRunByteCode(UObject* WorldContextObje
 
 UTexture2D* ULuaBlueprintFunctionLibrary::LuaValueToTransientTexture(int32 Width, int32 Height, const FLuaValue& Value, EPixelFormat PixelFormat, bool bDetectFormat)
 {
-	if (Value.Type != ELuaValueType::String)
+	if (Value.Type != ELuaValueType::String && Value.Type != ELuaValueType::Bytes)
 	{
 		return nullptr;
 	}
 
 	IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
 
-	TArray<uint8> Bytes = Value.ToBytes();
+	// Bytes values are used in place, strings need to be narrowed first
+	TArray<uint8> ImageBytes;
+	if (Value.Type == ELuaValueType::String)
+	{
+		ImageBytes = Value.ToBytes();
+	}
+	TArrayView<const uint8> Bytes = Value.Type == ELuaValueType::Bytes ? Value.GetBytesView() : TArrayView<const uint8>(ImageBytes);
 
 	if (bDetectFormat)
 	{
@@ -584,10 +600,11 @@ UTexture2D* ULuaBlueprintFunctionLibrary::LuaValueToTransientTexture(int32 Width
 		Width = ImageWrapper->GetWidth();
 		Height = ImageWrapper->GetHeight();
 #if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
-		Bytes = UncompressedBytes;
+		ImageBytes = MoveTemp(UncompressedBytes);
 #else
-		Bytes = *UncompressedBytes;
+		ImageBytes = *UncompressedBytes;
 #endif
+		Bytes = ImageBytes;
 	}
 
 	UTexture2D* Texture = UTexture2D::CreateTransient(Width, Height, PixelFormat);
@@ -897,7 +914,13 @@ bool ULuaBlueprintFunctionLibrary::LuaValueIsInteger(const FLuaValue& Value)
 
 bool ULuaBlueprintFunctionLibrary::LuaValueIsString(const FLuaValue& Value)
 {
-	return Value.Type == ELuaValueType::String;
+	// Bytes values are Lua strings too
+	return Value.Type == ELuaValueType::String || Value.Type == ELuaValueType::Bytes;
+}
+
+bool ULuaBlueprintFunctionLibrary::LuaValueIsBytes(const FLuaValue& Value)
+{
+	return Value.Type == ELuaValueType::Bytes;
 }
 
 FLuaValue ULuaBlueprintFunctionLibrary::LuaTableGetByIndex(FLuaValue Table, int32 Index)
@@ -1685,7 +1708,7 @@ bool ULuaBlueprintFunctionLibrary::LuaValueIsReferencedInLuaRegistry(FLuaValue V
 UClass* ULuaBlueprintFunctionLibrary::LuaValueToBlueprintGeneratedClass(const FLuaValue& Value)
 {
 	UObject* LoadedObject = nullptr;
-	if (Value.Type == ELuaValueType::String)
+	if (Value.Type == ELuaValueType::String || Value.Type == ELuaValueType::Bytes)
 	{
 		LoadedObject = StaticLoadObject(UBlueprint::StaticClass(), nullptr, *Value.ToString());
 	}
@@ -1706,7 +1729,7 @@ UClass* ULuaBlueprintFunctionLibrary::LuaValueToBlueprintGeneratedClass(const FL
 UClass* ULuaBlueprintFunctionLibrary::LuaValueLoadClass(const FLuaValue& Value, bool bDetectBlueprintGeneratedClass)
 {
 	UObject* LoadedObject = nullptr;
-	if (Value.Type == ELuaValueType::String)
+	if (Value.Type == ELuaValueType::String || Value.Type == ELuaValueType::Bytes)
 	{
 		LoadedObject = StaticLoadObject(UObject::StaticClass(), nullptr, *Value.ToString());
 	}
@@ -1738,7 +1761,7 @@ UClass* ULuaBlueprintFunctionLibrary::LuaValueLoadClass(const FLuaValue& Value,
 UObject* ULuaBlueprintFunctionLibrary::LuaValueLoadObject(const FLuaValue& Value)
 {
 	UObject* LoadedObject = nullptr;
-	if (Value.Type == ELuaValueType::String)
+	if (Value.Type == ELuaValueType::String || Value.Type == ELuaValueType::Bytes)
 	{
 		LoadedObject = StaticLoadObject(UObject::StaticClass(), nullptr, *Value.ToString());
 	}
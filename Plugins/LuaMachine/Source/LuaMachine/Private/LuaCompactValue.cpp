@@ -0,0 +1,282 @@
+// Copyright 2025 - Roberto De Ioris
+
+#include "LuaCompactValue.h"
+
+struct FLuaCompactValue::FStringBuffer
+{
+	int32 RefCount;
+	int32 Length;
+	char Data[1];
+};
+
+struct FLuaCompactValue::FLuaValueBox
+{
+	FLuaValueBox(const FLuaValue& InValue) : RefCount(1), Value(InValue)
+	{
+	}
+
+	int32 RefCount;
+	FLuaValue Value;
+};
+
+FLuaCompactValue::FLuaCompactValue(const FString& InString) : FLuaCompactValue()
+{
+	// same bytes FLuaValue::ToBytes() would give for this string
+	TArray<uint8> Bytes = FLuaValue(InString).ToBytes();
+	*this = FromBytes(reinterpret_cast<const char*>(Bytes.GetData()), Bytes.Num());
+}
+
+FLuaCompactValue::FLuaCompactValue(const char* InChars) : FLuaCompactValue()
+{
+	*this = FromBytes(InChars, FCStringAnsi::Strlen(InChars));
+}
+
+FLuaCompactValue::FLuaCompactValue(const FLuaValue& LuaValue) : FLuaCompactValue()
+{
+	switch (LuaValue.Type)
+	{
+	case ELuaValueType::Nil:
+		break;
+	case ELuaValueType::Bool:
+		Type = ELuaValueType::Bool;
+		Bool = LuaValue.Bool;
+		break;
+	case ELuaValueType::Integer:
+		Type = ELuaValueType::Integer;
+		Integer = LuaValue.Integer;
+		break;
+	case ELuaValueType::Number:
+		Type = ELuaValueType::Number;
+		Number = LuaValue.Number;
+		break;
+	case ELuaValueType::UObject:
+		if (LuaValue.Object)
+		{
+			Type = ELuaValueType::UObject;
+			Object = LuaValue.Object;
+		}
+		break;
+	case ELuaValueType::String:
+	{
+		TArray<uint8> Bytes = LuaValue.ToBytes();
+		*this = FromBytes(reinterpret_cast<const char*>(Bytes.GetData()), Bytes.Num());
+	}
+	break;
+	case ELuaValueType::Bytes:
+	{
+		TArrayView<const uint8> Bytes = LuaValue.GetBytesView();
+		*this = FromBytes(reinterpret_cast<const char*>(Bytes.GetData()), Bytes.Num(), ELuaValueType::Bytes);
+	}
+	break;
+	default:
+		Type = LuaValue.Type;
+		Box = new FLuaValueBox(LuaValue);
+		break;
+	}
+}
+
+FLuaCompactValue::FLuaCompactValue(const FLuaCompactValue& SourceValue) : Integer(SourceValue.Integer), Type(SourceValue.Type)
+{
+	AddRef();
+}
+
+FLuaCompactValue::FLuaCompactValue(FLuaCompactValue&& SourceValue) : Integer(SourceValue.Integer), Type(SourceValue.Type)
+{
+	SourceValue.Type = ELuaValueType::Nil;
+	SourceValue.Integer = 0;
+}
+
+FLuaCompactValue& FLuaCompactValue::operator = (const FLuaCompactValue& SourceValue)
+{
+	if (this != &SourceValue)
+	{
+		Release();
+		Type = SourceValue.Type;
+		Integer = SourceValue.Integer;
+		AddRef();
+	}
+	return *this;
+}
+
+FLuaCompactValue& FLuaCompactValue::operator = (FLuaCompactValue&& SourceValue)
+{
+	if (this != &SourceValue)
+	{
+		Release();
+		Type = SourceValue.Type;
+		Integer = SourceValue.Integer;
+		SourceValue.Type = ELuaValueType::Nil;
+		SourceValue.Integer = 0;
+	}
+	return *this;
+}
+
+FLuaCompactValue FLuaCompactValue::FromBytes(const char* InBytes, const int32 Length, const ELuaValueType InType)
+{
+	check(InType == ELuaValueType::String || InType == ELuaValueType::Bytes);
+
+	FLuaCompactValue LuaValue;
+	LuaValue.Type = InType;
+	LuaValue.StringBuffer = (FStringBuffer*)FMemory::Malloc(STRUCT_OFFSET(FStringBuffer, Data) + Length + 1);
+	LuaValue.StringBuffer->RefCount = 1;
+	LuaValue.StringBuffer->Length = Length;
+	if (Length > 0)
+	{
+		FMemory::Memcpy(LuaValue.StringBuffer->Data, InBytes, Length);
+	}
+	LuaValue.StringBuffer->Data[Length] = 0;
+	return LuaValue;
+}
+
+void FLuaCompactValue::AddRef()
+{
+	if (HasStringBuffer())
+	{
+		FPlatformAtomics::InterlockedIncrement(&StringBuffer->RefCount);
+	}
+	else if (!IsStoredInline())
+	{
+		FPlatformAtomics::InterlockedIncrement(&Box->RefCount);
+	}
+}
+
+void FLuaCompactValue::Release()
+{
+	if (HasStringBuffer())
+	{
+		if (FPlatformAtomics::InterlockedDecrement(&StringBuffer->RefCount) == 0)
+		{
+			FMemory::Free(StringBuffer);
+		}
+	}
+	else if (!IsStoredInline())
+	{
+		if (FPlatformAtomics::InterlockedDecrement(&Box->RefCount) == 0)
+		{
+			delete Box;
+		}
+	}
+	Type = ELuaValueType::Nil;
+	Integer = 0;
+}
+
+bool FLuaCompactValue::ToBool() const
+{
+	switch (Type)
+	{
+	case ELuaValueType::Nil:
+		return false;
+	case ELuaValueType::Bool:
+		return Bool;
+	case ELuaValueType::Integer:
+		return Integer != 0;
+	case ELuaValueType::Number:
+		return Number != 0;
+	}
+	return true;
+}
+
+int64 FLuaCompactValue::ToInteger() const
+{
+	switch (Type)
+	{
+	case ELuaValueType::Bool:
+		return Bool ? 1 : 0;
+	case ELuaValueType::Integer:
+		return Integer;
+	case ELuaValueType::Number:
+		return Number;
+	case ELuaValueType::String:
+	case ELuaValueType::Bytes:
+		return FCStringAnsi::Atoi(StringBuffer->Data);
+	}
+	return 0;
+}
+
+double FLuaCompactValue::ToFloat() const
+{
+	switch (Type)
+	{
+	case ELuaValueType::Bool:
+		return Bool ? 1.0 : 0.0;
+	case ELuaValueType::Integer:
+		return Integer;
+	case ELuaValueType::Number:
+		return Number;
+	case ELuaValueType::String:
+	case ELuaValueType::Bytes:
+		return FCStringAnsi::Atod(StringBuffer->Data);
+	}
+	return 0.0;
+}
+
+FString FLuaCompactValue::ToString() const
+{
+	switch (Type)
+	{
+	case ELuaValueType::Nil:
+		return FString(TEXT("nil"));
+	case ELuaValueType::Bool:
+		return Bool ? FString(TEXT("true")) : FString(TEXT("false"));
+	case ELuaValueType::Integer:
+		return FString::Printf(TEXT("%lld"), Integer);
+	case ELuaValueType::Number:
+		return FString::SanitizeFloat(Number);
+	case ELuaValueType::UObject:
+		return Object->GetFullName();
+	case ELuaValueType::String:
+	case ELuaValueType::Bytes:
+		return FLuaValue(StringBuffer->Data, StringBuffer->Length).String;
+	}
+	return Box->Value.ToString();
+}
+
+const char* FLuaCompactValue::GetStringData() const
+{
+	return HasStringBuffer() ? StringBuffer->Data : nullptr;
+}
+
+int32 FLuaCompactValue::GetStringLength() const
+{
+	return HasStringBuffer() ? StringBuffer->Length : 0;
+}
+
+FLuaValue* FLuaCompactValue::GetBoxedLuaValue() const
+{
+	return !HasStringBuffer() && !IsStoredInline() ? &Box->Value : nullptr;
+}
+
+FLuaValue FLuaCompactValue::ToLuaValue() const
+{
+	switch (Type)
+	{
+	case ELuaValueType::Nil:
+		return FLuaValue();
+	case ELuaValueType::Bool:
+		return FLuaValue(Bool);
+	case ELuaValueType::Integer:
+		return FLuaValue(Integer);
+	case ELuaValueType::Number:
+		return FLuaValue(Number);
+	case ELuaValueType::UObject:
+		return FLuaValue(Object);
+	case ELuaValueType::String:
+		return FLuaValue(StringBuffer->Data, StringBuffer->Length);
+	case ELuaValueType::Bytes:
+		return FLuaValue::NewBytes(TArray<uint8>(reinterpret_cast<const uint8*>(StringBuffer->Data), StringBuffer->Length));
+	}
+	return Box->Value;
+}
+
+int32 FLuaCompactValue::GetAllocatedSize() const
+{
+	if (HasStringBuffer())
+	{
+		return STRUCT_OFFSET(FStringBuffer, Data) + StringBuffer->Length + 1;
+	}
+	if (!IsStoredInline())
+	{
+		return sizeof(FLuaValueBox) + Box->Value.String.GetAllocatedSize();
+	}
+	return 0;
+}
@@ -0,0 +1,97 @@
+// Copyright 2025 - Roberto De Ioris
+
+#include "LuaMemoryPool.h"
+
+void* FLuaMemoryPool::Realloc(void* Ptr, size_t OldSize, size_t NewSize)
+{
+	const int32 OldSizeClass = Ptr ? GetSizeClass(OldSize) : INDEX_NONE;
+
+	if (NewSize == 0)
+	{
+		if (OldSizeClass != INDEX_NONE)
+		{
+			FreeBlock(Ptr, OldSizeClass);
+		}
+		else if (Ptr)
+		{
+			FMemory::Free(Ptr);
+		}
+		return nullptr;
+	}
+
+	const int32 NewSizeClass = GetSizeClass(NewSize);
+
+	if (Ptr && OldSizeClass == NewSizeClass && NewSizeClass != INDEX_NONE)
+	{
+		return Ptr;
+	}
+
+	// both big (or a new big block), FMalloc can grow it in place
+	if (OldSizeClass == INDEX_NONE && NewSizeClass == INDEX_NONE)
+	{
+		return FMemory::Realloc(Ptr, NewSize, Granularity);
+	}
+
+	void* NewPtr = NewSizeClass != INDEX_NONE ? AllocateBlock(NewSizeClass) : FMemory::Malloc(NewSize, Granularity);
+	if (Ptr)
+	{
+		FMemory::Memcpy(NewPtr, Ptr, FMath::Min(OldSize, NewSize));
+		if (OldSizeClass != INDEX_NONE)
+		{
+			FreeBlock(Ptr, OldSizeClass);
+		}
+		else
+		{
+			FMemory::Free(Ptr);
+		}
+	}
+
+	return NewPtr;
+}
+
+void* FLuaMemoryPool::AllocateBlock(const int32 SizeClass)
+{
+	if (FFreeBlock* Block = FreeLists[SizeClass])
+	{
+		FreeLists[SizeClass] = Block->Next;
+		return Block;
+	}
+
+	const int32 BlockSize = (SizeClass + 1) * Granularity;
+	if (PageCursor + BlockSize > PageEnd)
+	{
+		// the tail of the previous page is not worth tracking, it is at most MaxPooledSize - Granularity bytes
+		PageCursor = (uint8*)FMemory::Malloc(PageSize, Granularity);
+		PageEnd = PageCursor + PageSize;
+		Pages.Add(PageCursor);
+	}
+
+	void* Block = PageCursor;
+	PageCursor += BlockSize;
+	return Block;
+}
+
+void FLuaMemoryPool::FreeBlock(void* Ptr, const int32 SizeClass)
+{
+	FFreeBlock* Block = (FFreeBlock*)Ptr;
+	Block->Next = FreeLists[SizeClass];
+	FreeLists[SizeClass] = Block;
+}
+
+void FLuaMemoryPool::Empty()
+{
+	for (void* Page : Pages)
+	{
+		FMemory::Free(Page);
+	}
+	Pages.Empty();
+	FMemory::Memzero(FreeLists);
+	PageCursor = nullptr;
+	PageEnd = nullptr;
+}
+
+void FLuaMemoryPool::SetPoolingEnabled(const bool bEnabled)
+{
+	check(Pages.Num() == 0);
+	bPoolingEnabled = bEnabled;
+}
@@ -13,13 +13,43 @@
 #include "AssetRegistryModule.h"
 #endif
 #include "GameFramework/Actor.h"
+#include "Async/Async.h"
+#include "Runtime/Core/Public/HAL/FileManager.h"
 #include "Runtime/Core/Public/Misc/FileHelper.h"
+#include "Runtime/Core/Public/Misc/SecureHash.h"
 #include "Runtime/Core/Public/Misc/Paths.h"
 #include "Runtime/Core/Public/Serialization/BufferArchive.h"
 #include "Runtime/CoreUObject/Public/UObject/TextProperty.h"
 
+#if LUAMACHINE_LUAJIT
+extern "C"
+{
+#include "ThirdParty/luajit/luajit.h"
+}
+#elif LUAMACHINE_LUAU
+#include "ThirdParty/luau/Luau/Bytecode.h"
+#endif
+
 LUAMACHINE_API DEFINE_LOG_CATEGORY(LogLuaMachine);
 
+// scripts of a FLuaStatePool run on task graph workers, where UObjects (and ProcessEvent) must not be touched
+#define LUAMACHINE_RETURN_ERROR_IF_NOT_GAME_THREAD(L) if (!IsInGameThread()) \
+	{ \
+		LUAMACHINE_RETURN_ERROR(L, "UObjects can only be accessed from the game thread"); \
+	}
+
+// part of the bytecode cache key, so entries from another VM (or VM version) are never loaded
+static FString GetByteCodeCacheVMVersion()
+{
+#if LUAMACHINE_LUA53
+	return FString::Printf(TEXT("%s %d"), ANSI_TO_TCHAR(LUA_RELEASE), (int32)sizeof(void*));
+#elif LUAMACHINE_LUAJIT
+	return FString::Printf(TEXT("%s %d"), ANSI_TO_TCHAR(LUAJIT_VERSION), (int32)sizeof(void*));
+#elif LUAMACHINE_LUAU
+	return FString::Printf(TEXT("Luau %d"), (int32)LBC_VERSION_TARGET);
+#endif
+}
+
 ULuaState::ULuaState()
 {
 	L = nullptr;
@@ -33,27 +63,85 @@ ULuaState::ULuaState()
 	bEnableReturnHook = false;
 	bEnableCountHook = false;
 	bRawLuaFunctionCall = false;
+	bInternUserDataKeys = true;
+	bPoolLuaAllocations = true;
+	bCacheByteCode = false;
 
 	FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &ULuaState::GCLuaDelegatesCheck);
 }
 
 
-void ULuaState::OnAllocateCallback(lua_State* L, size_t OSize, size_t NSize)
+void* ULuaState::LuaAlloc(void* UserData, void* Ptr, size_t OSize, size_t NSize)
 {
-	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
-	LuaState->CurrentMemoryUsage -= OSize;
-	LuaState->CurrentMemoryUsage += NSize;
+	ULuaState* LuaState = (ULuaState*)UserData;
+
+	// when allocating a new object Lua passes its type in OSize
+	if (!Ptr)
+	{
+		OSize = 0;
+	}
+
+	// growing is the only operation allowed to fail, the VM raises a memory error (after a full gc) when it does.
+	// Outside of protected calls that error would be a panic, so the limit is not enforced there
+	if (NSize > OSize && LuaState->MaxMemoryUsage > 0 && LuaState->MemoryUsageBaseline >= 0 && LuaState->ProtectedCallDepth > 0 &&
+		LuaState->CurrentMemoryUsage - LuaState->MemoryUsageBaseline + (int64)(NSize - OSize) > LuaState->MaxMemoryUsage)
+	{
+		LuaState->bMaxMemoryUsageReached = true;
+		return nullptr;
+	}
+
+	LuaState->CurrentMemoryUsage += (int64)NSize - (int64)OSize;
+	return LuaState->MemoryPool.Realloc(Ptr, OSize, NSize);
 }
 
 void ULuaState::OnInterrupt(lua_State* L, int gc)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
-	if (LuaState->CurrentMemoryUsage > LuaState->MaxMemoryUsage)
+	const int64 ScriptMemoryUsage = LuaState->CurrentMemoryUsage - LuaState->MemoryUsageBaseline;
+	if (ScriptMemoryUsage > LuaState->MaxMemoryUsage)
+	{
+		LuaState->Error(FString::Printf(TEXT("MaxMemoryUsage reached: %lld/%lld"), ScriptMemoryUsage, LuaState->MaxMemoryUsage));
+	}
+}
+
+#if LUAMACHINE_LUA53 || LUAMACHINE_LUAJIT
+int ULuaState::OnPanic(lua_State* L)
+{
+	// returning from here makes Lua call abort(), failing through the engine at least reports the error and a callstack
+	UE_LOG(LogLuaMachine, Fatal, TEXT("unprotected error in call to Lua API (%s)"), ANSI_TO_TCHAR(lua_tostring(L, -1)));
+	return 0;
+}
+
+int ULuaState::OnProtectedCallEnter(lua_State* L)
+{
+	lua_pushinteger(L, ULuaState::GetFromExtraSpace(L)->ProtectedCallDepth);
+	return 1;
+}
+
+int ULuaState::OnProtectedCallLeave(lua_State* L)
+{
+	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	LuaState->ProtectedCallDepth = (int32)lua_tointeger(L, 1);
+	if (!lua_toboolean(L, 2))
 	{
-		LuaState->Error(FString::Printf(TEXT("MaxMemoryUsage reached: %lld/%lld"), LuaState->CurrentMemoryUsage, LuaState->MaxMemoryUsage));
+		// the script handled the error, a later memory error must not be reported as MaxMemoryUsage because of it
+		LuaState->bMaxMemoryUsageReached = false;
 	}
+	lua_remove(L, 1);
+	return lua_gettop(L);
 }
 
+/* enter and leave are only reachable as upvalues of the wrappers */
+static const char* ProtectedCallWrappers =
+	"local enter, leave = ...\n"
+	"local function wrap(call)\n"
+	"	return function(...) local depth = enter() return leave(depth, call(...)) end\n"
+	"end\n"
+	"if pcall then pcall = wrap(pcall) end\n"
+	"if xpcall then xpcall = wrap(xpcall) end\n"
+	"if coroutine and coroutine.resume then coroutine.resume = wrap(coroutine.resume) end\n";
+#endif
+
 void ULuaState::OnProfile(lua_State* L, int gc)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
@@ -159,7 +247,27 @@ ULuaState* ULuaState::GetLuaState(UWorld* InWorld)
 		return nullptr;
 	}
 
-	L = luaL_newstate();
+	CurrentMemoryUsage = 0;
+	MemoryUsageBaseline = -1;
+#if LUAMACHINE_LUAU
+	// Luau already carves its small blocks out of pages of its own, pooling them again only adds a layer
+	MemoryPool.SetPoolingEnabled(false);
+#else
+	MemoryPool.SetPoolingEnabled(bPoolLuaAllocations);
+#endif
+
+	L = lua_newstate(LuaAlloc, this);
+#if LUAMACHINE_LUAJIT
+	// non GC64 LuaJIT builds only accept their own allocator
+	if (!L)
+	{
+		UE_LOG(LogLuaMachine, Warning, TEXT("LuaJIT refused the LuaMachine allocator, memory accounting and MaxMemoryUsage are not available"));
+		L = luaL_newstate();
+	}
+#endif
+#if LUAMACHINE_LUA53 || LUAMACHINE_LUAJIT
+	lua_atpanic(L, OnPanic);
+#endif
 
 	if (bLuaOpenLibs)
 	{
@@ -236,6 +344,9 @@ ULuaState* ULuaState::GetLuaState(UWorld* InWorld)
 	ULuaState** LuaExtraSpacePtr = (ULuaState**)lua_getextraspace(L);
 	*LuaExtraSpacePtr = this;
 
+	lua_newtable(L);
+	InternedKeysRef = NewRef();
+
 	// get the global table
 	lua_pushglobaltable(L);
 	// override print
@@ -326,6 +437,24 @@ ULuaState* ULuaState::GetLuaState(UWorld* InWorld)
 	// pop global table
 	Pop();
 
+#if LUAMACHINE_LUA53 || LUAMACHINE_LUAJIT
+	// an error raised in a C++ function longjmps over its FNativeCallScope, when the script catches it the wrappers put ProtectedCallDepth back
+	if (!luaL_loadstring(L, ProtectedCallWrappers))
+	{
+		PushCFunction(ULuaState::OnProtectedCallEnter);
+		PushCFunction(ULuaState::OnProtectedCallLeave);
+		if (lua_pcall(L, 2, 0, 0))
+		{
+			UE_LOG(LogLuaMachine, Error, TEXT("unable to wrap pcall: %s"), ANSI_TO_TCHAR(lua_tostring(L, -1)));
+			Pop();
+		}
+	}
+	else
+	{
+		Pop();
+	}
+#endif
+
 	// require LuaBlueprintPackages
 	for (TPair<FString, TSubclassOf<ULuaBlueprintPackage>>& Pair : LuaBlueprintPackagesTable)
 	{
@@ -365,15 +494,17 @@ ULuaState* ULuaState::GetLuaState(UWorld* InWorld)
 	}
 #elif LUAMACHINE_LUAU
 	lua_Callbacks* Callbacks = lua_callbacks(L);
+	// luau_load runs outside of protected mode, so the limit is also checked while running the loaded code
 	if (MaxMemoryUsage > 0)
 	{
-		Callbacks->onallocate = OnAllocateCallback;
 		Callbacks->interrupt = OnInterrupt;
 	}
 
 	Callbacks->debugstep = Debug_SingleStep;
 #endif
 
+	MemoryUsageBaseline = CurrentMemoryUsage;
+
 	if (LuaCodeAsset)
 	{
 		if (!RunCodeAsset(LuaCodeAsset))
@@ -506,6 +637,11 @@ bool ULuaState::RunFile(const FString& Filename, bool bIgnoreNonExistent, int NR
 
 	if (FFileHelper::LoadFileToArray(Code, *AbsoluteFilename))
 	{
+		if (bCacheByteCode)
+		{
+			return LoadCachedCode(Code, AbsoluteFilename) && RunLoadedCode(NRet);
+		}
+
 		if (RunCode(Code, AbsoluteFilename, NRet))
 		{
 			return true;
@@ -527,41 +663,151 @@ bool ULuaState::RunCode(const FString& Code, const FString& CodePath, int NRet)
 }
 
 bool ULuaState::RunCode(const TArray<uint8>& Code, const FString& CodePath, int NRet)
+{
+	return LoadCode(Code, CodePath) && RunLoadedCode(NRet);
+}
+
+bool ULuaState::LoadCode(const TArray<uint8>& Code, const FString& CodePath, const bool bByteCode)
 {
 	FString FullCodePath = FString("@") + CodePath;
 
 #if LUAMACHINE_LUA53 || LUAMACHINE_LUAJIT
-	if (luaL_loadbuffer(L, (const char*)Code.GetData(), Code.Num(), TCHAR_TO_ANSI(*FullCodePath)))
+	// the parser runs in protected mode, so allocations can be refused. Bytecode is detected by the loader itself
+	const int32 SavedProtectedCallDepth = ProtectedCallDepth++;
+	int Result = luaL_loadbuffer(L, (const char*)Code.GetData(), Code.Num(), TCHAR_TO_ANSI(*FullCodePath));
+	ProtectedCallDepth = SavedProtectedCallDepth;
+	if (Result)
 #elif LUAMACHINE_LUAU
-	size_t ByteCodeSize = 0;
-
-	char* ByteCode = luau_compile(reinterpret_cast<const char*>(Code.GetData()), Code.Num(), nullptr, &ByteCodeSize);
-	if (ByteCode && ByteCode[0] == 0)
+	int Result = 0;
+	if (bByteCode)
 	{
-		LastError = FString::Printf(TEXT("Lua loading error: %s"), ANSI_TO_TCHAR(ByteCode + 1));
+		Result = luau_load(L, TCHAR_TO_ANSI(*CodePath), reinterpret_cast<const char*>(Code.GetData()), Code.Num(), 0);
+	}
+	else
+	{
+		size_t ByteCodeSize = 0;
+
+		char* ByteCode = luau_compile(reinterpret_cast<const char*>(Code.GetData()), Code.Num(), nullptr, &ByteCodeSize);
+		if (ByteCode && ByteCode[0] == 0)
+		{
+			LastError = FString::Printf(TEXT("Lua loading error: %s"), ANSI_TO_TCHAR(ByteCode + 1));
+			::free(ByteCode);
+			return false;
+		}
+		Result = luau_load(L, TCHAR_TO_ANSI(*CodePath), ByteCode, ByteCodeSize, 0);
 		::free(ByteCode);
+	}
+	if (Result)
+#endif
+	{
+		LastError = FString::Printf(TEXT("Lua loading error: %s"), *GetErrorString(Result));
 		return false;
 	}
-	int Result = luau_load(L, TCHAR_TO_ANSI(*CodePath), ByteCode, ByteCodeSize, 0);
-	::free(ByteCode);
+
+	return true;
+}
+
+bool ULuaState::RunLoadedCode(int NRet)
+{
+	const int32 SavedProtectedCallDepth = ProtectedCallDepth++;
+	const int Result = lua_pcall(L, 0, NRet, 0);
+	ProtectedCallDepth = SavedProtectedCallDepth;
 	if (Result)
+	{
+		LastError = FString::Printf(TEXT("Lua execution error: %s"), *GetErrorString(Result));
+		return false;
+	}
+
+	return true;
+}
+
+bool ULuaState::LoadCachedCode(const TArray<uint8>& Code, const FString& CodePath)
+{
+	// entries are named after the path and VM version only, so an edited script overwrites its old entry instead of adding one
+	const FTCHARToUTF8 VMVersion(*GetByteCodeCacheVMVersion());
+	const FTCHARToUTF8 CodePathUTF8(*CodePath);
+	FSHA1 PathSha1;
+	PathSha1.Update((const uint8*)VMVersion.Get(), VMVersion.Length());
+	PathSha1.Update((const uint8*)CodePathUTF8.Get(), CodePathUTF8.Length());
+	PathSha1.Final();
+
+	FSHAHash PathHash;
+	PathSha1.GetHash(PathHash.Hash);
+	const FString CacheFilename = FPaths::Combine(GetByteCodeCacheDirectory(), PathHash.ToString() + TEXT(".luac"));
+
+	// the entry starts with the hash of the source it was built from
+	FSHAHash CodeHash;
+	FSHA1::HashBuffer(Code.GetData(), Code.Num(), CodeHash.Hash);
+	const int32 CodeHashSize = UE_ARRAY_COUNT(CodeHash.Hash);
+
+	TArray<uint8> ByteCode;
+	if (FFileHelper::LoadFileToArray(ByteCode, *CacheFilename, FILEREAD_Silent) && ByteCode.Num() > CodeHashSize &&
+		FMemory::Memcmp(ByteCode.GetData(), CodeHash.Hash, CodeHashSize) == 0)
+	{
+		ByteCode.RemoveAt(0, CodeHashSize, false);
+		if (LoadCode(ByteCode, CodePath, true))
+		{
+			return true;
+		}
+		// truncated or not loadable anymore, rebuild it from the source
+		Pop();
+	}
+	ByteCode.Empty();
+
+#if LUAMACHINE_LUA53 || LUAMACHINE_LUAJIT
+	if (!LoadCode(Code, CodePath))
+	{
+		return false;
+	}
+
+	// debug info is kept, unlike ToByteCode, so errors still report lines
+#if LUAMACHINE_LUAJIT
+	lua_dump(L, ULuaState::ToByteCode_Writer, &ByteCode);
+#else
+	lua_dump(L, ULuaState::ToByteCode_Writer, &ByteCode, 0);
 #endif
+#elif LUAMACHINE_LUAU
+	size_t ByteCodeSize = 0;
+	char* CompiledByteCode = luau_compile(reinterpret_cast<const char*>(Code.GetData()), Code.Num(), nullptr, &ByteCodeSize);
+	if (CompiledByteCode && CompiledByteCode[0] == 0)
 	{
-		LastError = FString::Printf(TEXT("Lua loading error: %s"), ANSI_TO_TCHAR(lua_tostring(L, -1)));
+		LastError = FString::Printf(TEXT("Lua loading error: %s"), ANSI_TO_TCHAR(CompiledByteCode + 1));
+		::free(CompiledByteCode);
 		return false;
 	}
-	else
+	ByteCode.Append(reinterpret_cast<const uint8*>(CompiledByteCode), ByteCodeSize);
+	::free(CompiledByteCode);
+
+	if (!LoadCode(ByteCode, CodePath, true))
 	{
-		if (lua_pcall(L, 0, NRet, 0))
+		return false;
+	}
+#endif
+
+	// written aside and moved in place, so other states (or processes) never load a partial file
+	const FString TempFilename = CacheFilename + TEXT(".") + FGuid::NewGuid().ToString() + TEXT(".tmp");
+	ByteCode.Insert(CodeHash.Hash, CodeHashSize, 0);
+	if (ByteCode.Num() > CodeHashSize && FFileHelper::SaveArrayToFile(ByteCode, *TempFilename))
+	{
+		if (!IFileManager::Get().Move(*CacheFilename, *TempFilename, true, true))
 		{
-			LastError = FString::Printf(TEXT("Lua execution error: %s"), ANSI_TO_TCHAR(lua_tostring(L, -1)));
-			return false;
+			IFileManager::Get().Delete(*TempFilename, false, false, true);
 		}
 	}
 
 	return true;
 }
 
+FString ULuaState::GetByteCodeCacheDirectory()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LuaMachine"), TEXT("ByteCodeCache"));
+}
+
+void ULuaState::ClearByteCodeCache()
+{
+	IFileManager::Get().DeleteDirectory(*GetByteCodeCacheDirectory(), false, true);
+}
+
 int ULuaState::ToByteCode_Writer(lua_State* L, const void* Ptr, size_t Size, void* UserData)
 {
 	TArray<uint8>* Output = (TArray<uint8>*)UserData;
@@ -638,6 +884,12 @@ void ULuaState::FromLuaValue(FLuaValue& LuaValue, UObject* CallContext, lua_Stat
 		lua_pushlstring(State, (const char*)Bytes.GetData(), Bytes.Num());
 	}
 	break;
+	case ELuaValueType::Bytes:
+	{
+		TArrayView<const uint8> Bytes = LuaValue.GetBytesView();
+		lua_pushlstring(State, Bytes.Num() > 0 ? (const char*)Bytes.GetData() : "", Bytes.Num());
+	}
+	break;
 	case ELuaValueType::Table:
 		if (LuaValue.LuaRef == LUA_NOREF)
 		{
@@ -857,7 +1109,14 @@ FLuaValue ULuaState::ToLuaValue(int Index, lua_State* State)
 	{
 		size_t StringLength = 0;
 		const char* String = lua_tolstring(State, Index, &StringLength);
-		LuaValue = FLuaValue(String, StringLength);
+		if (BytesValueMinLength > 0 && StringLength >= (size_t)BytesValueMinLength)
+		{
+			LuaValue = FLuaValue::NewBytes(TArray<uint8>((const uint8*)String, (int32)StringLength));
+		}
+		else
+		{
+			LuaValue = FLuaValue(String, StringLength);
+		}
 	}
 	else if (lua_isinteger(State, Index))
 	{
@@ -930,6 +1189,87 @@ FLuaValue ULuaState::ToLuaValue(int Index, lua_State* State)
 	return LuaValue;
 }
 
+void ULuaState::FromLuaCompactValue(const FLuaCompactValue& LuaValue, UObject* CallContext, lua_State* State)
+{
+	if (!State)
+	{
+		State = this->L;
+	}
+
+	switch (LuaValue.GetType())
+	{
+	case ELuaValueType::Nil:
+		lua_pushnil(State);
+		return;
+	case ELuaValueType::Bool:
+		lua_pushboolean(State, LuaValue.ToBool() ? 1 : 0);
+		return;
+	case ELuaValueType::Integer:
+		lua_pushinteger(State, LuaValue.ToInteger());
+		return;
+	case ELuaValueType::Number:
+		lua_pushnumber(State, LuaValue.ToFloat());
+		return;
+	case ELuaValueType::String:
+	case ELuaValueType::Bytes:
+		lua_pushlstring(State, LuaValue.GetStringData(), LuaValue.GetStringLength());
+		return;
+	case ELuaValueType::UObject:
+	{
+		FLuaValue ObjectValue(LuaValue.GetObject());
+		FromLuaValue(ObjectValue, CallContext, State);
+	}
+	return;
+	default:
+		FromLuaValue(*LuaValue.GetBoxedLuaValue(), CallContext, State);
+		return;
+	}
+}
+
+FLuaCompactValue ULuaState::ToLuaCompactValue(int Index, lua_State* State)
+{
+	if (!State)
+	{
+		State = this->L;
+	}
+
+	switch (lua_type(State, Index))
+	{
+	case LUA_TNONE:
+	case LUA_TNIL:
+		return FLuaCompactValue();
+	case LUA_TBOOLEAN:
+		return FLuaCompactValue(lua_toboolean(State, Index) != 0);
+	case LUA_TSTRING:
+	{
+		size_t StringLength = 0;
+		const char* String = lua_tolstring(State, Index, &StringLength);
+		// same split between String and Bytes as ToLuaValue
+		const bool bBytes = BytesValueMinLength > 0 && StringLength >= (size_t)BytesValueMinLength;
+		return FLuaCompactValue::FromBytes(String, (int32)StringLength, bBytes ? ELuaValueType::Bytes : ELuaValueType::String);
+	}
+	case LUA_TNUMBER:
+		if (lua_isinteger(State, Index))
+		{
+			return FLuaCompactValue((int64)lua_tointeger(State, Index));
+		}
+		return FLuaCompactValue((double)lua_tonumber(State, Index));
+	case LUA_TUSERDATA:
+	{
+		FLuaUserData* UserData = (FLuaUserData*)lua_touserdata(State, Index);
+		if (UserData->Type == ELuaValueType::UObject)
+		{
+			return FLuaCompactValue(UserData->Context.Get());
+		}
+	}
+	break;
+	default:
+		break;
+	}
+
+	return FLuaCompactValue(ToLuaValue(Index, State));
+}
+
 int32 ULuaState::GetTop()
 {
 	return lua_gettop(L);
@@ -937,7 +1277,9 @@ int32 ULuaState::GetTop()
 
 int ULuaState::MetaTableFunctionUserData__index(lua_State* L)
 {
+	LUAMACHINE_RETURN_ERROR_IF_NOT_GAME_THREAD(L);
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 	FLuaUserData* UserData = (FLuaUserData*)lua_touserdata(L, 1);
 
 	if (!UserData->Context.IsValid())
@@ -951,7 +1293,8 @@ int ULuaState::MetaTableFunctionUserData__index(lua_State* L)
 	ULuaUserDataObject* LuaUserDataObject = nullptr;
 	ULuaComponent* LuaComponent = nullptr;
 
-	FString Key = ANSI_TO_TCHAR(lua_tostring(L, 2));
+	FLuaInternedKey UncachedKey;
+	const FLuaInternedKey& Key = LuaState->GetInternedKey(L, 2, UncachedKey);
 
 	LuaComponent = Cast<ULuaComponent>(Context);
 
@@ -970,7 +1313,7 @@ int ULuaState::MetaTableFunctionUserData__index(lua_State* L)
 
 	if (TablePtr)
 	{
-		FLuaValue* LuaValue = TablePtr->Find(Key);
+		FLuaValue* LuaValue = TablePtr->FindByHash(Key.KeyHash, Key.Key);
 		if (LuaValue)
 		{
 			LuaState->FromLuaValue(*LuaValue, Context, L);
@@ -980,14 +1323,14 @@ int ULuaState::MetaTableFunctionUserData__index(lua_State* L)
 
 	if (LuaComponent)
 	{
-		FLuaValue MetaIndexReturnValue = LuaComponent->ReceiveLuaMetaIndex(Key);
+		FLuaValue MetaIndexReturnValue = LuaComponent->ReceiveLuaMetaIndex(Key.Key);
 		LuaState->FromLuaValue(MetaIndexReturnValue, Context, L);
 		return 1;
 	}
 
 	if (LuaUserDataObject)
 	{
-		FLuaValue MetaIndexReturnValue = LuaUserDataObject->ReceiveLuaMetaIndex(Key);
+		FLuaValue MetaIndexReturnValue = LuaUserDataObject->ReceiveLuaMetaIndex(Key.Key);
 		LuaState->FromLuaValue(MetaIndexReturnValue, MetaIndexReturnValue.Object ? MetaIndexReturnValue.Object : Context, L);
 		return 1;
 	}
@@ -996,9 +1339,46 @@ int ULuaState::MetaTableFunctionUserData__index(lua_State* L)
 	return 1;
 }
 
+const ULuaState::FLuaInternedKey& ULuaState::GetInternedKey(lua_State* State, int Index, FLuaInternedKey& UncachedKey)
+{
+	if (bInternUserDataKeys && InternedKeysRef != LUA_NOREF && lua_type(State, Index) == LUA_TSTRING)
+	{
+		size_t KeyLength = 0;
+		const char* LuaKey = lua_tolstring(State, Index, &KeyLength);
+
+		if (FLuaInternedKey* InternedKey = InternedKeys.Find(LuaKey))
+		{
+			return *InternedKey;
+		}
+
+		if (KeyLength <= MaxInternedKeyLength && InternedKeys.Num() < MaxInternedKeys)
+		{
+			Index = lua_absindex(State, Index);
+
+			// keep the string alive, otherwise the GC could give its address to a different key
+			lua_rawgeti(State, LUA_REGISTRYINDEX, InternedKeysRef);
+			lua_pushvalue(State, Index);
+			lua_pushboolean(State, 1);
+			lua_rawset(State, -3);
+			lua_pop(State, 1);
+
+			FLuaInternedKey& InternedKey = InternedKeys.Add(LuaKey);
+			InternedKey.Key = ANSI_TO_TCHAR(LuaKey);
+			InternedKey.KeyHash = GetTypeHash(InternedKey.Key);
+			return InternedKey;
+		}
+	}
+
+	UncachedKey.Key = ANSI_TO_TCHAR(lua_tostring(State, Index));
+	UncachedKey.KeyHash = GetTypeHash(UncachedKey.Key);
+	return UncachedKey;
+}
+
 int ULuaState::MetaTableFunctionUserDataInterface__index(lua_State* L)
 {
+	LUAMACHINE_RETURN_ERROR_IF_NOT_GAME_THREAD(L);
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 	FLuaUserData* UserData = (FLuaUserData*)lua_touserdata(L, 1);
 
 	if (!UserData->Context.IsValid())
@@ -1026,6 +1406,7 @@ int ULuaState::MetaTableFunctionUserDataInterface__index(lua_State* L)
 int ULuaState::MetaTableFunctionUserDataInterface__tostring(lua_State* L)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 	FLuaUserData* UserData = (FLuaUserData*)lua_touserdata(L, 1);
 
 	if (!UserData->Context.IsValid())
@@ -1050,7 +1431,9 @@ int ULuaState::MetaTableFunctionUserDataInterface__tostring(lua_State* L)
 
 int ULuaState::MetaTableFunctionUserData__newindex(lua_State* L)
 {
+	LUAMACHINE_RETURN_ERROR_IF_NOT_GAME_THREAD(L);
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 	FLuaUserData* UserData = (FLuaUserData*)lua_touserdata(L, 1);
 	if (!UserData->Context.IsValid())
 	{
@@ -1073,15 +1456,18 @@ int ULuaState::MetaTableFunctionUserData__newindex(lua_State* L)
 
 	if (TablePtr)
 	{
-		FString Key = ANSI_TO_TCHAR(lua_tostring(L, 2));
+		FLuaInternedKey UncachedKey;
+		const FLuaInternedKey& Key = LuaState->GetInternedKey(L, 2, UncachedKey);
 
-		FLuaValue* LuaValue = TablePtr->Find(Key);
+		FLuaValue* LuaValue = TablePtr->FindByHash(Key.KeyHash, Key.Key);
 		if (LuaValue)
 		{
 			*LuaValue = LuaState->ToLuaValue(3, L);
 		}
 		else
 		{
+			// the event can run Lua code that interns more keys, so do not keep a reference into the cache across it
+			const FLuaInternedKey NewKey = Key;
 			if (LuaComponent)
 			{
 				if (LuaComponent->ReceiveLuaMetaNewIndex(LuaState->ToLuaValue(2, L), LuaState->ToLuaValue(3, L)))
@@ -1089,7 +1475,7 @@ int ULuaState::MetaTableFunctionUserData__newindex(lua_State* L)
 					return 0;
 				}
 			}
-			TablePtr->Add(Key, LuaState->ToLuaValue(3, L));
+			TablePtr->AddByHash(NewKey.KeyHash, NewKey.Key, LuaState->ToLuaValue(3, L));
 		}
 	}
 
@@ -1098,7 +1484,9 @@ int ULuaState::MetaTableFunctionUserData__newindex(lua_State* L)
 
 int ULuaState::MetaTableFunctionUserDataInterface__newindex(lua_State* L)
 {
+	LUAMACHINE_RETURN_ERROR_IF_NOT_GAME_THREAD(L);
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 	FLuaUserData* UserData = (FLuaUserData*)lua_touserdata(L, 1);
 	if (!UserData->Context.IsValid())
 	{
@@ -1127,6 +1515,7 @@ int ULuaState::MetaTableFunctionUserDataInterface__newindex(lua_State* L)
 int ULuaState::MetaTableFunctionUserDataInterface__gc(lua_State* L)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 	FLuaUserData* UserData = (FLuaUserData*)lua_touserdata(L, 1);
 	if (!UserData->Context.IsValid())
 	{
@@ -1141,6 +1530,19 @@ int ULuaState::MetaTableFunctionUserDataInterface__gc(lua_State* L)
 		LUAMACHINE_RETURN_ERROR(L, "UObject %s does not implement ILuaUserDataInterface", TCHAR_TO_ANSI(*Context->GetPathName()));
 	}
 
+	// collected by a pooled state on a worker, the event still runs on the game thread
+	if (!IsInGameThread())
+	{
+		AsyncTask(ENamedThreads::GameThread, [WeakContext = UserData->Context]()
+			{
+				if (UObject* CollectedObject = WeakContext.Get())
+				{
+					ILuaUserDataInterface::Execute_LuaMetaMethodGC(CollectedObject);
+				}
+			});
+		return 0;
+	}
+
 	ILuaUserDataInterface::Execute_LuaMetaMethodGC(Context);
 
 	return 0;
@@ -1251,6 +1653,7 @@ void ULuaState::Debug_SingleStep(lua_State* L, lua_Debug* ar)
 int ULuaState::MetaTableFunctionUserData__eq(lua_State* L)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 
 	FLuaUserData* UserData = (FLuaUserData*)lua_touserdata(L, 1);
 	if (!UserData->Context.IsValid())
@@ -1296,6 +1699,7 @@ int ULuaState::MetaTableFunctionUserData__eq(lua_State* L)
 int ULuaState::MetaTableFunctionUserData__gc(lua_State* L)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 
 	FLuaUserData* UserData = (FLuaUserData*)lua_touserdata(L, 1);
 	if (!UserData->Context.IsValid())
@@ -1304,7 +1708,24 @@ int ULuaState::MetaTableFunctionUserData__gc(lua_State* L)
 	}
 
 	ULuaUserDataObject* LuaUserDataObject = Cast<ULuaUserDataObject>(UserData->Context.Get());
-	if (LuaUserDataObject)
+	if (LuaUserDataObject && !IsInGameThread())
+	{
+		// collected by a pooled state on a worker, the event still runs on the game thread
+		AsyncTask(ENamedThreads::GameThread, [WeakLuaState = TWeakObjectPtr<ULuaState>(LuaState), WeakLuaUserDataObject = TWeakObjectPtr<ULuaUserDataObject>(LuaUserDataObject)]()
+			{
+				ULuaUserDataObject* CollectedObject = WeakLuaUserDataObject.Get();
+				if (!CollectedObject)
+				{
+					return;
+				}
+				if (ULuaState* OwningLuaState = WeakLuaState.Get())
+				{
+					OwningLuaState->TrackedLuaUserDataObjects.Remove(CollectedObject);
+				}
+				CollectedObject->ReceiveLuaGC();
+			});
+	}
+	else if (LuaUserDataObject)
 	{
 		LuaState->TrackedLuaUserDataObjects.Remove(LuaUserDataObject);
 		LuaUserDataObject->ReceiveLuaGC();
@@ -1314,9 +1735,237 @@ int ULuaState::MetaTableFunctionUserData__gc(lua_State* L)
 	return 1;
 }
 
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
+#define LUACALL_PROP_CAST(Type, Property) CastField<F##Type>(Property)
+#define LUACALL_PROP_STATIC_CAST(Type, Property) static_cast<F##Type*>(Property)
+#else
+#define LUACALL_PROP_CAST(Type, Property) Cast<U##Type>(Property)
+#define LUACALL_PROP_STATIC_CAST(Type, Property) static_cast<U##Type*>(Property)
+#endif
+
+static ELuaCallParamKind GetLuaValueCallParamKind(FLuaCallProperty* Property)
+{
+	if (auto StructProp = LUACALL_PROP_CAST(StructProperty, Property))
+	{
+		return StructProp->Struct == FLuaValue::StaticStruct() ? ELuaCallParamKind::LuaValue : ELuaCallParamKind::Generic;
+	}
+
+	if (auto ArrayProp = LUACALL_PROP_CAST(ArrayProperty, Property))
+	{
+		auto InnerStructProp = LUACALL_PROP_CAST(StructProperty, ArrayProp->Inner);
+		return InnerStructProp && InnerStructProp->Struct == FLuaValue::StaticStruct() ? ELuaCallParamKind::LuaValueArray : ELuaCallParamKind::Generic;
+	}
+
+	return ELuaCallParamKind::Generic;
+}
+
+static ELuaCallParamKind GetRawCallParamKind(FLuaCallProperty* Property)
+{
+	if (LUACALL_PROP_CAST(BoolProperty, Property))
+	{
+		return ELuaCallParamKind::Bool;
+	}
+
+	if (LUACALL_PROP_CAST(FloatProperty, Property))
+	{
+		return ELuaCallParamKind::Float;
+	}
+
+	if (LUACALL_PROP_CAST(DoubleProperty, Property))
+	{
+		return ELuaCallParamKind::Double;
+	}
+
+	// UInt32 is left to ToProperty/FromProperty as they convert it through a int32
+	if (LUACALL_PROP_CAST(IntProperty, Property) || LUACALL_PROP_CAST(Int64Property, Property) || LUACALL_PROP_CAST(UInt64Property, Property) ||
+		LUACALL_PROP_CAST(Int16Property, Property) || LUACALL_PROP_CAST(UInt16Property, Property) || LUACALL_PROP_CAST(Int8Property, Property) ||
+		LUACALL_PROP_CAST(ByteProperty, Property))
+	{
+		return ELuaCallParamKind::Integer;
+	}
+
+	if (LUACALL_PROP_CAST(ObjectProperty, Property))
+	{
+		return ELuaCallParamKind::Object;
+	}
+
+	return ELuaCallParamKind::Generic;
+}
+
+const FLuaFunctionCallPlan& ULuaState::GetFunctionCallPlan(UFunction* Function)
+{
+	TUniquePtr<FLuaFunctionCallPlan>& CallPlan = FunctionCallPlans.FindOrAdd(Function);
+	// the address could belong to a new UFunction if the old one has been garbage collected
+	if (CallPlan.IsValid() && CallPlan->Function.Get() == Function && CallPlan->ParmsSize == Function->ParmsSize)
+	{
+		return *CallPlan;
+	}
+
+	CallPlan = MakeUnique<FLuaFunctionCallPlan>();
+	CallPlan->Function = Function;
+	CallPlan->ParmsSize = Function->ParmsSize;
+
+	for (TFieldIterator<FLuaCallProperty> It(Function); (It && It->HasAnyPropertyFlags(CPF_Parm)); ++It)
+	{
+		if (!It->HasAnyPropertyFlags(CPF_ZeroConstructor))
+		{
+			CallPlan->ConstructedParams.Add(*It);
+		}
+		if (!It->HasAnyPropertyFlags(CPF_NoDestructor))
+		{
+			CallPlan->DestructedParams.Add(*It);
+		}
+	}
+
+	bool bLuaValueArgsEnded = false;
+	for (TFieldIterator<FLuaCallProperty> It(Function); It && ((It->PropertyFlags & (CPF_Parm | CPF_ReturnParm)) == CPF_Parm); ++It)
+	{
+		CallPlan->RawArgs.Add({ *It, It->GetOffset_ForUFunction(), GetRawCallParamKind(*It) });
+
+		const ELuaCallParamKind Kind = GetLuaValueCallParamKind(*It);
+		if (!bLuaValueArgsEnded && Kind != ELuaCallParamKind::Generic)
+		{
+			CallPlan->LuaValueArgs.Add({ *It, It->GetOffset_ForUFunction(), Kind });
+		}
+		bLuaValueArgsEnded |= Kind != ELuaCallParamKind::LuaValue;
+	}
+
+	bool bLuaValueReturnsEnded = false;
+	for (TFieldIterator<FLuaCallProperty> It(Function); It; ++It)
+	{
+		if (!It->HasAnyPropertyFlags(CPF_ReturnParm | CPF_OutParm))
+		{
+			continue;
+		}
+
+		// avoid input args (at all costs !)
+		if (It->HasAnyPropertyFlags(CPF_ConstParm | CPF_ReferenceParm))
+		{
+			continue;
+		}
+
+		CallPlan->RawReturns.Add({ *It, It->GetOffset_ForUFunction(), GetRawCallParamKind(*It) });
+
+		const ELuaCallParamKind Kind = GetLuaValueCallParamKind(*It);
+		if (!bLuaValueReturnsEnded && Kind != ELuaCallParamKind::Generic)
+		{
+			CallPlan->LuaValueReturns.Add({ *It, It->GetOffset_ForUFunction(), Kind });
+		}
+		bLuaValueReturnsEnded |= Kind != ELuaCallParamKind::LuaValue;
+	}
+
+	return *CallPlan;
+}
+
+void ULuaState::ToCallParam(void* Parameters, const FLuaCallParam& Param, int Index, lua_State* State)
+{
+	uint8* ValuePtr = (uint8*)Parameters + Param.Offset;
+	const int LuaType = lua_type(State, Index);
+
+	// the conversions match FLuaValue::ToBool/ToInteger/ToFloat, anything else goes through ToProperty
+	switch (Param.Kind)
+	{
+	case ELuaCallParamKind::LuaValue:
+		*(FLuaValue*)ValuePtr = ToLuaValue(Index, State);
+		return;
+	case ELuaCallParamKind::Bool:
+		if (LuaType == LUA_TNONE || LuaType == LUA_TNIL || LuaType == LUA_TBOOLEAN || LuaType == LUA_TNUMBER)
+		{
+			const bool bValue = LuaType == LUA_TBOOLEAN ? lua_toboolean(State, Index) != 0 : (LuaType == LUA_TNUMBER && lua_tonumber(State, Index) != 0);
+			LUACALL_PROP_STATIC_CAST(BoolProperty, Param.Property)->SetPropertyValue(ValuePtr, bValue);
+			return;
+		}
+		break;
+	case ELuaCallParamKind::Integer:
+		if (LuaType == LUA_TNUMBER || LuaType == LUA_TBOOLEAN)
+		{
+			int64 Value = 0;
+			if (LuaType == LUA_TBOOLEAN)
+			{
+				Value = lua_toboolean(State, Index) ? 1 : 0;
+			}
+			else
+			{
+				Value = lua_isinteger(State, Index) ? (int64)lua_tointeger(State, Index) : (int64)lua_tonumber(State, Index);
+			}
+			LUACALL_PROP_STATIC_CAST(NumericProperty, Param.Property)->SetIntPropertyValue(ValuePtr, Value);
+			return;
+		}
+		break;
+	case ELuaCallParamKind::Float:
+	case ELuaCallParamKind::Double:
+		if (LuaType == LUA_TNUMBER || LuaType == LUA_TBOOLEAN)
+		{
+			const double Value = LuaType == LUA_TBOOLEAN ? (lua_toboolean(State, Index) ? 1.0 : 0.0) : (double)lua_tonumber(State, Index);
+			if (Param.Kind == ELuaCallParamKind::Float)
+			{
+				*(float*)ValuePtr = (float)Value;
+			}
+			else
+			{
+				*(double*)ValuePtr = Value;
+			}
+			return;
+		}
+		break;
+	case ELuaCallParamKind::Object:
+		if (LuaType == LUA_TNONE || LuaType == LUA_TNIL)
+		{
+			LUACALL_PROP_STATIC_CAST(ObjectProperty, Param.Property)->SetObjectPropertyValue(ValuePtr, nullptr);
+			return;
+		}
+		if (LuaType == LUA_TUSERDATA)
+		{
+			FLuaUserData* UserData = (FLuaUserData*)lua_touserdata(State, Index);
+			if (UserData->Type == ELuaValueType::UObject)
+			{
+				LUACALL_PROP_STATIC_CAST(ObjectProperty, Param.Property)->SetObjectPropertyValue(ValuePtr, UserData->Context.Get());
+				return;
+			}
+		}
+		break;
+	default:
+		break;
+	}
+
+	bool bPropertySet = false;
+	ToProperty(Parameters, Param.Property, ToLuaValue(Index, State), bPropertySet, 0);
+}
+
+void ULuaState::FromCallParam(void* Parameters, const FLuaCallParam& Param, lua_State* State)
+{
+	uint8* ValuePtr = (uint8*)Parameters + Param.Offset;
+
+	switch (Param.Kind)
+	{
+	case ELuaCallParamKind::LuaValue:
+		FromLuaValue(*(FLuaValue*)ValuePtr, nullptr, State);
+		return;
+	case ELuaCallParamKind::Bool:
+		lua_pushboolean(State, LUACALL_PROP_STATIC_CAST(BoolProperty, Param.Property)->GetPropertyValue(ValuePtr) ? 1 : 0);
+		return;
+	case ELuaCallParamKind::Integer:
+		lua_pushinteger(State, LUACALL_PROP_STATIC_CAST(NumericProperty, Param.Property)->GetSignedIntPropertyValue(ValuePtr));
+		return;
+	case ELuaCallParamKind::Float:
+		lua_pushnumber(State, *(float*)ValuePtr);
+		return;
+	case ELuaCallParamKind::Double:
+		lua_pushnumber(State, *(double*)ValuePtr);
+		return;
+	default:
+		break;
+	}
+
+	bool bPropertyGet = false;
+	FLuaValue LuaValue = FromProperty(Parameters, Param.Property, bPropertyGet, 0);
+	FromLuaValue(LuaValue, nullptr, State);
+}
+
 int ULuaState::MetaTableFunction__call(lua_State* L)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 	FLuaUserData* LuaCallContext = (FLuaUserData*)lua_touserdata(L, 1);
 
 	if (LuaCallContext->Type == ELuaValueType::Lambda)
@@ -1347,6 +1996,8 @@ int ULuaState::MetaTableFunction__call(lua_State* L)
 		}
 	}
 
+	LUAMACHINE_RETURN_ERROR_IF_NOT_GAME_THREAD(L);
+
 	if (!LuaCallContext->Context.IsValid() || !LuaCallContext->Function.IsValid())
 	{
 		LUAMACHINE_RETURN_ERROR(L, "invalid lua UFunction for UserData %p", LuaCallContext);
@@ -1382,25 +2033,17 @@ int ULuaState::MetaTableFunction__call(lua_State* L)
 		}
 	}
 
+	const FLuaFunctionCallPlan& CallPlan = LuaState->GetFunctionCallPlan(LuaCallContext->Function.Get());
+
 	FScopeCycleCounterUObject ObjectScope(CallScope);
 	FScopeCycleCounterUObject FunctionScope(LuaCallContext->Function.Get());
 
-	void* Parameters = FMemory_Alloca(LuaCallContext->Function->ParmsSize);
-	FMemory::Memzero(Parameters, LuaCallContext->Function->ParmsSize);
+	void* Parameters = FMemory_Alloca(CallPlan.ParmsSize);
+	FMemory::Memzero(Parameters, CallPlan.ParmsSize);
 
-#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
-	for (TFieldIterator<FProperty> It(LuaCallContext->Function.Get()); (It && It->HasAnyPropertyFlags(CPF_Parm)); ++It)
+	for (FLuaCallProperty* Prop : CallPlan.ConstructedParams)
 	{
-		FProperty* Prop = *It;
-#else
-	for (TFieldIterator<UProperty> It(LuaCallContext->Function.Get()); (It && It->HasAnyPropertyFlags(CPF_Parm)); ++It)
-	{
-		UProperty* Prop = *It;
-#endif
-		if (!Prop->HasAnyPropertyFlags(CPF_ZeroConstructor))
-		{
-			Prop->InitializeValue_InContainer(Parameters);
-		}
+		Prop->InitializeValue_InContainer(Parameters);
 	}
 
 	if (bImplicitSelf)
@@ -1410,61 +2053,26 @@ int ULuaState::MetaTableFunction__call(lua_State* L)
 	}
 
 	// arguments
-#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
-	for (TFieldIterator<FProperty> FArgs(LuaCallContext->Function.Get()); FArgs && ((FArgs->PropertyFlags & (CPF_Parm | CPF_ReturnParm)) == CPF_Parm); ++FArgs)
+	for (const FLuaCallParam& Param : CallPlan.LuaValueArgs)
 	{
-		FProperty* Prop = *FArgs;
-		FStructProperty* LuaProp = CastField<FStructProperty>(Prop);
-#else
-	for (TFieldIterator<UProperty> FArgs(LuaCallContext->Function.Get()); FArgs && ((FArgs->PropertyFlags & (CPF_Parm | CPF_ReturnParm)) == CPF_Parm); ++FArgs)
-	{
-		UProperty* Prop = *FArgs;
-		UStructProperty* LuaProp = Cast<UStructProperty>(Prop);
-#endif
-		if (!LuaProp)
+		if (Param.Kind == ELuaCallParamKind::LuaValueArray)
 		{
-#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
-			FArrayProperty* ArrayProp = CastField<FArrayProperty>(Prop);
-			if (ArrayProp)
+			// start filling the array with the rest of arguments
+			int ArgsToProcess = NArgs - StackPointer + 1;
+			if (ArgsToProcess < 1)
 			{
-				LuaProp = CastField<FStructProperty>(ArrayProp->Inner);
-#else
-			UArrayProperty* ArrayProp = Cast<UArrayProperty>(Prop);
-			if (ArrayProp)
+				break;
+			}
+			FScriptArrayHelper ArrayHelper(LUACALL_PROP_STATIC_CAST(ArrayProperty, Param.Property), (uint8*)Parameters + Param.Offset);
+			ArrayHelper.AddValues(ArgsToProcess);
+			for (int i = StackPointer; i < StackPointer + ArgsToProcess; i++)
 			{
-				LuaProp = Cast<UStructProperty>(ArrayProp->Inner);
-#endif
-				if (!LuaProp)
-				{
-					break;
-				}
-				if (LuaProp->Struct != FLuaValue::StaticStruct())
-				{
-					break;
-				}
-				// start filling the array with the rest of arguments
-				int ArgsToProcess = NArgs - StackPointer + 1;
-				if (ArgsToProcess < 1)
-				{
-					break;
-				}
-				FScriptArrayHelper_InContainer ArrayHelper(ArrayProp, LuaProp->ContainerPtrToValuePtr<uint8>(Parameters));
-				ArrayHelper.AddValues(ArgsToProcess);
-				for (int i = StackPointer; i < StackPointer + ArgsToProcess; i++)
-				{
-					FLuaValue LuaValue = LuaState->ToLuaValue(i, L);
-					*LuaProp->ContainerPtrToValuePtr<FLuaValue>(ArrayHelper.GetRawPtr(i - StackPointer)) = LuaValue;
-				}
+				*(FLuaValue*)ArrayHelper.GetRawPtr(i - StackPointer) = LuaState->ToLuaValue(i, L);
 			}
 			break;
 		}
-		if (LuaProp->Struct != FLuaValue::StaticStruct())
-		{
-			break;
-		}
 
-		FLuaValue LuaValue = LuaState->ToLuaValue(StackPointer++, L);
-		*LuaProp->ContainerPtrToValuePtr<FLuaValue>(Parameters) = LuaValue;
+		LuaState->ToCallParam(Parameters, Param, StackPointer++, L);
 	}
 
 	LuaState->InceptionLevel++;
@@ -1500,79 +2108,28 @@ int ULuaState::MetaTableFunction__call(lua_State* L)
 	int ReturnedValues = 0;
 
 	// get return value
-#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
-	for (TFieldIterator<FProperty> FArgs(LuaCallContext->Function.Get()); FArgs; ++FArgs)
-	{
-		FProperty* Prop = *FArgs;
-#else
-	for (TFieldIterator<UProperty> FArgs(LuaCallContext->Function.Get()); FArgs; ++FArgs)
+	for (const FLuaCallParam& Param : CallPlan.LuaValueReturns)
 	{
-		UProperty* Prop = *FArgs;
-#endif
-		if (!Prop->HasAnyPropertyFlags(CPF_ReturnParm | CPF_OutParm))
-		{
-			continue;
-		}
-
-		// avoid input args (at all costs !)
-		if (Prop->HasAnyPropertyFlags(CPF_ConstParm | CPF_ReferenceParm))
+		if (Param.Kind == ELuaCallParamKind::LuaValueArray)
 		{
-			continue;
-		}
-#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
-		FStructProperty* LuaProp = CastField<FStructProperty>(Prop);
-		if (!LuaProp)
-		{
-			FArrayProperty* ArrayProp = CastField<FArrayProperty>(Prop);
-			if (ArrayProp)
-			{
-				LuaProp = CastField<FStructProperty>(ArrayProp->Inner);
-#else
-		UStructProperty* LuaProp = Cast<UStructProperty>(Prop);
-		if (!LuaProp)
-		{
-			UArrayProperty* ArrayProp = Cast<UArrayProperty>(Prop);
-			if (ArrayProp)
+			FScriptArrayHelper ArrayHelper(LUACALL_PROP_STATIC_CAST(ArrayProperty, Param.Property), (uint8*)Parameters + Param.Offset);
+			for (int i = 0; i < ArrayHelper.Num(); i++)
 			{
-				LuaProp = Cast<UStructProperty>(ArrayProp->Inner);
-#endif
-				if (!LuaProp)
-					break;
-				if (LuaProp->Struct != FLuaValue::StaticStruct())
-					break;
-
-				FScriptArrayHelper_InContainer ArrayHelper(ArrayProp, LuaProp->ContainerPtrToValuePtr<uint8>(Parameters));
-				for (int i = 0; i < ArrayHelper.Num(); i++)
-				{
-					FLuaValue* LuaValue = LuaProp->ContainerPtrToValuePtr<FLuaValue>(ArrayHelper.GetRawPtr(i));
-					ReturnedValues++;
-					LuaState->FromLuaValue(*LuaValue, nullptr, L);
-				}
+				ReturnedValues++;
+				LuaState->FromLuaValue(*(FLuaValue*)ArrayHelper.GetRawPtr(i), nullptr, L);
 			}
 			break;
 		}
 
-		if (LuaProp->Struct != FLuaValue::StaticStruct())
-			break;
-
-		FLuaValue* LuaValue = LuaProp->ContainerPtrToValuePtr<FLuaValue>(Parameters);
-		if (LuaValue)
-		{
-			ReturnedValues++;
-			LuaState->FromLuaValue(*LuaValue, nullptr, L);
-		}
+		ReturnedValues++;
+		LuaState->FromCallParam(Parameters, Param, L);
 	}
 
-#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
-	for (TFieldIterator<FProperty> It(LuaCallContext->Function.Get()); (It && It->HasAnyPropertyFlags(CPF_Parm)); ++It)
-#else
-	for (TFieldIterator<UProperty> It(LuaCallContext->Function.Get()); (It && It->HasAnyPropertyFlags(CPF_Parm)); ++It)
-#endif
+	for (FLuaCallProperty* Prop : CallPlan.DestructedParams)
 	{
-		It->DestroyValue_InContainer(Parameters);
+		Prop->DestroyValue_InContainer(Parameters);
 	}
 
-
 	if (ReturnedValues > 0)
 		return ReturnedValues;
 
@@ -1582,7 +2139,9 @@ int ULuaState::MetaTableFunction__call(lua_State* L)
 
 int ULuaState::MetaTableFunction__rawcall(lua_State * L)
 {
+	LUAMACHINE_RETURN_ERROR_IF_NOT_GAME_THREAD(L);
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 	FLuaUserData* LuaCallContext = (FLuaUserData*)lua_touserdata(L, 1);
 
 	if (!LuaCallContext->Context.IsValid() || !LuaCallContext->Function.IsValid())
@@ -1620,25 +2179,17 @@ int ULuaState::MetaTableFunction__rawcall(lua_State * L)
 		}
 	}
 
+	const FLuaFunctionCallPlan& CallPlan = LuaState->GetFunctionCallPlan(LuaCallContext->Function.Get());
+
 	FScopeCycleCounterUObject ObjectScope(CallScope);
 	FScopeCycleCounterUObject FunctionScope(LuaCallContext->Function.Get());
 
-	void* Parameters = FMemory_Alloca(LuaCallContext->Function->ParmsSize);
-	FMemory::Memzero(Parameters, LuaCallContext->Function->ParmsSize);
+	void* Parameters = FMemory_Alloca(CallPlan.ParmsSize);
+	FMemory::Memzero(Parameters, CallPlan.ParmsSize);
 
-#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
-	for (TFieldIterator<FProperty> It(LuaCallContext->Function.Get()); (It && It->HasAnyPropertyFlags(CPF_Parm)); ++It)
+	for (FLuaCallProperty* Prop : CallPlan.ConstructedParams)
 	{
-		FProperty* Prop = *It;
-#else
-	for (TFieldIterator<UProperty> It(LuaCallContext->Function.Get()); (It && It->HasAnyPropertyFlags(CPF_Parm)); ++It)
-	{
-		UProperty* Prop = *It;
-#endif
-		if (!Prop->HasAnyPropertyFlags(CPF_ZeroConstructor))
-		{
-			Prop->InitializeValue_InContainer(Parameters);
-		}
+		Prop->InitializeValue_InContainer(Parameters);
 	}
 
 	if (bImplicitSelf)
@@ -1648,17 +2199,9 @@ int ULuaState::MetaTableFunction__rawcall(lua_State * L)
 	}
 
 	// arguments
-#if ENGINE_MAJOR_VERSION > 4 ||  ENGINE_MINOR_VERSION >= 25
-	for (TFieldIterator<FProperty> FArgs(LuaCallContext->Function.Get()); FArgs && ((FArgs->PropertyFlags & (CPF_Parm | CPF_ReturnParm)) == CPF_Parm); ++FArgs)
-	{
-		FProperty* Prop = *FArgs;
-#else
-	for (TFieldIterator<UProperty> FArgs(LuaCallContext->Function.Get()); FArgs && ((FArgs->PropertyFlags & (CPF_Parm | CPF_ReturnParm)) == CPF_Parm); ++FArgs)
+	for (const FLuaCallParam& Param : CallPlan.RawArgs)
 	{
-		UProperty* Prop = *FArgs;
-#endif
-		bool bPropertySet = false;
-		LuaState->ToProperty(Parameters, Prop, LuaState->ToLuaValue(StackPointer++, L), bPropertySet, 0);
+		LuaState->ToCallParam(Parameters, Param, StackPointer++, L);
 	}
 
 	LuaState->InceptionLevel++;
@@ -1694,39 +2237,15 @@ int ULuaState::MetaTableFunction__rawcall(lua_State * L)
 	int ReturnedValues = 0;
 
 	// get return value
-#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
-	for (TFieldIterator<FProperty> FArgs(LuaCallContext->Function.Get()); FArgs; ++FArgs)
-	{
-		FProperty* Prop = *FArgs;
-#else
-	for (TFieldIterator<UProperty> FArgs(LuaCallContext->Function.Get()); FArgs; ++FArgs)
+	for (const FLuaCallParam& Param : CallPlan.RawReturns)
 	{
-		UProperty* Prop = *FArgs;
-#endif
-		if (!Prop->HasAnyPropertyFlags(CPF_ReturnParm | CPF_OutParm))
-		{
-			continue;
-		}
-
-		// avoid input args (at all costs !)
-		if (Prop->HasAnyPropertyFlags(CPF_ConstParm | CPF_ReferenceParm))
-		{
-			continue;
-		}
-
-		bool bPropertyGet = false;
-		FLuaValue LuaValue = LuaState->FromProperty(Parameters, Prop, bPropertyGet, 0);
 		ReturnedValues++;
-		LuaState->FromLuaValue(LuaValue, nullptr, L);
+		LuaState->FromCallParam(Parameters, Param, L);
 	}
 
-#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
-	for (TFieldIterator<FProperty> It(LuaCallContext->Function.Get()); (It && It->HasAnyPropertyFlags(CPF_Parm)); ++It)
-#else
-	for (TFieldIterator<UProperty> It(LuaCallContext->Function.Get()); (It && It->HasAnyPropertyFlags(CPF_Parm)); ++It)
-#endif
+	for (FLuaCallProperty* Prop : CallPlan.DestructedParams)
 	{
-		It->DestroyValue_InContainer(Parameters);
+		Prop->DestroyValue_InContainer(Parameters);
 	}
 
 	if (ReturnedValues > 0)
@@ -1740,7 +2259,9 @@ int ULuaState::MetaTableFunction__rawcall(lua_State * L)
 
 int ULuaState::MetaTableFunction__rawbroadcast(lua_State * L)
 {
+	LUAMACHINE_RETURN_ERROR_IF_NOT_GAME_THREAD(L);
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 	FLuaUserData* LuaCallContext = (FLuaUserData*)lua_touserdata(L, 1);
 
 	if (!LuaCallContext->MulticastScriptDelegate || !LuaCallContext->Function.IsValid())
@@ -1804,6 +2325,7 @@ int ULuaState::MetaTableFunction__rawbroadcast(lua_State * L)
 int ULuaState::TableFunction_print(lua_State * L)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 	TArray<FString> Messages;
 
 	int n = lua_gettop(L);
@@ -1829,6 +2351,7 @@ int ULuaState::TableFunction_print(lua_State * L)
 int ULuaState::TableFunction_package_loader_codeasset(lua_State * L)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 
 	// use the second (sanitized by the loader) argument
 	FString Key = ANSI_TO_TCHAR(lua_tostring(L, 2));
@@ -1859,6 +2382,7 @@ int ULuaState::TableFunction_package_loader_codeasset(lua_State * L)
 int ULuaState::TableFunction_package_loader_asset(lua_State * L)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 
 	// use the second (sanitized by the loader) argument
 	const FString Key = ANSI_TO_TCHAR(lua_tostring(L, 2));
@@ -1873,6 +2397,7 @@ int ULuaState::TableFunction_package_loader_asset(lua_State * L)
 int ULuaState::TableFunction_package_loader(lua_State * L)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 
 	FString Key = ANSI_TO_TCHAR(lua_tostring(L, 1));
 
@@ -1931,6 +2456,7 @@ int ULuaState::TableFunction_package_loader(lua_State * L)
 int ULuaState::TableFunction_package_preload(lua_State * L)
 {
 	ULuaState* LuaState = ULuaState::GetFromExtraSpace(L);
+	FNativeCallScope NativeCallScope(LuaState);
 
 	if (LuaState->L != L)
 	{
@@ -2169,9 +2695,12 @@ bool ULuaState::PCall(int NArgs, FLuaValue & Value, int NRet)
 
 bool ULuaState::Call(int NArgs, FLuaValue & Value, int NRet)
 {
-	if (lua_pcall(L, NArgs, NRet, 0))
+	const int32 SavedProtectedCallDepth = ProtectedCallDepth++;
+	const int Result = lua_pcall(L, NArgs, NRet, 0);
+	ProtectedCallDepth = SavedProtectedCallDepth;
+	if (Result)
 	{
-		LastError = FString::Printf(TEXT("Lua error: %s"), ANSI_TO_TCHAR(lua_tostring(L, -1)));
+		LastError = FString::Printf(TEXT("Lua error: %s"), *GetErrorString(Result));
 		return false;
 	}
 
@@ -2292,11 +2821,13 @@ bool ULuaState::Resume(int Index, int NArgs)
 	}
 
 	lua_xmove(L, Coroutine, NArgs);
+	const int32 SavedProtectedCallDepth = ProtectedCallDepth++;
 #if LUAMACHINE_LUAJIT
 	int Ret = lua_resume(Coroutine, NArgs);
 #else
 	int Ret = lua_resume(Coroutine, L, NArgs);
 #endif
+	ProtectedCallDepth = SavedProtectedCallDepth;
 	if (Ret != LUA_OK && Ret != LUA_YIELD)
 	{
 		lua_pushboolean(L, 0);
@@ -2470,6 +3001,11 @@ ULuaState::~ULuaState()
 		lua_close(L);
 		L = nullptr;
 	}
+
+	MemoryPool.Empty();
+
+	InternedKeys.Empty();
+	InternedKeysRef = LUA_NOREF;
 }
 
 #if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
@@ -3317,6 +3853,19 @@ TArray<FLuaValue> ULuaState::RunStringMulti(const FString & CodeString, FString
 	return ReturnValue;
 }
 
+FString ULuaState::GetErrorString(const int Status)
+{
+	// the VM only reports a generic memory error when LuaAlloc refuses to grow
+	const bool bMaxMemoryUsageError = Status == LUA_ERRMEM && bMaxMemoryUsageReached;
+	bMaxMemoryUsageReached = false;
+	if (bMaxMemoryUsageError)
+	{
+		return FString::Printf(TEXT("MaxMemoryUsage reached: %lld/%lld"), CurrentMemoryUsage - MemoryUsageBaseline, MaxMemoryUsage);
+	}
+
+	return ANSI_TO_TCHAR(lua_tostring(L, -1));
+}
+
 void ULuaState::Error(const FString & ErrorString)
 {
 	luaL_error(L, "%s", TCHAR_TO_UTF8(*ErrorString));
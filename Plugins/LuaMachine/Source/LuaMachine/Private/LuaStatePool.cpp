@@ -0,0 +1,366 @@
+// Copyright 2025 - Roberto De Ioris
+
+#include "LuaStatePool.h"
+#include "Async/Async.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Features/IModularFeatures.h"
+
+static bool IsPlainType(const ELuaValueType Type)
+{
+	return Type == ELuaValueType::Nil || Type == ELuaValueType::Bool || Type == ELuaValueType::Integer || Type == ELuaValueType::Number ||
+		Type == ELuaValueType::String || Type == ELuaValueType::Bytes;
+}
+
+bool FLuaPlainValue::FromLuaValue(const FLuaValue& LuaValue, FLuaPlainValue& OutValue, FString& OutError)
+{
+	if (IsPlainType(LuaValue.Type))
+	{
+		OutValue = FLuaPlainValue(LuaValue);
+		return true;
+	}
+
+	switch (LuaValue.Type)
+	{
+	case ELuaValueType::Table:
+	{
+		ULuaState* LuaState = LuaValue.LuaState.Get();
+		if (!LuaState)
+		{
+			OutError = TEXT("the Lua state of the table is gone");
+			return false;
+		}
+		FLuaValue Table = LuaValue;
+		LuaState->FromLuaValue(Table);
+		const bool bSuccess = FromStack(LuaState, -1, OutValue, OutError);
+		LuaState->Pop();
+		return bSuccess;
+	}
+	default:
+		break;
+	}
+
+	OutError = FString::Printf(TEXT("%s is not plain data"), *LuaValue.ToString());
+	return false;
+}
+
+bool FLuaPlainValue::FromStack(ULuaState* LuaState, int Index, FLuaPlainValue& OutValue, FString& OutError, const int32 Depth)
+{
+	TSet<const void*> Tables;
+	return FromStack(LuaState, Index, OutValue, OutError, Depth, Tables);
+}
+
+bool FLuaPlainValue::FromStack(ULuaState* LuaState, int Index, FLuaPlainValue& OutValue, FString& OutError, const int32 Depth, TSet<const void*>& Tables)
+{
+	lua_State* L = LuaState->GetInternalLuaState();
+	Index = lua_absindex(L, Index);
+
+	switch (lua_type(L, Index))
+	{
+	case LUA_TNIL:
+	case LUA_TBOOLEAN:
+	case LUA_TNUMBER:
+	case LUA_TSTRING:
+		OutValue = FLuaPlainValue(LuaState->ToLuaValue(Index));
+		return true;
+	case LUA_TTABLE:
+		break;
+	default:
+		OutError = FString::Printf(TEXT("%s values are not plain data"), ANSI_TO_TCHAR(lua_typename(L, lua_type(L, Index))));
+		return false;
+	}
+
+	if (Depth >= MaxDepth)
+	{
+		OutError = FString::Printf(TEXT("table nested deeper than %d levels"), MaxDepth);
+		return false;
+	}
+
+	// without this a table used as its own key (or value) is walked again at every level, doubling the work each time
+	const void* Table = lua_topointer(L, Index);
+	bool bAlreadyInSet = false;
+	Tables.Add(Table, &bAlreadyInSet);
+	if (bAlreadyInSet)
+	{
+		OutError = TEXT("recursive tables are not plain data");
+		return false;
+	}
+
+	OutValue = FLuaPlainValue();
+	OutValue.bTable = true;
+
+	lua_pushnil(L);
+	while (lua_next(L, Index))
+	{
+		FLuaPlainValue& Key = OutValue.Keys.AddDefaulted_GetRef();
+		FLuaPlainValue& Value = OutValue.Values.AddDefaulted_GetRef();
+		if (!FromStack(LuaState, -2, Key, OutError, Depth + 1, Tables) || !FromStack(LuaState, -1, Value, OutError, Depth + 1, Tables))
+		{
+			lua_pop(L, 2);
+			return false;
+		}
+		lua_pop(L, 1);
+	}
+
+	// a table shared by two branches is not a cycle, it is just copied twice
+	Tables.Remove(Table);
+	return true;
+}
+
+void FLuaPlainValue::Push(ULuaState* LuaState) const
+{
+	if (!bTable)
+	{
+		// a reference into another state (or a UObject) must never reach this one
+		FLuaValue Copy = IsPlainType(Value.Type) ? Value : FLuaValue();
+		LuaState->FromLuaValue(Copy);
+		return;
+	}
+
+	lua_State* L = LuaState->GetInternalLuaState();
+	lua_createtable(L, 0, Keys.Num());
+	for (int32 Index = 0; Index < Keys.Num(); Index++)
+	{
+		Keys[Index].Push(LuaState);
+		Values[Index].Push(LuaState);
+		lua_rawset(L, -3);
+	}
+}
+
+FLuaValue FLuaPlainValue::ToLuaValue(ULuaState* LuaState) const
+{
+	if (!bTable)
+	{
+		return Value;
+	}
+
+	Push(LuaState);
+	FLuaValue LuaValue = LuaState->ToLuaValue(-1);
+	LuaState->Pop();
+	return LuaValue;
+}
+
+TSharedPtr<FLuaStatePool, ESPMode::ThreadSafe> FLuaStatePool::Create(TSubclassOf<ULuaState> LuaStateClass, UWorld* InWorld, int32 NumStates)
+{
+	check(IsInGameThread());
+
+	if (!LuaStateClass || LuaStateClass == ULuaState::StaticClass())
+	{
+		UE_LOG(LogLuaMachine, Error, TEXT("a LuaState pool requires a child of LuaState"));
+		return nullptr;
+	}
+
+	if (NumStates <= 0)
+	{
+		NumStates = FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1);
+	}
+
+	TSharedPtr<FLuaStatePool, ESPMode::ThreadSafe> LuaStatePool = MakeShareable(new FLuaStatePool(), &FLuaStatePool::DestroyOnGameThread);
+
+	for (int32 StateIndex = 0; StateIndex < NumStates; StateIndex++)
+	{
+		ULuaState* NewLuaState = NewObject<ULuaState>((UObject*)GetTransientPackage(), LuaStateClass);
+		NewLuaState->bEnableLineHook = false;
+		NewLuaState->bEnableCallHook = false;
+		NewLuaState->bEnableReturnHook = false;
+		NewLuaState->bEnableCountHook = false;
+
+		if (!NewLuaState->GetLuaState(InWorld))
+		{
+			UE_LOG(LogLuaMachine, Error, TEXT("unable to create the LuaState %s for the pool"), *LuaStateClass->GetName());
+			return nullptr;
+		}
+
+		// the console would run commands on the game thread while a worker owns the state
+		IModularFeatures::Get().UnregisterModularFeature(IConsoleCommandExecutor::ModularFeatureName(), NewLuaState->GetLuaConsole());
+
+		LuaStatePool->LuaStates.Add(NewLuaState);
+		LuaStatePool->FreeLuaStates.Add(NewLuaState);
+	}
+
+	return LuaStatePool;
+}
+
+FLuaStatePool::~FLuaStatePool()
+{
+	// only left when the last reference went away before the task for these jobs started
+	FJob Job;
+	while (PendingJobs.Dequeue(Job))
+	{
+		FLuaStatePoolResult Result;
+		Result.Error = TEXT("the pool was destroyed");
+		Job.OnCompleted(MoveTemp(Result));
+	}
+}
+
+TFuture<FLuaStatePoolResult> FLuaStatePool::Call(const FString& FunctionName, TArray<FLuaPlainValue> Args)
+{
+	TSharedRef<TPromise<FLuaStatePoolResult>, ESPMode::ThreadSafe> Promise = MakeShared<TPromise<FLuaStatePoolResult>, ESPMode::ThreadSafe>();
+	TFuture<FLuaStatePoolResult> Future = Promise->GetFuture();
+
+	FJob Job;
+	Job.FunctionName = FunctionName;
+	Job.Args = MoveTemp(Args);
+	Job.OnCompleted = [Promise](FLuaStatePoolResult&& Result)
+	{
+		Promise->SetValue(MoveTemp(Result));
+	};
+	Enqueue(MoveTemp(Job));
+
+	return Future;
+}
+
+void FLuaStatePool::Call(const FString& FunctionName, TArray<FLuaPlainValue> Args, TFunction<void(const FLuaStatePoolResult&)> OnCompleted)
+{
+	FJob Job;
+	Job.FunctionName = FunctionName;
+	Job.Args = MoveTemp(Args);
+	Job.OnCompleted = [OnCompleted](FLuaStatePoolResult&& Result)
+	{
+		AsyncTask(ENamedThreads::GameThread, [OnCompleted, Result]()
+		{
+			OnCompleted(Result);
+		});
+	};
+	Enqueue(MoveTemp(Job));
+}
+
+void FLuaStatePool::Enqueue(FJob&& Job)
+{
+	ULuaState* LuaState = nullptr;
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (FreeLuaStates.Num() == 0)
+		{
+			PendingJobs.Enqueue(MoveTemp(Job));
+			return;
+		}
+		LuaState = FreeLuaStates.Pop();
+	}
+
+	// the task keeps the pool alive only while it runs, and drains the queue before giving the state back
+	TWeakPtr<FLuaStatePool, ESPMode::ThreadSafe> WeakLuaStatePool = AsShared();
+	AsyncTask(ENamedThreads::AnyThread, [WeakLuaStatePool, LuaState, Job = MoveTemp(Job)]() mutable
+	{
+		TSharedPtr<FLuaStatePool, ESPMode::ThreadSafe> LuaStatePool = WeakLuaStatePool.Pin();
+		if (!LuaStatePool.IsValid())
+		{
+			FLuaStatePoolResult Result;
+			Result.Error = TEXT("the pool was destroyed");
+			Job.OnCompleted(MoveTemp(Result));
+			return;
+		}
+
+		for (;;)
+		{
+			Job.OnCompleted(RunJob(LuaState, Job));
+
+			FScopeLock ScopeLock(&LuaStatePool->Lock);
+			if (!LuaStatePool->PendingJobs.Dequeue(Job))
+			{
+				LuaStatePool->FreeLuaStates.Add(LuaState);
+				return;
+			}
+		}
+	});
+}
+
+void FLuaStatePool::DestroyOnGameThread(FLuaStatePool* LuaStatePool)
+{
+	if (IsInGameThread())
+	{
+		delete LuaStatePool;
+		return;
+	}
+
+	AsyncTask(ENamedThreads::GameThread, [LuaStatePool]()
+	{
+		delete LuaStatePool;
+	});
+}
+
+FLuaStatePoolResult FLuaStatePool::RunJob(ULuaState* LuaState, const FJob& Job)
+{
+	FLuaStatePoolResult Result;
+
+	lua_State* L = LuaState->GetInternalLuaState();
+	const int32 Top = LuaState->GetTop();
+
+	// walked by hand, GetFieldFromTree reports missing keys to Blueprints
+	TArray<FString> Parts;
+	Job.FunctionName.ParseIntoArray(Parts, TEXT("."));
+	LuaState->PushGlobalTable();
+	for (const FString& Part : Parts)
+	{
+		if (!lua_istable(L, -1))
+		{
+			break;
+		}
+		lua_getfield(L, -1, TCHAR_TO_UTF8(*Part));
+		lua_remove(L, -2);
+	}
+
+	if (Parts.Num() == 0 || !lua_isfunction(L, -1))
+	{
+		Result.Error = FString::Printf(TEXT("\"%s\" is not a Lua function"), *Job.FunctionName);
+		LuaState->Pop(LuaState->GetTop() - Top);
+		return Result;
+	}
+
+	for (const FLuaPlainValue& Arg : Job.Args)
+	{
+		Arg.Push(LuaState);
+	}
+
+	FLuaValue Unused;
+	if (!LuaState->Call(Job.Args.Num(), Unused, LUA_MULTRET))
+	{
+		Result.Error = LuaState->LastError;
+		LuaState->Pop(LuaState->GetTop() - Top);
+		return Result;
+	}
+
+	Result.bSuccess = true;
+	for (int32 Index = Top + 1; Index <= LuaState->GetTop(); Index++)
+	{
+		if (!FLuaPlainValue::FromStack(LuaState, Index, Result.Values.AddDefaulted_GetRef(), Result.Error))
+		{
+			Result.bSuccess = false;
+			Result.Values.Empty();
+			break;
+		}
+	}
+
+	LuaState->Pop(LuaState->GetTop() - Top);
+	return Result;
+}
+
+bool FLuaStatePool::RunCode(const FString& Code, const FString& CodePath, FString& OutError)
+{
+	check(IsInGameThread());
+
+	FScopeLock ScopeLock(&Lock);
+	if (FreeLuaStates.Num() != LuaStates.Num())
+	{
+		OutError = TEXT("the pool is busy");
+		return false;
+	}
+
+	for (ULuaState* LuaState : LuaStates)
+	{
+		const int32 Top = LuaState->GetTop();
+		const bool bSuccess = LuaState->RunCode(Code, CodePath);
+		LuaState->Pop(LuaState->GetTop() - Top);
+		if (!bSuccess)
+		{
+			OutError = LuaState->LastError;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FLuaStatePool::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObjects(LuaStates);
+}
@@ -28,6 +28,11 @@ FString FLuaValue::ToString() const
 		return FString::Printf(TEXT("thread: %d"), LuaRef);
 	case ELuaValueType::Lambda:
 		return FString(TEXT("lambda"));
+	case ELuaValueType::Bytes:
+	{
+		TArrayView<const uint8> Bytes = GetBytesView();
+		return FLuaValue((const char*)Bytes.GetData(), Bytes.Num()).String;
+	}
 	}
 	return FString(TEXT("nil"));
 }
@@ -49,6 +54,8 @@ int64 FLuaValue::ToInteger() const
 		return Number;
 	case ELuaValueType::String:
 		return FCString::Atoi(*String);
+	case ELuaValueType::Bytes:
+		return FCString::Atoi(*ToString());
 	}
 	return 0;
 }
@@ -65,6 +72,8 @@ double FLuaValue::ToFloat() const
 		return Number;
 	case ELuaValueType::String:
 		return FCString::Atod(*String);
+	case ELuaValueType::Bytes:
+		return FCString::Atod(*ToString());
 	}
 	return 0.0;
 }
@@ -136,6 +145,14 @@ FLuaValue FLuaValue::NewLambda(TFunction<FLuaValueOrError(TArray<FLuaValue>)> In
 	return FLuaValue(InLambda);
 }
 
+FLuaValue FLuaValue::NewBytes(TArray<uint8> InBytes)
+{
+	FLuaValue LuaValue;
+	LuaValue.Type = ELuaValueType::Bytes;
+	LuaValue.ByteBuffer = MakeShared<const TArray<uint8>, ESPMode::ThreadSafe>(MoveTemp(InBytes));
+	return LuaValue;
+}
+
 FLuaValue::FLuaValue(const FLuaValue& SourceValue)
 {
 	Type = SourceValue.Type;
@@ -149,6 +166,7 @@ FLuaValue::FLuaValue(const FLuaValue& SourceValue)
 	FunctionName = SourceValue.FunctionName;
 	MulticastScriptDelegate = SourceValue.MulticastScriptDelegate;
 	Lambda = SourceValue.Lambda;
+	ByteBuffer = SourceValue.ByteBuffer;
 
 	// make a new reference to the table, to avoid it being destroyed
 	if (LuaRef != LUA_NOREF)
@@ -171,6 +189,7 @@ FLuaValue& FLuaValue::operator = (const FLuaValue& SourceValue)
 	FunctionName = SourceValue.FunctionName;
 	MulticastScriptDelegate = SourceValue.MulticastScriptDelegate;
 	Lambda = SourceValue.Lambda;
+	ByteBuffer = SourceValue.ByteBuffer;
 
 	// make a new reference to the table, to avoid it being destroyed
 	if (LuaRef != LUA_NOREF)
@@ -352,6 +371,8 @@ TSharedPtr<FJsonValue> FLuaValue::ToJsonValue()
 		return MakeShared<FJsonValueNumber>(Number);
 	case ELuaValueType::String:
 		return MakeShared<FJsonValueString>(String);
+	case ELuaValueType::Bytes:
+		return MakeShared<FJsonValueString>(ToString());
 	case ELuaValueType::UFunction:
 		return MakeShared<FJsonValueString>(FunctionName.ToString());
 	case ELuaValueType::UObject:
@@ -412,6 +433,11 @@ TSharedPtr<FJsonValue> FLuaValue::ToJsonValue()
 
 TArray<uint8> FLuaValue::ToBytes() const
 {
+	if (Type == ELuaValueType::Bytes)
+	{
+		return TArray<uint8>(GetBytesView());
+	}
+
 	TArray<uint8> Bytes;
 	if (Type != ELuaValueType::String)
 	{
@@ -436,6 +462,16 @@ TArray<uint8> FLuaValue::ToBytes() const
 	return Bytes;
 }
 
+TArrayView<const uint8> FLuaValue::GetBytesView() const
+{
+	if (Type != ELuaValueType::Bytes || !ByteBuffer.IsValid())
+	{
+		return TArrayView<const uint8>();
+	}
+
+	return TArrayView<const uint8>(*ByteBuffer);
+}
+
 FLuaValue FLuaValue::FromBase64(const FString& Base64)
 {
 	TArray<uint8> Bytes;
@@ -223,6 +223,12 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Lua")
 	static FString LuaValueToUTF16(const FLuaValue& Value);
 
+	UFUNCTION(BlueprintCallable, Category = "Lua")
+	static FLuaValue LuaValueFromBytes(const TArray<uint8>& Bytes);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Lua")
+	static TArray<uint8> LuaValueToBytes(const FLuaValue& Value);
+
 	UFUNCTION(BlueprintCallable, Category = "Lua")
 	static FLuaValue LuaValueFromUTF8(const FString& String);
 
@@ -340,6 +346,9 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Lua")
 	static bool LuaValueIsString(const FLuaValue& Value);
 
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Lua")
+	static bool LuaValueIsBytes(const FLuaValue& Value);
+
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Lua")
 	static bool LuaValueIsFunction(const FLuaValue& Value);
 
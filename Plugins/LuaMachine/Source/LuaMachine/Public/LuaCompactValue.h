@@ -0,0 +1,127 @@
+// Copyright 2025 - Roberto De Ioris
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LuaValue.h"
+
+/**
+ * 16 bytes counterpart of FLuaValue for marshaling values between Lua and C++.
+ * Nil, bools, numbers and UObjects are stored inline, strings and Bytes values are kept as their raw Lua bytes in a shared buffer
+ * and everything holding a Lua reference or a callable (tables, functions, threads, UFunctions, lambdas, delegates)
+ * is boxed in a shared FLuaValue. Copies only bump a reference count.
+ * It is not a UPROPERTY type and does not keep UObjects alive, so do not store it beyond the call it was created for.
+ */
+struct LUAMACHINE_API FLuaCompactValue
+{
+	FLuaCompactValue() : Integer(0), Type(ELuaValueType::Nil)
+	{
+	}
+
+	FLuaCompactValue(const bool bInBool) : FLuaCompactValue()
+	{
+		Type = ELuaValueType::Bool;
+		Bool = bInBool;
+	}
+
+	FLuaCompactValue(const int32 Value) : FLuaCompactValue((int64)Value)
+	{
+	}
+
+	FLuaCompactValue(const int64 Value) : FLuaCompactValue()
+	{
+		Type = ELuaValueType::Integer;
+		Integer = Value;
+	}
+
+	FLuaCompactValue(const double Value) : FLuaCompactValue()
+	{
+		Type = ELuaValueType::Number;
+		Number = Value;
+	}
+
+	FLuaCompactValue(const float Value) : FLuaCompactValue((double)Value)
+	{
+	}
+
+	FLuaCompactValue(UObject* InObject) : FLuaCompactValue()
+	{
+		if (InObject)
+		{
+			Type = ELuaValueType::UObject;
+			Object = InObject;
+		}
+	}
+
+	FLuaCompactValue(const FString& InString);
+	FLuaCompactValue(const char* InChars);
+
+	explicit FLuaCompactValue(const FLuaValue& LuaValue);
+
+	FLuaCompactValue(const FLuaCompactValue& SourceValue);
+	FLuaCompactValue(FLuaCompactValue&& SourceValue);
+	FLuaCompactValue& operator = (const FLuaCompactValue& SourceValue);
+	FLuaCompactValue& operator = (FLuaCompactValue&& SourceValue);
+
+	~FLuaCompactValue()
+	{
+		Release();
+	}
+
+	/* Makes a string value from raw bytes, as returned by lua_tolstring. InType is String or Bytes and is what ToLuaValue gives back */
+	static FLuaCompactValue FromBytes(const char* InBytes, const int32 Length, const ELuaValueType InType = ELuaValueType::String);
+
+	ELuaValueType GetType() const { return Type; }
+	bool IsNil() const { return Type == ELuaValueType::Nil; }
+
+	/* Same conversions of the FLuaValue methods with the same name */
+	bool ToBool() const;
+	int64 ToInteger() const;
+	double ToFloat() const;
+	FString ToString() const;
+
+	UObject* GetObject() const { return Type == ELuaValueType::UObject ? Object : nullptr; }
+
+	/* Raw bytes of a String or Bytes value, nullptr/0 for any other type. The data is always followed by a 0 */
+	const char* GetStringData() const;
+	int32 GetStringLength() const;
+
+	/* The boxed value of tables, functions, threads and callables, nullptr for the types stored inline */
+	FLuaValue* GetBoxedLuaValue() const;
+
+	FLuaValue ToLuaValue() const;
+
+	/* Bytes allocated out of line for this value (shared between copies) */
+	int32 GetAllocatedSize() const;
+
+private:
+	struct FStringBuffer;
+	struct FLuaValueBox;
+
+	bool IsStoredInline() const
+	{
+		return Type == ELuaValueType::Nil || Type == ELuaValueType::Bool || Type == ELuaValueType::Integer || Type == ELuaValueType::Number || Type == ELuaValueType::UObject;
+	}
+
+	bool HasStringBuffer() const
+	{
+		return Type == ELuaValueType::String || Type == ELuaValueType::Bytes;
+	}
+
+	void AddRef();
+	void Release();
+
+	union
+	{
+		bool Bool;
+		int64 Integer;
+		double Number;
+		UObject* Object;
+		FStringBuffer* StringBuffer;
+		FLuaValueBox* Box;
+	};
+
+	ELuaValueType Type;
+};
+
+static_assert(sizeof(FLuaCompactValue) == 16, "FLuaCompactValue is expected to be 16 bytes");
@@ -0,0 +1,63 @@
+// Copyright 2025 - Roberto De Ioris
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Allocator behind the lua_Alloc of a ULuaState.
+ * Small blocks (strings, tables, closures, upvalues...) are carved out of pages and recycled through per size class free lists,
+ * everything bigger goes straight to FMalloc. Lua always passes the old size of a block, so blocks do not need any header.
+ * Pages are only given back when the pool is emptied (on lua_close), and the pool is not thread safe as a lua_State is not either.
+ */
+struct LUAMACHINE_API FLuaMemoryPool
+{
+	static constexpr int32 Granularity = 16;
+	static constexpr int32 MaxPooledSize = 256;
+	static constexpr int32 NumSizeClasses = MaxPooledSize / Granularity;
+	static constexpr int32 PageSize = 64 * 1024;
+
+	FLuaMemoryPool() = default;
+	FLuaMemoryPool(const FLuaMemoryPool&) = delete;
+	FLuaMemoryPool& operator=(const FLuaMemoryPool&) = delete;
+
+	~FLuaMemoryPool()
+	{
+		Empty();
+	}
+
+	/* lua_Alloc semantics: frees when NewSize is 0, allocates when Ptr is null (OldSize must be 0 then) */
+	void* Realloc(void* Ptr, size_t OldSize, size_t NewSize);
+
+	/* Frees all of the pages, every pooled block must be dead by now */
+	void Empty();
+
+	/* When disabled every block goes to FMalloc, only change it while the pool is empty */
+	void SetPoolingEnabled(const bool bEnabled);
+
+	/* Bytes held in pages, used or not */
+	int64 GetReservedSize() const
+	{
+		return (int64)Pages.Num() * PageSize;
+	}
+
+private:
+	struct FFreeBlock
+	{
+		FFreeBlock* Next;
+	};
+
+	int32 GetSizeClass(size_t Size) const
+	{
+		return bPoolingEnabled && Size <= MaxPooledSize ? (int32)((Size + Granularity - 1) / Granularity) - 1 : INDEX_NONE;
+	}
+
+	void* AllocateBlock(const int32 SizeClass);
+	void FreeBlock(void* Ptr, const int32 SizeClass);
+
+	FFreeBlock* FreeLists[NumSizeClasses] = {};
+	TArray<void*> Pages;
+	uint8* PageCursor = nullptr;
+	uint8* PageEnd = nullptr;
+	bool bPoolingEnabled = true;
+};
@@ -6,6 +6,8 @@
 #include "Engine/Blueprint.h"
 #include "LuaVMIncludes.h"
 #include "LuaValue.h"
+#include "LuaCompactValue.h"
+#include "LuaMemoryPool.h"
 #include "LuaCode.h"
 #include "Runtime/Core/Public/Containers/Queue.h"
 #include "Runtime/Launch/Resources/Version.h"
@@ -226,6 +228,52 @@ struct FLuaSmartReference : public TSharedFromThis<FLuaSmartReference>
 };
 
 
+enum class ELuaCallParamKind : uint8
+{
+	LuaValue,
+	LuaValueArray,
+	Bool,
+	Integer,
+	Float,
+	Double,
+	Object,
+	Generic,
+};
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
+typedef FProperty FLuaCallProperty;
+#else
+typedef UProperty FLuaCallProperty;
+#endif
+
+struct FLuaCallParam
+{
+	FLuaCallProperty* Property;
+	int32 Offset;
+	ELuaCallParamKind Kind;
+};
+
+/**
+ * Result of walking the properties of a UFunction once, so calling it from Lua does not need to iterate and cast them again
+ */
+struct FLuaFunctionCallPlan
+{
+	TWeakObjectPtr<UFunction> Function;
+	int32 ParmsSize;
+
+	/* Parameters that need InitializeValue/DestroyValue, the others are valid zeroed and have no destructor */
+	TArray<FLuaCallProperty*> ConstructedParams;
+	TArray<FLuaCallProperty*> DestructedParams;
+
+	/* Arguments and return values as seen by __call, ending at the first one that is not a FLuaValue or an array of them */
+	TArray<FLuaCallParam> LuaValueArgs;
+	TArray<FLuaCallParam> LuaValueReturns;
+
+	/* Arguments and return values as seen by __rawcall, with the kind telling how they are read from and pushed to the Lua stack */
+	TArray<FLuaCallParam> RawArgs;
+	TArray<FLuaCallParam> RawReturns;
+};
+
 class ULuaUserDataObject;
 
 UCLASS(Abstract, Blueprintable, HideDropdown)
@@ -331,6 +379,10 @@ public:
 	void FromLuaValue(FLuaValue& LuaValue, UObject* CallContext = nullptr, lua_State* State = nullptr);
 	FLuaValue ToLuaValue(int Index, lua_State* State = nullptr);
 
+	/* FLuaCompactValue versions of FromLuaValue/ToLuaValue: strings are copied as raw bytes and bools, numbers and UObjects never allocate */
+	void FromLuaCompactValue(const FLuaCompactValue& LuaValue, UObject* CallContext = nullptr, lua_State* State = nullptr);
+	FLuaCompactValue ToLuaCompactValue(int Index, lua_State* State = nullptr);
+
 	ELuaThreadStatus GetLuaThreadStatus(FLuaValue Value);
 	int32 GetLuaThreadStackTop(FLuaValue Value);
 
@@ -457,6 +509,12 @@ public:
 
 	bool RunFile(const FString& Filename, bool bIgnoreNonExistent, int NRet = 0, bool bNonContentDirectory = false);
 
+	/* Where RunFile stores the bytecode of the files it loads when bCacheByteCode is enabled */
+	static FString GetByteCodeCacheDirectory();
+
+	UFUNCTION(BlueprintCallable, Category = "Lua")
+	static void ClearByteCodeCache();
+
 	static int MetaTableFunctionUserData__index(lua_State* L);
 	static int MetaTableFunctionUserData__newindex(lua_State* L);
 
@@ -480,9 +538,17 @@ public:
 
 	static int ToByteCode_Writer(lua_State* L, const void* Ptr, size_t Size, void* UserData);
 
-	static void OnAllocateCallback(lua_State* L, size_t OSize, size_t NSize);
+	static void* LuaAlloc(void* UserData, void* Ptr, size_t OSize, size_t NSize);
 	static void OnInterrupt(lua_State* L, int gc);
 
+#if LUAMACHINE_LUA53 || LUAMACHINE_LUAJIT
+	static int OnPanic(lua_State* L);
+
+	/* Used by the pcall, xpcall and coroutine.resume wrappers installed in GetLuaState, see FNativeCallScope */
+	static int OnProtectedCallEnter(lua_State* L);
+	static int OnProtectedCallLeave(lua_State* L);
+#endif
+
 	static void OnProfile(lua_State* L, int gc);
 
 	static void Debug_Hook(lua_State* L, lua_Debug* ar);
@@ -506,6 +572,15 @@ public:
 	void ToProperty(void* Buffer, UProperty* Property, FLuaValue Value, bool& bSuccess, int32 Index = 0);
 #endif
 
+	/* Returns the cached call plan of a UFunction, building it on first use or when the UFunction it was built for is gone */
+	const FLuaFunctionCallPlan& GetFunctionCallPlan(UFunction* Function);
+
+	/* Stores the Lua value at Index in the parameter, without going through a FLuaValue for bools, numbers and objects */
+	void ToCallParam(void* Parameters, const FLuaCallParam& Param, int Index, lua_State* State);
+
+	/* Pushes the parameter on the Lua stack, without going through a FLuaValue for bools and numbers */
+	void FromCallParam(void* Parameters, const FLuaCallParam& Param, lua_State* State);
+
 	static ULuaState* GetFromExtraSpace(lua_State* L)
 	{
 		ULuaState** LuaExtraSpacePtr = (ULuaState**)lua_getextraspace(L);
@@ -544,6 +619,25 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Lua")
 	bool bRawLuaFunctionCall;
 
+	/* Cache the conversion of the string keys used on LuaComponent and LuaUserDataObject fields, so repeated field accesses do not allocate and hash a new FString */
+	UPROPERTY(EditAnywhere, Category = "Lua")
+	bool bInternUserDataKeys;
+
+	struct FLuaInternedKey
+	{
+		FString Key;
+		uint32 KeyHash;
+	};
+
+	/* Returns the FString and its TMap hash for the key at Index, from the interned key cache when possible. UncachedKey is filled and returned for keys that cannot be cached */
+	const FLuaInternedKey& GetInternedKey(lua_State* State, int Index, FLuaInternedKey& UncachedKey);
+
+	/* Keys longer than this are not cached, Lua 5.3 only interns short strings so their address is not unique */
+	static constexpr size_t MaxInternedKeyLength = 40;
+
+	/* Upper bound of cached keys, to not grow forever with scripts generating keys at runtime */
+	static constexpr int32 MaxInternedKeys = 4096;
+
 	void GCLuaDelegatesCheck();
 
 	void RegisterLuaDelegate(UObject* InObject, ULuaDelegate* InLuaDelegate);
@@ -619,9 +713,23 @@ public:
 		return Cast<T>(NewLuaState->GetLuaState(InWorld));
 	}
 
+	/* Bytes the scripts can allocate on top of what the state used once initialized, 0 means no limit */
 	UPROPERTY(EditAnywhere, Category = "Lua")
 	int64 MaxMemoryUsage = 0;
 
+	/* Serve small Lua allocations from per state size class pools instead of going to FMalloc for each of them (Lua 5.3 and LuaJIT, Luau pools them itself) */
+	UPROPERTY(EditAnywhere, Category = "Lua")
+	bool bPoolLuaAllocations;
+
+	/* Keep the bytecode of the files loaded by RunFile (and require) in GetByteCodeCacheDirectory(), one entry per path and VM version that is overwritten when the source changes.
+	   The VM does not verify bytecode, so enable it only if the Saved directory is as trusted as the scripts themselves */
+	UPROPERTY(EditAnywhere, Category = "Lua")
+	bool bCacheByteCode;
+
+	/* Lua strings of at least this many bytes are converted to Bytes values (raw binary data) instead of String ones, 0 disables it */
+	UPROPERTY(EditAnywhere, Category = "Lua")
+	int32 BytesValueMinLength = 0;
+
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Lua")
 	int64 GetMemoryUsage() const { return CurrentMemoryUsage; }
 
@@ -693,12 +801,68 @@ protected:
 
 	FLuaCommandExecutor LuaConsole;
 
-	int64 CurrentMemoryUsage;
+	/* Returns the error at the top of the stack, or the MaxMemoryUsage one if LuaAlloc refused an allocation */
+	FString GetErrorString(const int Status);
+
+	/* Pushes the chunk compiled from Code (source or, with bByteCode, the VM bytecode) */
+	bool LoadCode(const TArray<uint8>& Code, const FString& CodePath, const bool bByteCode = false);
+
+	/* Like LoadCode, but goes through the bytecode cache */
+	bool LoadCachedCode(const TArray<uint8>& Code, const FString& CodePath);
+
+	/* Runs the chunk pushed by LoadCode */
+	bool RunLoadedCode(int NRet);
+
+	int64 CurrentMemoryUsage = 0;
+
+	/* CurrentMemoryUsage at the end of the state initialization, MaxMemoryUsage is enforced only from there (-1 until then) */
+	int64 MemoryUsageBaseline = -1;
+	bool bMaxMemoryUsageReached = false;
+
+	/* LuaAlloc refuses allocations only here, where the memory error is caught instead of reaching the panic handler. Reset to 0 while a C++ function called from Lua runs */
+	int32 ProtectedCallDepth = 0;
+
+	/*
+	 * Put at the start of C++ functions called from Lua. A refused allocation would longjmp over their destructors,
+	 * so the limit is lifted until they return and only applies again to the Lua code that runs after them (or that they call).
+	 * A Lua error raised in the function skips the restore, the protected call that catches it puts back the depth it started with:
+	 * the C++ ones (RunLoadedCode, PCall, resume) save it themselves, the script ones (pcall, xpcall, coroutine.resume) are wrapped for it
+	 */
+	struct FNativeCallScope
+	{
+		FNativeCallScope(ULuaState* InLuaState) : LuaState(InLuaState), SavedProtectedCallDepth(InLuaState ? InLuaState->ProtectedCallDepth : 0)
+		{
+			if (LuaState)
+			{
+				LuaState->ProtectedCallDepth = 0;
+			}
+		}
+
+		~FNativeCallScope()
+		{
+			if (LuaState)
+			{
+				LuaState->ProtectedCallDepth = SavedProtectedCallDepth;
+			}
+		}
+
+		ULuaState* LuaState;
+		int32 SavedProtectedCallDepth;
+	};
+
+	FLuaMemoryPool MemoryPool;
 
 	TMap<FLuaProfiledStack, FLuaProfiledData> CurrentProfiledStacks;
 
 	void (*PreviousOnInterrupt)(lua_State* L, int gc) = nullptr;
 
+	/* Lua string address to converted key, the strings are anchored in the InternedKeysRef registry table so an address is never reused while cached */
+	TMap<const void*, FLuaInternedKey> InternedKeys;
+	int InternedKeysRef = LUA_NOREF;
+
+	/* Plans are heap allocated so a reference stays valid when ProcessEvent re-enters Lua and more plans are added */
+	TMap<const UFunction*, TUniquePtr<FLuaFunctionCallPlan>> FunctionCallPlans;
+
 	double ProfilerFrequency = 0;
 	double LastProfilerRealTimeSeconds = 0;
 	int64 ProfilerSamples = 0;
@@ -711,6 +875,7 @@ protected:
 #define LUACFUNCTION(FuncClass, FuncName, NumRetValues, NumArgs) static int FuncName ## _C(lua_State* L)\
 {\
 	FuncClass* LuaState = (FuncClass*)ULuaState::GetFromExtraSpace(L);\
+	ULuaState::FNativeCallScope NativeCallScope(LuaState);\
 	int TrueNumArgs = lua_gettop(L);\
 	if (TrueNumArgs != NumArgs)\
 	{\
@@ -736,4 +901,31 @@ protected:
 	}\
 	return NumRetValues;\
 }\
-TArray<FLuaValue> FuncName(TArray<FLuaValue> LuaArgs)
\ No newline at end of file
+TArray<FLuaValue> FuncName(TArray<FLuaValue> LuaArgs)
+
+// same as LUACFUNCTION but marshaling through FLuaCompactValue, arguments and return values live in inline arrays so a call does not allocate
+// for bools, numbers and UObjects. RetValues has NumRetValues nil values to be filled.
+#define LUACFUNCTION_COMPACT(FuncClass, FuncName, NumRetValues, NumArgs) static int FuncName ## _C(lua_State* L)\
+{\
+	FuncClass* LuaState = (FuncClass*)ULuaState::GetFromExtraSpace(L);\
+	ULuaState::FNativeCallScope NativeCallScope(LuaState);\
+	int TrueNumArgs = lua_gettop(L);\
+	if (TrueNumArgs != NumArgs)\
+	{\
+		return luaL_error(L, "invalid number of arguments for %s (got %d, expected %d)", #FuncName, TrueNumArgs, NumArgs);\
+	}\
+	TArray<FLuaCompactValue, TInlineAllocator<NumArgs + 1>> LuaArgs;\
+	for (int32 LuaArgIndex = 0; LuaArgIndex < NumArgs; LuaArgIndex++)\
+	{\
+		LuaArgs.Add(LuaState->ToLuaCompactValue(LuaArgIndex + 1, L));\
+	}\
+	TArray<FLuaCompactValue, TInlineAllocator<NumRetValues + 1>> RetValues;\
+	RetValues.SetNum(NumRetValues);\
+	LuaState->FuncName(LuaArgs, RetValues);\
+	for (int32 RetIndex = 0; RetIndex < NumRetValues; RetIndex++)\
+	{\
+		LuaState->FromLuaCompactValue(RetValues[RetIndex], nullptr, L);\
+	}\
+	return NumRetValues;\
+}\
+void FuncName(TArrayView<const FLuaCompactValue> LuaArgs, TArrayView<FLuaCompactValue> RetValues)
\ No newline at end of file
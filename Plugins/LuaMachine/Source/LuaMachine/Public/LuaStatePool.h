@@ -0,0 +1,124 @@
+// Copyright 2025 - Roberto De Ioris
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "Async/Future.h"
+#include "Containers/Queue.h"
+#include "LuaState.h"
+
+/**
+ * Copy of a Lua value that does not belong to any state, so it can move between threads and pooled states.
+ * Nil, bools, numbers, strings and bytes are kept in Value, tables are copied deeply into Keys and Values.
+ * Functions, threads, userdata, UObjects and delegates can not be represented.
+ */
+struct LUAMACHINE_API FLuaPlainValue
+{
+	FLuaValue Value;
+	bool bTable = false;
+	TArray<FLuaPlainValue> Keys;
+	TArray<FLuaPlainValue> Values;
+
+	/* Tables nested deeper than this are refused, as are tables that contain themselves */
+	static constexpr int32 MaxDepth = 32;
+
+	FLuaPlainValue() = default;
+
+	/* Only for values that are not tables, use FromLuaValue for those */
+	FLuaPlainValue(const FLuaValue& InValue) : Value(InValue)
+	{
+	}
+
+	/* Copies LuaValue (walking tables in the state owning them), returns false and sets OutError if it holds something that is not plain data */
+	static bool FromLuaValue(const FLuaValue& LuaValue, FLuaPlainValue& OutValue, FString& OutError);
+
+	/* Same as FromLuaValue for the value at Index of the LuaState stack */
+	static bool FromStack(ULuaState* LuaState, int Index, FLuaPlainValue& OutValue, FString& OutError, const int32 Depth = 0);
+
+	/* Pushes the value (building its tables) on the LuaState stack */
+	void Push(ULuaState* LuaState) const;
+
+	/* Builds the value in LuaState */
+	FLuaValue ToLuaValue(ULuaState* LuaState) const;
+
+private:
+	/* Tables holds the tables being copied from the root down to Index (by lua_topointer), seeing one again means a cycle */
+	static bool FromStack(ULuaState* LuaState, int Index, FLuaPlainValue& OutValue, FString& OutError, const int32 Depth, TSet<const void*>& Tables);
+};
+
+struct LUAMACHINE_API FLuaStatePoolResult
+{
+	bool bSuccess = false;
+	FString Error;
+	TArray<FLuaPlainValue> Values;
+};
+
+/**
+ * Independent instances of a ULuaState class for running pure data scripts (procedural generation, AI scoring, loot tables...)
+ * on task graph workers, in parallel with the game thread and with each other.
+ * The states are created on the game thread exactly like FLuaMachineModule creates its own, so each one gets the class Table,
+ * RequireTable, libs and code. Only the Lua console registration and the debug hooks are skipped, as they would be driven from
+ * the game thread (or call Blueprints) while a worker owns the state.
+ * A state is owned by one job at a time, jobs beyond the number of states are queued and picked up by the first state done.
+ * Arguments and results are plain values. Scripts running in a pool can not touch UObjects: calling a UFunction or delegate
+ * (FLuaValue::Function globals and LuaBlueprintPackages included) or reading a UObject field raises a Lua error off the game thread.
+ */
+class LUAMACHINE_API FLuaStatePool : public FGCObject, public TSharedFromThis<FLuaStatePool, ESPMode::ThreadSafe>
+{
+public:
+	/* Jobs still queued are completed with an error */
+	virtual ~FLuaStatePool();
+
+	/* Game thread only. NumStates <= 0 creates one state per task graph worker */
+	static TSharedPtr<FLuaStatePool, ESPMode::ThreadSafe> Create(TSubclassOf<ULuaState> LuaStateClass, UWorld* InWorld, int32 NumStates = 0);
+
+	/* Calls the function at FunctionName (a global or a dotted path like "loot.roll") with Args on a task graph worker */
+	TFuture<FLuaStatePoolResult> Call(const FString& FunctionName, TArray<FLuaPlainValue> Args);
+
+	/* Same as the TFuture version, OnCompleted runs on the game thread */
+	void Call(const FString& FunctionName, TArray<FLuaPlainValue> Args, TFunction<void(const FLuaStatePoolResult&)> OnCompleted);
+
+	/* Runs Code on every state, for loading modules or data after creation. Game thread only, fails if any job is queued or running */
+	bool RunCode(const FString& Code, const FString& CodePath, FString& OutError);
+
+	int32 Num() const
+	{
+		return LuaStates.Num();
+	}
+
+	void AddReferencedObjects(FReferenceCollector& Collector) override;
+
+#if ENGINE_MAJOR_VERSION > 4
+	virtual FString GetReferencerName() const override
+	{
+		return TEXT("FLuaStatePool");
+	}
+#endif
+
+private:
+	struct FJob
+	{
+		FString FunctionName;
+		TArray<FLuaPlainValue> Args;
+		TFunction<void(FLuaStatePoolResult&&)> OnCompleted;
+	};
+
+	void Enqueue(FJob&& Job);
+
+	/* The pool is a GC object, it has to be destroyed on the game thread even when a worker drops the last reference */
+	static void DestroyOnGameThread(FLuaStatePool* LuaStatePool);
+
+	static FLuaStatePoolResult RunJob(ULuaState* LuaState, const FJob& Job);
+
+#if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 4
+	TArray<TObjectPtr<ULuaState>> LuaStates;
+#else
+	TArray<ULuaState*> LuaStates;
+#endif
+
+	/* Both guarded by Lock, a state is either free or owned by exactly one worker */
+	TArray<ULuaState*> FreeLuaStates;
+	TQueue<FJob> PendingJobs;
+	FCriticalSection Lock;
+};
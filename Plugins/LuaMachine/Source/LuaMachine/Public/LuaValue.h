@@ -32,6 +32,7 @@ enum class ELuaValueType : uint8
 	Thread,
 	MulticastDelegate,
 	Lambda,
+	Bytes,
 };
 
 class ULuaState;
@@ -155,6 +156,9 @@ struct LUAMACHINE_API FLuaValue
 
 	static FLuaValue NewLambda(TFunction<FLuaValueOrError(TArray<FLuaValue>)> InLambda);
 
+	/* Binary data pushed to Lua as a string without going through the FString representation, copies of the value share the buffer */
+	static FLuaValue NewBytes(TArray<uint8> InBytes);
+
 	FString ToString() const;
 	FName ToName() const;
 	int64 ToInteger() const;
@@ -163,6 +167,9 @@ struct LUAMACHINE_API FLuaValue
 
 	TArray<uint8> ToBytes() const;
 
+	/* The data of a Bytes value, without copying it. Empty for any other type, and for a Bytes value without a buffer (Type set from the editor or Blueprints) */
+	TArrayView<const uint8> GetBytesView() const;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lua")
 	ELuaValueType Type;
 
@@ -212,6 +219,7 @@ struct LUAMACHINE_API FLuaValue
 
 	FMulticastScriptDelegate* MulticastScriptDelegate = nullptr;
 	TSharedPtr<TFunction<FLuaValueOrError(TArray<FLuaValue>)>> Lambda = nullptr;
+	TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> ByteBuffer = nullptr;
 };
 
 struct FLuaValueOrError
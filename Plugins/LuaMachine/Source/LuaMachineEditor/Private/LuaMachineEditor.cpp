@@ -294,6 +294,7 @@ class SLuaMachineDebugger : public SCompoundWidget, public FGCObject
 		case ELuaValueType::Integer:
 			return FSlateColor(FColor::Red);
 		case ELuaValueType::String:
+		case ELuaValueType::Bytes:
 			return FSlateColor(FColor::Orange);
 		case ELuaValueType::Bool:
 			return FSlateColor(FColor::Purple);
@@ -316,6 +317,9 @@ class SLuaMachineDebugger : public SCompoundWidget, public FGCObject
 		case ELuaValueType::String:
 			Value = "string";
 			break;
+		case ELuaValueType::Bytes:
+			Value = "bytes";
+			break;
 		case ELuaValueType::Bool:
 			Value = "boolean";
 			break;
@@ -360,6 +364,9 @@ class SLuaMachineDebugger : public SCompoundWidget, public FGCObject
 		case ELuaValueType::UObject:
 			Value = Item->LuaTableValue.ToString();
 			break;
+		case ELuaValueType::Bytes:
+			Value = FString::Printf(TEXT("%d bytes"), Item->LuaTableValue.GetBytesView().Num());
+			break;
 		case ELuaValueType::Thread:
 			if (SelectedLuaState == Item->LuaTableValue.LuaState)
 			{
@@ -2,6 +2,7 @@
 
 #if WITH_DEV_AUTOMATION_TESTS
 #include "Tests/LuaUnitTestState.h"
+#include "LuaBlueprintFunctionLibrary.h"
 #include "Misc/AutomationTest.h"
 
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineBinaryTest_Simple, "LuaMachine.UnitTests.Binary.Simple", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
@@ -59,4 +60,102 @@ bool FLuaMachineBinaryTest_StringBuffer::RunTest(const FString& Parameters)
 }
 #endif
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineBinaryTest_Bytes, "LuaMachine.UnitTests.Binary.Bytes", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FLuaMachineBinaryTest_Bytes::RunTest(const FString& Parameters)
+{
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	ULuaUnitTestState* UnitTestState = ULuaState::CreateDynamicLuaState<ULuaUnitTestState>(TestWorld);
+	UnitTestState->BytesValueMinLength = 4;
+
+	UnitTestState->SetLuaValueFromGlobalName("test", FLuaValue::NewBytes({ 0xff, 0x00, 0x80, 0x01 }));
+
+	FLuaValue LuaValue = UnitTestState->RunString("return test", "");
+	TestTrue(TEXT("LuaValue.Type == Bytes"), LuaValue.Type == ELuaValueType::Bytes);
+	TestTrue(TEXT("LuaValue.ToBytes() == {0xff, 0x00, 0x80, 0x01}"), LuaValue.ToBytes() == TArray<uint8>({ 0xff, 0x00, 0x80, 0x01 }));
+
+	FLuaValue Length = UnitTestState->RunString("return #test", "");
+	TestEqual(TEXT("#test == 4"), Length.ToInteger(), (int64)4);
+
+	FLuaValue ShortString = UnitTestState->RunString("return 'abc'", "");
+	TestTrue(TEXT("ShortString.Type == String"), ShortString.Type == ELuaValueType::String);
+
+	FLuaValue Number = UnitTestState->RunString("return '1234.5'", "");
+	TestTrue(TEXT("Number.Type == Bytes"), Number.Type == ELuaValueType::Bytes);
+	TestEqual(TEXT("Number.ToInteger() == 1234"), Number.ToInteger(), (int64)1234);
+	TestEqual(TEXT("Number.ToFloat() == 1234.5"), Number.ToFloat(), 1234.5);
+
+	// what a value set to Bytes in the editor looks like, there is no buffer behind it
+	FLuaValue Unbuffered;
+	Unbuffered.Type = ELuaValueType::Bytes;
+	TestEqual(TEXT("Unbuffered.ToBytes().Num() == 0"), Unbuffered.ToBytes().Num(), 0);
+	TestEqual(TEXT("Unbuffered.ToString() == \"\""), Unbuffered.ToString(), FString());
+	UnitTestState->SetLuaValueFromGlobalName("unbuffered", Unbuffered);
+	TestEqual(TEXT("#unbuffered == 0"), UnitTestState->RunString("return #unbuffered", "").ToInteger(), (int64)0);
+
+	// Bytes values are strings for the blueprint helpers and survive a trip through FLuaCompactValue
+	TestTrue(TEXT("LuaValueIsString(LuaValue)"), ULuaBlueprintFunctionLibrary::LuaValueIsString(LuaValue));
+
+	FLuaCompactValue CompactBytes(LuaValue);
+	TestTrue(TEXT("CompactBytes.GetType() == Bytes"), CompactBytes.GetType() == ELuaValueType::Bytes);
+	TestEqual(TEXT("CompactBytes length == 4"), CompactBytes.GetStringLength(), 4);
+	TestTrue(TEXT("CompactBytes.ToLuaValue().Type == Bytes"), CompactBytes.ToLuaValue().Type == ELuaValueType::Bytes);
+	TestTrue(TEXT("CompactBytes.ToLuaValue().ToBytes() == {0xff, 0x00, 0x80, 0x01}"), CompactBytes.ToLuaValue().ToBytes() == TArray<uint8>({ 0xff, 0x00, 0x80, 0x01 }));
+
+	UnitTestState->RunString("compact = 'abcd'", "");
+	UnitTestState->GetGlobal("compact");
+	TestTrue(TEXT("ToLuaCompactValue('abcd').GetType() == Bytes"), UnitTestState->ToLuaCompactValue(-1).GetType() == ELuaValueType::Bytes);
+	UnitTestState->Pop();
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineBinaryTest_BytesBenchmark, "LuaMachine.Benchmarks.Binary.Bytes", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FLuaMachineBinaryTest_BytesBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 BlobSize = 64 * 1024 * 1024;
+
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	ULuaUnitTestState* UnitTestState = ULuaUnitTestState::CreateBenchmarkLuaState(TestWorld);
+
+	TArray<uint8> Blob;
+	Blob.SetNumUninitialized(BlobSize);
+	for (int32 Index = 0; Index < BlobSize; Index++)
+	{
+		Blob[Index] = (uint8)(Index * 31);
+	}
+
+	FLuaValue LuaFunction = UnitTestState->RunString("return function(blob) return blob end", "");
+
+	const TCHAR* Names[] = { TEXT("String"), TEXT("Bytes") };
+	double MegabytesPerSecond[2] = {};
+
+	for (int32 Pass = 0; Pass < 2; Pass++)
+	{
+		// String goes through the widened FString both ways, Bytes is a single copy each way
+		UnitTestState->BytesValueMinLength = Pass == 0 ? 0 : 1;
+
+		const double StartTime = FPlatformTime::Seconds();
+		FLuaValue Arg = Pass == 0 ? FLuaValue(Blob) : FLuaValue::NewBytes(Blob);
+		FLuaValue LuaValue = UnitTestState->LuaValueCall(LuaFunction, { Arg });
+		TArray<uint8> StringBytes;
+		TArrayView<const uint8> Result = Pass == 0 ? TArrayView<const uint8>(StringBytes = LuaValue.ToBytes()) : LuaValue.GetBytesView();
+		const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+		const bool bMatched = Result.Num() == Blob.Num() && FMemory::Memcmp(Result.GetData(), Blob.GetData(), Blob.Num()) == 0;
+
+		TestTrue(FString::Printf(TEXT("%s round trip matches"), Names[Pass]), bMatched);
+
+		MegabytesPerSecond[Pass] = Elapsed > 0 ? (BlobSize / (1024.0 * 1024.0)) / Elapsed : 0;
+	}
+
+	AddInfo(FString::Printf(TEXT("String: %.1f MB/s for a %d MB blob"), MegabytesPerSecond[0], BlobSize / (1024 * 1024)));
+	AddInfo(FString::Printf(TEXT("Bytes: %.1f MB/s for a %d MB blob"), MegabytesPerSecond[1], BlobSize / (1024 * 1024)));
+
+	return true;
+}
+
 #endif
\ No newline at end of file
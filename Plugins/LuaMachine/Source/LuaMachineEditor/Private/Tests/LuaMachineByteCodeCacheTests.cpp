@@ -0,0 +1,134 @@
+// Copyright 2025 - Roberto De Ioris
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "Tests/LuaUnitTestState.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+
+// the cache directory is shared with the editor, tests only remove the entries they wrote
+static TArray<FString> FindCachedByteCode()
+{
+	TArray<FString> CachedFiles;
+	IFileManager::Get().FindFiles(CachedFiles, *(ULuaState::GetByteCodeCacheDirectory() / TEXT("*.luac")), true, false);
+	return CachedFiles;
+}
+
+static void DeleteCachedByteCodeNotIn(const TArray<FString>& KeptFiles)
+{
+	for (const FString& CachedFile : FindCachedByteCode())
+	{
+		if (!KeptFiles.Contains(CachedFile))
+		{
+			IFileManager::Get().Delete(*(ULuaState::GetByteCodeCacheDirectory() / CachedFile));
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineByteCodeCacheTest_RunFile, "LuaMachine.UnitTests.ByteCodeCache.RunFile", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FLuaMachineByteCodeCacheTest_RunFile::RunTest(const FString& Parameters)
+{
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	const FString Filename = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("LuaMachine"), FGuid::NewGuid().ToString() + TEXT(".lua"));
+	FFileHelper::SaveStringToFile(TEXT("return 17"), *Filename);
+
+	const TArray<FString> PreviousCachedFiles = FindCachedByteCode();
+
+	for (int32 Pass = 0; Pass < 2; Pass++)
+	{
+		ULuaUnitTestState* UnitTestState = ULuaState::CreateDynamicLuaState<ULuaUnitTestState>(TestWorld);
+		UnitTestState->bCacheByteCode = true;
+
+		TestTrue(TEXT("RunFile"), UnitTestState->RunFile(Filename, false, 1, true));
+		TestEqual(TEXT("LuaValue == 17"), UnitTestState->ToLuaValue(-1).ToInteger(), (int64)17);
+		UnitTestState->Pop();
+
+		TestEqual(TEXT("one cached file"), FindCachedByteCode().Num(), PreviousCachedFiles.Num() + 1);
+	}
+
+	// a changed source replaces the stale bytecode in the same entry
+	FFileHelper::SaveStringToFile(TEXT("return 22"), *Filename);
+
+	for (int32 Pass = 0; Pass < 2; Pass++)
+	{
+		ULuaUnitTestState* UnitTestState = ULuaState::CreateDynamicLuaState<ULuaUnitTestState>(TestWorld);
+		UnitTestState->bCacheByteCode = true;
+
+		TestTrue(TEXT("RunFile"), UnitTestState->RunFile(Filename, false, 1, true));
+		TestEqual(TEXT("LuaValue == 22"), UnitTestState->ToLuaValue(-1).ToInteger(), (int64)22);
+		UnitTestState->Pop();
+
+		TestEqual(TEXT("still one cached file"), FindCachedByteCode().Num(), PreviousCachedFiles.Num() + 1);
+	}
+
+	IFileManager::Get().Delete(*Filename);
+	DeleteCachedByteCodeNotIn(PreviousCachedFiles);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineByteCodeCacheTest_StartupBenchmark, "LuaMachine.Benchmarks.ByteCodeCache.Startup", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FLuaMachineByteCodeCacheTest_StartupBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumModules = 300;
+	constexpr int32 NumFunctions = 40;
+
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	// modules are unique to this run, so the first cached pass is always cold
+	const FString ModulesDirectory = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("LuaMachine"), FGuid::NewGuid().ToString());
+	const TArray<FString> PreviousCachedFiles = FindCachedByteCode();
+	TArray<FString> Filenames;
+	for (int32 ModuleIndex = 0; ModuleIndex < NumModules; ModuleIndex++)
+	{
+		FString Code = TEXT("local M = {}\n");
+		for (int32 FunctionIndex = 0; FunctionIndex < NumFunctions; FunctionIndex++)
+		{
+			Code += FString::Printf(TEXT("function M.f%d(a, b)\n\tlocal t = { a = a, b = b, n = %d }\n\tif a > b then return t.a * %d else return t.b + %d end\nend\n"), FunctionIndex, FunctionIndex, ModuleIndex, FunctionIndex);
+		}
+		Code += TEXT("return M\n");
+
+		const FString Filename = FPaths::Combine(ModulesDirectory, FString::Printf(TEXT("module%d.lua"), ModuleIndex));
+		FFileHelper::SaveStringToFile(Code, *Filename);
+		Filenames.Add(Filename);
+	}
+
+	const TCHAR* Names[] = { TEXT("No cache"), TEXT("Cold cache"), TEXT("Warm cache") };
+	double Elapsed[3] = {};
+
+	for (int32 Pass = 0; Pass < 3; Pass++)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		ULuaUnitTestState* UnitTestState = ULuaUnitTestState::CreateBenchmarkLuaState(TestWorld, [Pass](ULuaUnitTestState* LuaState)
+		{
+			LuaState->bCacheByteCode = Pass > 0;
+		});
+
+		bool bAllLoaded = true;
+		for (const FString& Filename : Filenames)
+		{
+			bAllLoaded &= UnitTestState->RunFile(Filename, false, 0, true);
+		}
+
+		Elapsed[Pass] = FPlatformTime::Seconds() - StartTime;
+
+		TestTrue(FString::Printf(TEXT("%s loaded every module"), Names[Pass]), bAllLoaded);
+	}
+
+	for (int32 Pass = 0; Pass < 3; Pass++)
+	{
+		AddInfo(FString::Printf(TEXT("%s: %.2f ms to load %d modules"), Names[Pass], Elapsed[Pass] * 1000.0, NumModules));
+	}
+
+	// the modules will never be loaded again, do not leave their entries around
+	IFileManager::Get().DeleteDirectory(*ModulesDirectory, false, true);
+	DeleteCachedByteCodeNotIn(PreviousCachedFiles);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,155 @@
+// Copyright 2025 - Roberto De Ioris
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "Tests/LuaUnitTestState.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineCompactValueTest_Size, "LuaMachine.UnitTests.CompactValue.Size", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FLuaMachineCompactValueTest_Size::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("sizeof(FLuaCompactValue) == 16"), (int32)sizeof(FLuaCompactValue), 16);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineCompactValueTest_RoundTrip, "LuaMachine.UnitTests.CompactValue.RoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FLuaMachineCompactValueTest_RoundTrip::RunTest(const FString& Parameters)
+{
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	ULuaUnitTestState* UnitTestState = ULuaState::CreateDynamicLuaState<ULuaUnitTestState>(TestWorld);
+
+	FLuaValue Bench = UnitTestState->CreateLuaTable();
+	Bench.SetField("compact", ULuaUnitTestState::MarshalCompactValue_C);
+	UnitTestState->SetLuaValueFromGlobalName("bench", Bench);
+
+	FLuaValue LuaFunction = UnitTestState->RunString("return function() return bench.compact(40, 2.5, true, 'a\\0b') end", "");
+
+	TArray<FLuaValue> LuaValues = UnitTestState->LuaValueCallMulti(LuaFunction, {});
+
+	TestTrue(TEXT("LuaValues.Num() == 2"), LuaValues.Num() == 2);
+	TestEqual(TEXT("LuaValues[0] == 42.5"), LuaValues[0].ToFloat(), 42.5);
+	TestTrue(TEXT("LuaValues[1] == \"a\\0b\""), LuaValues[1].ToBytes() == TArray<uint8>({ 'a', 0, 'b' }));
+
+	FLuaValue LuaTable = UnitTestState->CreateLuaTable();
+	LuaTable.SetField("x", 17);
+
+	FLuaCompactValue CompactTable(LuaTable);
+	FLuaCompactValue CompactTableCopy = CompactTable;
+	TestTrue(TEXT("CompactTable is boxed"), CompactTableCopy.GetBoxedLuaValue() != nullptr);
+	TestEqual(TEXT("CompactTable.x == 17"), CompactTableCopy.ToLuaValue().GetField("x").ToInteger(), (int64)17);
+
+	FLuaCompactValue CompactString(FString("hello"));
+	TestEqual(TEXT("CompactString == \"hello\""), CompactString.ToString(), FString("hello"));
+	TestEqual(TEXT("CompactString length == 5"), CompactString.GetStringLength(), 5);
+
+	return true;
+}
+
+/* forwards to the allocator it replaces and counts the bytes requested through GMalloc on any thread */
+class FLuaMachineCountingMalloc final : public FMalloc
+{
+public:
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		AllocatedBytes.Add((int64)Count);
+		return Inner->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		AllocatedBytes.Add((int64)Count);
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		Inner->Free(Original);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return Inner->QuantizeSize(Count, Alignment);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return Inner->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return Inner->IsInternallyThreadSafe();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return TEXT("LuaMachineCountingMalloc");
+	}
+
+	FMalloc* Inner = nullptr;
+	FThreadSafeCounter64 AllocatedBytes;
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineCompactValueTest_MarshalBenchmark, "LuaMachine.Benchmarks.CompactValue.Marshal", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FLuaMachineCompactValueTest_MarshalBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 Iterations = 200000;
+
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	ULuaUnitTestState* UnitTestState = ULuaState::CreateDynamicLuaState<ULuaUnitTestState>(TestWorld);
+
+	FLuaValue Bench = UnitTestState->CreateLuaTable();
+	Bench.SetField("luavalue", ULuaUnitTestState::MarshalLuaValue_C);
+	Bench.SetField("compact", ULuaUnitTestState::MarshalCompactValue_C);
+	UnitTestState->SetLuaValueFromGlobalName("bench", Bench);
+
+	FLuaValue LuaFunction = UnitTestState->RunString("return function(name, n) local f = bench[name]; local r; for i = 1, n do r = f(i, 0.5, i % 2 == 0, 'hello') end; return r end", "");
+
+	const TCHAR* Names[] = { TEXT("luavalue"), TEXT("compact") };
+	double CallsPerSecond[2] = {};
+	double BytesPerCall[2] = {};
+
+	/* GMalloc is swapped only around the call, everything allocated in between (Lua included) is counted */
+	static FLuaMachineCountingMalloc CountingMalloc;
+	auto CountAllocatedBytes = [&](const TCHAR* Name, int32 NumCalls)
+	{
+		check(GMalloc != &CountingMalloc);
+		CountingMalloc.Inner = GMalloc;
+		CountingMalloc.AllocatedBytes.Reset();
+		GMalloc = &CountingMalloc;
+		UnitTestState->LuaValueCall(LuaFunction, { FString(Name), NumCalls });
+		GMalloc = CountingMalloc.Inner;
+		return CountingMalloc.AllocatedBytes.GetValue();
+	};
+
+	for (int32 Pass = 0; Pass < 2; Pass++)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		FLuaValue LuaValue = UnitTestState->LuaValueCall(LuaFunction, { FString(Names[Pass]), Iterations });
+		const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+		TestEqual(TEXT("LuaValue == Iterations + 0.5"), LuaValue.ToFloat(), Iterations + 0.5);
+
+		CallsPerSecond[Pass] = Elapsed > 0 ? Iterations / Elapsed : 0;
+
+		/* an empty loop is subtracted so what LuaValueCall itself allocates is left out */
+		constexpr int32 CountedCalls = 10000;
+		const int64 EmptyLoopBytes = CountAllocatedBytes(Names[Pass], 0);
+		BytesPerCall[Pass] = (double)(CountAllocatedBytes(Names[Pass], CountedCalls) - EmptyLoopBytes) / CountedCalls;
+	}
+
+	AddInfo(FString::Printf(TEXT("LUACFUNCTION: %.0f calls per second, %.1f bytes allocated per call"), CallsPerSecond[0], BytesPerCall[0]));
+	AddInfo(FString::Printf(TEXT("LUACFUNCTION_COMPACT: %.0f calls per second, %.1f bytes allocated per call"), CallsPerSecond[1], BytesPerCall[1]));
+
+	return true;
+}
+
+#endif
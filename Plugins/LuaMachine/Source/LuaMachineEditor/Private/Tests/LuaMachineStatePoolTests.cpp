@@ -0,0 +1,114 @@
+// Copyright 2025 - Roberto De Ioris
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "Tests/LuaUnitTestState.h"
+#include "LuaStatePool.h"
+#include "Misc/AutomationTest.h"
+#include "Async/TaskGraphInterfaces.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineStatePoolTest_Call, "LuaMachine.UnitTests.StatePool.Call", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FLuaMachineStatePoolTest_Call::RunTest(const FString& Parameters)
+{
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	TSharedPtr<FLuaStatePool, ESPMode::ThreadSafe> LuaStatePool = FLuaStatePool::Create(ULuaUnitTestState::StaticClass(), TestWorld, 2);
+	TestTrue(TEXT("LuaStatePool.IsValid()"), LuaStatePool.IsValid());
+	TestEqual(TEXT("LuaStatePool->Num() == 2"), LuaStatePool->Num(), 2);
+
+	FString Error;
+	TestTrue(TEXT("RunCode"), LuaStatePool->RunCode("loot = {} function loot.roll(t, n) return { total = t.a + t.b * n, tag = t.tag }, n * 2 end", "", Error));
+
+	ULuaUnitTestState* UnitTestState = ULuaState::CreateDynamicLuaState<ULuaUnitTestState>(TestWorld);
+	FLuaValue Table = UnitTestState->CreateLuaTable();
+	Table.SetField("a", 1);
+	Table.SetField("b", 2);
+	Table.SetField("tag", FLuaValue("rare"));
+
+	FLuaPlainValue PlainTable;
+	TestTrue(TEXT("FromLuaValue"), FLuaPlainValue::FromLuaValue(Table, PlainTable, Error));
+
+	FLuaStatePoolResult Result = LuaStatePool->Call("loot.roll", { PlainTable, FLuaValue(10) }).Get();
+	TestTrue(TEXT("Result.bSuccess"), Result.bSuccess);
+	TestEqual(TEXT("Result.Values.Num() == 2"), Result.Values.Num(), 2);
+
+	FLuaValue Returned = Result.Values[0].ToLuaValue(UnitTestState);
+	TestEqual(TEXT("Returned.total == 21"), Returned.GetField("total").ToInteger(), (int64)21);
+	TestEqual(TEXT("Returned.tag == \"rare\""), Returned.GetField("tag").ToString(), FString("rare"));
+	TestEqual(TEXT("Result.Values[1] == 20"), Result.Values[1].Value.ToInteger(), (int64)20);
+
+	FLuaStatePoolResult Missing = LuaStatePool->Call("loot.missing", {}).Get();
+	TestFalse(TEXT("Missing.bSuccess"), Missing.bSuccess);
+
+	// functions can not leave a pooled state
+	TestTrue(TEXT("RunCode"), LuaStatePool->RunCode("function loot.fn() return print end", "", Error));
+	FLuaStatePoolResult Function = LuaStatePool->Call("loot.fn", {}).Get();
+	TestFalse(TEXT("Function.bSuccess"), Function.bSuccess);
+
+	// a table that is its own key and value is refused right away, a table shared by two fields is copied
+	TestTrue(TEXT("RunCode"), LuaStatePool->RunCode("function loot.cycle() local t = {} t[t] = t return t end function loot.shared() local s = { 1 } return { a = s, b = s } end", "", Error));
+	FLuaStatePoolResult Cycle = LuaStatePool->Call("loot.cycle", {}).Get();
+	TestFalse(TEXT("Cycle.bSuccess"), Cycle.bSuccess);
+	FLuaStatePoolResult Shared = LuaStatePool->Call("loot.shared", {}).Get();
+	TestTrue(TEXT("Shared.bSuccess"), Shared.bSuccess);
+
+	// UFunctions of the state are refused on the workers but still work from the game thread
+	TestTrue(TEXT("RunCode"), LuaStatePool->RunCode("function loot.dummy() return dummy() end function loot.rawsum() return rawsum(1, 2, false) end", "", Error));
+	FLuaStatePoolResult Dummy = LuaStatePool->Call("loot.dummy", {}).Get();
+	TestFalse(TEXT("Dummy.bSuccess"), Dummy.bSuccess);
+	TestTrue(TEXT("Dummy.Error"), Dummy.Error.Contains(TEXT("game thread")));
+	FLuaStatePoolResult RawSum = LuaStatePool->Call("loot.rawsum", {}).Get();
+	TestFalse(TEXT("RawSum.bSuccess"), RawSum.bSuccess);
+	TestTrue(TEXT("RunCode"), LuaStatePool->RunCode("loot.dummy()", "", Error));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineStatePoolTest_ScalingBenchmark, "LuaMachine.Benchmarks.StatePool.Scaling", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FLuaMachineStatePoolTest_ScalingBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumJobs = 64;
+	constexpr int32 Iterations = 200000;
+
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	const int32 NumWorkers = FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1);
+	const int32 PoolSizes[] = { 1, NumWorkers };
+	double JobsPerSecond[2] = {};
+
+	for (int32 Pass = 0; Pass < 2; Pass++)
+	{
+		TSharedPtr<FLuaStatePool, ESPMode::ThreadSafe> LuaStatePool = FLuaStatePool::Create(ULuaUnitTestState::StaticClass(), TestWorld, PoolSizes[Pass]);
+
+		FString Error;
+		LuaStatePool->RunCode("function score(seed, n) local s = 0 for i = 1, n do s = (s + math.sqrt(i * seed)) % 1000 end return s end", "", Error);
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		TArray<TFuture<FLuaStatePoolResult>> Futures;
+		for (int32 Job = 0; Job < NumJobs; Job++)
+		{
+			Futures.Add(LuaStatePool->Call("score", { FLuaValue(Job + 1), FLuaValue(Iterations) }));
+		}
+
+		bool bAllSucceeded = true;
+		for (TFuture<FLuaStatePoolResult>& Future : Futures)
+		{
+			bAllSucceeded &= Future.Get().bSuccess;
+		}
+
+		const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+		TestTrue(TEXT("bAllSucceeded"), bAllSucceeded);
+
+		JobsPerSecond[Pass] = Elapsed > 0 ? NumJobs / Elapsed : 0;
+	}
+
+	AddInfo(FString::Printf(TEXT("1 state: %.1f jobs per second"), JobsPerSecond[0]));
+	AddInfo(FString::Printf(TEXT("%d states: %.1f jobs per second (%.2fx)"), NumWorkers, JobsPerSecond[1], JobsPerSecond[0] > 0 ? JobsPerSecond[1] / JobsPerSecond[0] : 0));
+
+	return true;
+}
+
+#endif
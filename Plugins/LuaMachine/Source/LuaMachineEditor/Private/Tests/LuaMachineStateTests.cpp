@@ -111,6 +111,24 @@ bool FLuaMachineStateTest_UFunction::RunTest(const FString& Parameters)
 	return true;
 }
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineStateTest_UFunctionRaw, "LuaMachine.UnitTests.State.UFunctionRaw", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FLuaMachineStateTest_UFunctionRaw::RunTest(const FString& Parameters)
+{
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	ULuaUnitTestState* UnitTestState = NewObject<ULuaUnitTestState>((UObject*)GetTransientPackage());
+	UnitTestState->bRawLuaFunctionCall = true;
+	UnitTestState->GetLuaState(TestWorld);
+
+	// repeated calls go through the cached call plan
+	FLuaValue ReturnValue = UnitTestState->RunString("local total = 0; for i = 1, 10 do total = total + rawsum(i, 0.5, i % 2 == 0) end; return total", "");
+
+	TestEqual(TEXT("LuaValue.Number == -5"), ReturnValue.ToFloat(), -5.0);
+
+	return true;
+}
+
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineStateTest_LambdaError, "LuaMachine.UnitTests.State.LambdaError", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
 
 bool FLuaMachineStateTest_LambdaError::RunTest(const FString& Parameters)
@@ -189,6 +207,96 @@ bool FLuaMachineStateTest_MaxMemoryUsage::RunTest(const FString& Parameters)
 	return true;
 }
 
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineStateTest_MemoryUsage, "LuaMachine.UnitTests.State.MemoryUsage", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FLuaMachineStateTest_MemoryUsage::RunTest(const FString& Parameters)
+{
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	ULuaUnitTestState* UnitTestState = ULuaState::CreateDynamicLuaState<ULuaUnitTestState>(TestWorld);
+
+	UnitTestState->bLogError = false;
+
+	const int64 InitialMemoryUsage = UnitTestState->GetMemoryUsage();
+	TestTrue(TEXT("InitialMemoryUsage > 0"), InitialMemoryUsage > 0);
+
+	UnitTestState->RunString("small = {} for i = 1, 16 do small[i] = i end", "");
+	TestTrue(TEXT("LuaState->GetMemoryUsage() > InitialMemoryUsage"), UnitTestState->GetMemoryUsage() > InitialMemoryUsage);
+
+	UnitTestState->RunString("big = {} for i = 1, 100000 do big[i] = {} end", "");
+	TestTrue(TEXT("LuaState Error"), UnitTestState->LastError.Contains("MaxMemoryUsage reached"));
+
+	TestTrue(TEXT("LuaState still usable"), UnitTestState->RunString("return 1 + 1", "").ToInteger() == 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineStateTest_MemoryUsageNativeCall, "LuaMachine.UnitTests.State.MemoryUsageNativeCall", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FLuaMachineStateTest_MemoryUsageNativeCall::RunTest(const FString& Parameters)
+{
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	ULuaUnitTestState* UnitTestState = ULuaState::CreateDynamicLuaState<ULuaUnitTestState>(TestWorld);
+
+	UnitTestState->bLogError = false;
+
+	// the returned string alone is over the limit, pushing it must not fail while the C++ call is still on the stack
+	UnitTestState->SetLuaValueFromGlobalName("big", FLuaValue::NewLambda([](TArray<FLuaValue> Args) { return FLuaValue(FString::ChrN(64 * 1024, TEXT('x'))); }));
+
+	FLuaValue LuaValue = UnitTestState->RunString("local s = big() return #s", "");
+	TestEqual(TEXT("#big() == 65536"), LuaValue.ToInteger(), (int64)(64 * 1024));
+
+	// back in Lua the limit applies again
+	UnitTestState->RunString("t = {} for i = 1, 1000 do t[i] = {} end", "");
+	TestTrue(TEXT("LuaState Error"), UnitTestState->LastError.Contains("MaxMemoryUsage reached"));
+
+	// an error raised by the C++ function skips its scope, the script catching it must not be left without the limit
+	UnitTestState->LastError.Empty();
+	UnitTestState->SetLuaValueFromGlobalName("fail", FLuaValue::NewLambda([UnitTestState](TArray<FLuaValue> Args) { UnitTestState->Error("fail"); return FLuaValue(); }));
+	UnitTestState->RunString("pcall(fail) xpcall(fail, function() end) t = {} for i = 1, 1000 do t[i] = {} end", "");
+	TestTrue(TEXT("LuaState Error after pcall"), UnitTestState->LastError.Contains("MaxMemoryUsage reached"));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineStateTest_AllocationBenchmark, "LuaMachine.Benchmarks.State.Allocation", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FLuaMachineStateTest_AllocationBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 Iterations = 200000;
+
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	const TCHAR* Names[] = { TEXT("FMalloc"), TEXT("Pooled") };
+	double Elapsed[2] = {};
+	int64 FinalMemoryUsage[2] = {};
+
+	for (int32 Pass = 0; Pass < 2; Pass++)
+	{
+		ULuaUnitTestState* UnitTestState = ULuaUnitTestState::CreateBenchmarkLuaState(TestWorld, [Pass](ULuaUnitTestState* LuaState)
+		{
+			LuaState->bPoolLuaAllocations = Pass == 1;
+		});
+
+		FLuaValue LuaFunction = UnitTestState->RunString("return function(n) local t = {} for i = 1, n do t[i % 1000 + 1] = { x = i, y = tostring(i), z = function() return i end } end return #t end", "");
+
+		const double StartTime = FPlatformTime::Seconds();
+		FLuaValue LuaValue = UnitTestState->LuaValueCall(LuaFunction, { Iterations });
+		Elapsed[Pass] = FPlatformTime::Seconds() - StartTime;
+		FinalMemoryUsage[Pass] = UnitTestState->GetMemoryUsage();
+
+		TestEqual(TEXT("LuaValue == 1000"), LuaValue.ToInteger(), (int64)1000);
+	}
+
+	for (int32 Pass = 0; Pass < 2; Pass++)
+	{
+		AddInfo(FString::Printf(TEXT("%s: %.0f iterations per second, %lld bytes in use at the end"), Names[Pass], Elapsed[Pass] > 0 ? Iterations / Elapsed[Pass] : 0, FinalMemoryUsage[Pass]));
+	}
+
+	return true;
+}
+
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineStateTest_Readonly, "LuaMachine.UnitTests.State.Readonly", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
 
 bool FLuaMachineStateTest_Readonly::RunTest(const FString& Parameters)
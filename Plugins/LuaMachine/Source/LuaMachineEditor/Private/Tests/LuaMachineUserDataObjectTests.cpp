@@ -0,0 +1,93 @@
+// Copyright 2025 - Roberto De Ioris
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "Tests/LuaUnitTestState.h"
+#include "Tests/LuaUserDataObjectTest.h"
+#include "Misc/AutomationTest.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineUserDataObjectTest_Index, "LuaMachine.UnitTests.UserDataObject.Index", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FLuaMachineUserDataObjectTest_Index::RunTest(const FString& Parameters)
+{
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	ULuaUnitTestState* UnitTestState = ULuaState::CreateDynamicLuaState<ULuaUnitTestState>(TestWorld);
+
+	FLuaValue UserData = UnitTestState->NewLuaUserDataObject<ULuaUserDataObjectTest>();
+	ULuaUserDataObjectTest* TestObject = Cast<ULuaUserDataObjectTest>(UserData.Object);
+
+	TestObject->Table.Add("hp", 100);
+	TestObject->Table.Add("Name", "Hero");
+
+	FLuaValue LuaFunction = UnitTestState->RunString("return function(a) return a.hp + a.hp, a.name, a.missing end", "");
+
+	TArray<FLuaValue> LuaValues = UnitTestState->LuaValueCallMulti(LuaFunction, { UserData });
+
+	TestTrue(TEXT("LuaValues.Num() == 3"), LuaValues.Num() == 3);
+	TestTrue(TEXT("LuaValues[0] == 200"), LuaValues[0].ToInteger() == 200);
+	// Table keys are case insensitive FStrings, the cached lookup must match them the same way
+	TestTrue(TEXT("LuaValues[1] == \"Hero\""), LuaValues[1].ToString() == "Hero");
+	TestTrue(TEXT("LuaValues[2] == nil"), LuaValues[2].Type == ELuaValueType::Nil);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineUserDataObjectTest_NewIndex, "LuaMachine.UnitTests.UserDataObject.NewIndex", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FLuaMachineUserDataObjectTest_NewIndex::RunTest(const FString& Parameters)
+{
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+	ULuaUnitTestState* UnitTestState = ULuaState::CreateDynamicLuaState<ULuaUnitTestState>(TestWorld);
+
+	FLuaValue UserData = UnitTestState->NewLuaUserDataObject<ULuaUserDataObjectTest>();
+	ULuaUserDataObjectTest* TestObject = Cast<ULuaUserDataObjectTest>(UserData.Object);
+
+	FLuaValue LuaFunction = UnitTestState->RunString("return function(a) a.mp = 17; a.mp = a.mp + 1; a[2] = 'two'; return a.mp end", "");
+
+	TestTrue(TEXT("LuaValue.Integer == 18"), UnitTestState->LuaValueCall(LuaFunction, { UserData }).ToInteger() == 18);
+	TestTrue(TEXT("Table[\"mp\"] == 18"), TestObject->Table.Contains("mp") && TestObject->Table["mp"].ToInteger() == 18);
+	TestTrue(TEXT("Table[\"2\"] == \"two\""), TestObject->Table.Contains("2") && TestObject->Table["2"].ToString() == "two");
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLuaMachineUserDataObjectTest_FieldAccessBenchmark, "LuaMachine.Benchmarks.UserDataObject.FieldAccess", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FLuaMachineUserDataObjectTest_FieldAccessBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 Iterations = 200000;
+	double AccessesPerSecond[2] = {};
+
+	for (int32 Pass = 0; Pass < 2; Pass++)
+	{
+		UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Inactive, false);
+
+		ULuaUnitTestState* UnitTestState = ULuaState::CreateDynamicLuaState<ULuaUnitTestState>(TestWorld);
+		UnitTestState->bInternUserDataKeys = Pass == 1;
+
+		FLuaValue UserData = UnitTestState->NewLuaUserDataObject<ULuaUserDataObjectTest>();
+		ULuaUserDataObjectTest* TestObject = Cast<ULuaUserDataObjectTest>(UserData.Object);
+
+		TestObject->Table.Add("x", 1);
+		TestObject->Table.Add("y", 2);
+		TestObject->Table.Add("z", 3);
+
+		// 4 field accesses per iteration
+		FLuaValue LuaFunction = UnitTestState->RunString("return function(a, n) local sum = 0; for i = 1, n do sum = sum + a.x + a.y + a.z; a.x = 1 end; return sum end", "");
+
+		const double StartTime = FPlatformTime::Seconds();
+		FLuaValue LuaValue = UnitTestState->LuaValueCall(LuaFunction, { UserData, Iterations });
+		const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+		TestTrue(TEXT("LuaValue.Integer == Iterations * 6"), LuaValue.ToInteger() == Iterations * 6);
+
+		AccessesPerSecond[Pass] = Elapsed > 0 ? Iterations * 4 / Elapsed : 0;
+	}
+
+	AddInfo(FString::Printf(TEXT("UserData field accesses per second: %.0f uncached, %.0f interned keys (%.2fx)"), AccessesPerSecond[0], AccessesPerSecond[1], AccessesPerSecond[0] > 0 ? AccessesPerSecond[1] / AccessesPerSecond[0] : 0.0));
+
+	return true;
+}
+
+#endif
@@ -5,4 +5,9 @@
 FLuaValue ULuaUnitTestState::DummyFunction()
 {
 	return "Hello Test";
+}
+
+float ULuaUnitTestState::RawSumFunction(int32 A, float B, bool bNegate)
+{
+	return bNegate ? -(A + B) : A + B;
 }
\ No newline at end of file
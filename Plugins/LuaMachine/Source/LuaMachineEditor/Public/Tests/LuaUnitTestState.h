@@ -25,6 +25,22 @@ public:
 		Table.Add("lambda002", FLuaValue::NewLambda([this](TArray<FLuaValue> Args) { return Table["lambda001"]; }));
 		Table.Add("lambda003", FLuaValue::NewLambda([](TArray<FLuaValue> Args) { return FString("!!!ERROR!!!"); }));
 		Table.Add("dummy", FLuaValue::Function(GET_FUNCTION_NAME_CHECKED(ULuaUnitTestState, DummyFunction)));
+		Table.Add("rawsum", FLuaValue::Function(GET_FUNCTION_NAME_CHECKED(ULuaUnitTestState, RawSumFunction)));
+	}
+
+	/* For the LuaMachine.Benchmarks tests, their data is far bigger than the 8 KB the unit tests allow so there is no MaxMemoryUsage. Configure sets properties before the state is created */
+	static ULuaUnitTestState* CreateBenchmarkLuaState(UWorld* World, TFunctionRef<void(ULuaUnitTestState*)> Configure)
+	{
+		ULuaUnitTestState* LuaState = NewObject<ULuaUnitTestState>((UObject*)GetTransientPackage());
+		LuaState->MaxMemoryUsage = 0;
+		Configure(LuaState);
+		LuaState->GetLuaState(World);
+		return LuaState;
+	}
+
+	static ULuaUnitTestState* CreateBenchmarkLuaState(UWorld* World)
+	{
+		return CreateBenchmarkLuaState(World, [](ULuaUnitTestState* LuaState) {});
 	}
 
 	void ReceiveLuaSingleStepHook_Implementation(const FLuaDebug& LuaDebug) override
@@ -36,4 +52,18 @@ public:
 
 	UFUNCTION()
 	FLuaValue DummyFunction();
+
+	UFUNCTION()
+	float RawSumFunction(int32 A, float B, bool bNegate);
+
+	LUACFUNCTION(ULuaUnitTestState, MarshalLuaValue, 2, 4)
+	{
+		return { LuaArgs[0].ToInteger() + LuaArgs[1].ToFloat(), LuaArgs[3] };
+	}
+
+	LUACFUNCTION_COMPACT(ULuaUnitTestState, MarshalCompactValue, 2, 4)
+	{
+		RetValues[0] = LuaArgs[0].ToInteger() + LuaArgs[1].ToFloat();
+		RetValues[1] = LuaArgs[3];
+	}
 };
@@ -0,0 +1,17 @@
+// Copyright 2025 - Roberto De Ioris
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LuaUserDataObject.h"
+#include "LuaUserDataObjectTest.generated.h"
+
+/**
+ * Concrete LuaUserDataObject exposing only its Table
+ */
+UCLASS()
+class LUAMACHINEEDITOR_API ULuaUserDataObjectTest : public ULuaUserDataObject
+{
+	GENERATED_BODY()
+
+};
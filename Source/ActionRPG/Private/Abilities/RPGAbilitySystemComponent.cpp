@@ -5,7 +5,48 @@
 #include "Abilities/RPGGameplayAbility.h"
 #include "AbilitySystemGlobals.h"
 
-URPGAbilitySystemComponent::URPGAbilitySystemComponent() {}
+DECLARE_STATS_GROUP(TEXT("RPG Ability Events"), STATGROUP_RPGAbilityEvents, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Events Dispatched"), STAT_RPGEventsDispatched, STATGROUP_RPGAbilityEvents);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Events Filtered"), STAT_RPGEventsFiltered, STATGROUP_RPGAbilityEvents);
+
+URPGAbilitySystemComponent::URPGAbilitySystemComponent()
+	: ActiveEffectsGeneration(0)
+{}
+
+void URPGAbilitySystemComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	// Register can happen more than once, so don't double bind
+	if (!ActiveEffectAddedHandle.IsValid())
+	{
+		ActiveEffectAddedHandle = OnActiveGameplayEffectAddedDelegateToSelf.AddUObject(this, &URPGAbilitySystemComponent::HandleActiveEffectAdded);
+	}
+	if (!ActiveEffectRemovedHandle.IsValid())
+	{
+		ActiveEffectRemovedHandle = OnAnyGameplayEffectRemovedDelegate().AddUObject(this, &URPGAbilitySystemComponent::HandleActiveEffectRemoved);
+	}
+}
+
+void URPGAbilitySystemComponent::OnUnregister()
+{
+	OnActiveGameplayEffectAddedDelegateToSelf.Remove(ActiveEffectAddedHandle);
+	ActiveEffectAddedHandle.Reset();
+	OnAnyGameplayEffectRemovedDelegate().Remove(ActiveEffectRemovedHandle);
+	ActiveEffectRemovedHandle.Reset();
+
+	Super::OnUnregister();
+}
+
+void URPGAbilitySystemComponent::HandleActiveEffectAdded(UAbilitySystemComponent* Target, const FGameplayEffectSpec& SpecApplied, FActiveGameplayEffectHandle ActiveHandle)
+{
+	ActiveEffectsGeneration++;
+}
+
+void URPGAbilitySystemComponent::HandleActiveEffectRemoved(const FActiveGameplayEffect& RemovedEffect)
+{
+	ActiveEffectsGeneration++;
+}
 
 void URPGAbilitySystemComponent::GetActiveAbilitiesWithTags(const FGameplayTagContainer& GameplayTagContainer, TArray<URPGGameplayAbility*>& ActiveAbilities)
 {
@@ -25,6 +66,139 @@ void URPGAbilitySystemComponent::GetActiveAbilitiesWithTags(const FGameplayTagCo
 	}
 }
 
+void URPGAbilitySystemComponent::NotifyAbilityActivated(const FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability)
+{
+	URPGGameplayAbility* RPGAbility = Cast<URPGGameplayAbility>(Ability);
+	if (RPGAbility)
+	{
+		RunningAbilities.Add(RPGAbility);
+		ActiveAbilityTagCounts.UpdateTagCount(RPGAbility->GetAbilityTags(), 1);
+	}
+
+	Super::NotifyAbilityActivated(Handle, Ability);
+}
+
+void URPGAbilitySystemComponent::NotifyAbilityEnded(FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability, bool bWasCancelled)
+{
+	URPGGameplayAbility* RPGAbility = Cast<URPGGameplayAbility>(Ability);
+
+	// Only undo what activation added, an ability can end without having activated if it failed to commit
+	if (RPGAbility && RunningAbilities.RemoveSingleSwap(RPGAbility, false) > 0)
+	{
+		ActiveAbilityTagCounts.UpdateTagCount(RPGAbility->GetAbilityTags(), -1);
+	}
+
+	Super::NotifyAbilityEnded(Handle, Ability, bWasCancelled);
+}
+
+int32 URPGAbilitySystemComponent::HandleGameplayEvent(FGameplayTag EventTag, const FGameplayEventData* Payload)
+{
+	const int32 TriggeredCount = Super::HandleGameplayEvent(EventTag, Payload);
+
+	// Gather references first, listeners commonly remove themselves when they receive an event and the reference keeps the delegate alive while it runs
+	TArray<FIndexedEventListenerRef, TInlineAllocator<16>> MatchingListeners;
+	MatchingListeners.Append(EventListenersForAllTags);
+
+	// Walk up the hierarchy, a listener for A.B also wants A.B.C
+	for (FGameplayTag Tag = EventTag; Tag.IsValid(); Tag = Tag.RequestDirectParent())
+	{
+		const TArray<FIndexedEventListenerRef>* TagListeners = EventListenersByTag.Find(Tag);
+		if (TagListeners)
+		{
+			for (const FIndexedEventListenerRef& Listener : *TagListeners)
+			{
+				if (!MatchingListeners.ContainsByPredicate([&Listener](const FIndexedEventListenerRef& Existing) { return Existing->Handle == Listener->Handle; }))
+				{
+					MatchingListeners.Add(Listener);
+				}
+			}
+		}
+	}
+
+	if (MatchingListeners.Num() == 0)
+	{
+		INC_DWORD_STAT(STAT_RPGEventsFiltered);
+	}
+
+	for (const FIndexedEventListenerRef& Listener : MatchingListeners)
+	{
+		// Skip anything removed by an earlier listener in this loop
+		if (EventListeners.Contains(Listener->Handle))
+		{
+			INC_DWORD_STAT(STAT_RPGEventsDispatched);
+			Listener->Delegate.ExecuteIfBound(EventTag, Payload);
+		}
+	}
+
+	return TriggeredCount;
+}
+
+FDelegateHandle URPGAbilitySystemComponent::AddIndexedGameplayEventListener(const FGameplayTagContainer& EventTags, FRPGGameplayEventListener Listener)
+{
+	FDelegateHandle Handle(FDelegateHandle::GenerateNewHandle);
+	FIndexedEventListenerRef IndexedListener = MakeShared<const FIndexedEventListener>(FIndexedEventListener{ Handle, EventTags, MoveTemp(Listener) });
+
+	if (EventTags.IsEmpty())
+	{
+		EventListenersForAllTags.Add(IndexedListener);
+	}
+	else
+	{
+		for (const FGameplayTag& Tag : EventTags)
+		{
+			EventListenersByTag.FindOrAdd(Tag).Add(IndexedListener);
+		}
+	}
+
+	EventListeners.Add(Handle, IndexedListener);
+	return Handle;
+}
+
+void URPGAbilitySystemComponent::RemoveIndexedGameplayEventListener(FDelegateHandle Handle)
+{
+	const FIndexedEventListenerRef* IndexedListener = EventListeners.Find(Handle);
+	if (!IndexedListener)
+	{
+		return;
+	}
+
+	// Copy before removing, the stored reference goes away with the map entry
+	const FGameplayTagContainer EventTags = (*IndexedListener)->EventTags;
+	EventListeners.Remove(Handle);
+
+	auto MatchesHandle = [&Handle](const FIndexedEventListenerRef& Listener)
+	{
+		return Listener->Handle == Handle;
+	};
+
+	if (EventTags.IsEmpty())
+	{
+		EventListenersForAllTags.RemoveAllSwap(MatchesHandle, false);
+	}
+	else
+	{
+		for (const FGameplayTag& Tag : EventTags)
+		{
+			TArray<FIndexedEventListenerRef>* TagListeners = EventListenersByTag.Find(Tag);
+			if (TagListeners)
+			{
+				TagListeners->RemoveAllSwap(MatchesHandle, false);
+			}
+		}
+	}
+}
+
+bool URPGAbilitySystemComponent::HasActiveAbilityWithAllTags(const FGameplayTagContainer& GameplayTagContainer) const
+{
+	bool bFound = false;
+
+	ForEachActiveAbilityWithTags(GameplayTagContainer, [&bFound](URPGGameplayAbility* Ability)
+	{
+		bFound = true;
+	});
+	return bFound;
+}
+
 int32 URPGAbilitySystemComponent::GetDefaultAbilityLevel() const
 {
 	ARPGCharacterBase* OwningCharacter = Cast<ARPGCharacterBase>(GetOwnerActor());
@@ -0,0 +1,9 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Abilities/RPGAbilitySystemGlobals.h"
+#include "Abilities/RPGAbilityTypes.h"
+
+FGameplayEffectContext* URPGAbilitySystemGlobals::AllocGameplayEffectContext() const
+{
+	return new FRPGGameplayEffectContext();
+}
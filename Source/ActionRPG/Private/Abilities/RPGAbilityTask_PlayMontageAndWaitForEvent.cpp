@@ -86,10 +86,16 @@ void URPGAbilityTask_PlayMontageAndWaitForEvent::OnGameplayEvent(FGameplayTag Ev
 {
 	if (ShouldBroadcastAbilityTaskDelegates())
 	{
-		FGameplayEventData TempData = *Payload;
-		TempData.EventTag = EventTag;
+		EventTagReceived.Broadcast(EventTag);
 
-		EventReceived.Broadcast(EventTag, TempData);
+		// Only pay for the payload copy if someone wants it
+		if (EventReceived.IsBound())
+		{
+			FGameplayEventData TempData = *Payload;
+			TempData.EventTag = EventTag;
+
+			EventReceived.Broadcast(EventTag, TempData);
+		}
 	}
 }
 
@@ -126,7 +132,7 @@ void URPGAbilityTask_PlayMontageAndWaitForEvent::Activate()
 		if (AnimInstance != nullptr)
 		{
 			// Bind to event callback
-			EventHandle = RPGAbilitySystemComponent->AddGameplayEventTagContainerDelegate(EventTags, FGameplayEventTagMulticastDelegate::FDelegate::CreateUObject(this, &URPGAbilityTask_PlayMontageAndWaitForEvent::OnGameplayEvent));
+			EventHandle = RPGAbilitySystemComponent->AddIndexedGameplayEventListener(EventTags, FRPGGameplayEventListener::CreateUObject(this, &URPGAbilityTask_PlayMontageAndWaitForEvent::OnGameplayEvent));
 
 			if (RPGAbilitySystemComponent->PlayMontage(Ability, Ability->GetCurrentActivationInfo(), MontageToPlay, Rate, StartSection) > 0.f)
 			{
@@ -203,7 +209,7 @@ void URPGAbilityTask_PlayMontageAndWaitForEvent::OnDestroy(bool AbilityEnded)
 	URPGAbilitySystemComponent* RPGAbilitySystemComponent = GetTargetASC();
 	if (RPGAbilitySystemComponent)
 	{
-		RPGAbilitySystemComponent->RemoveGameplayEventTagContainerDelegate(EventTags, EventHandle);
+		RPGAbilitySystemComponent->RemoveIndexedGameplayEventListener(EventHandle);
 	}
 
 	Super::OnDestroy(AbilityEnded);
@@ -3,6 +3,107 @@
 #include "Abilities/RPGAbilityTypes.h"
 #include "Abilities/RPGAbilitySystemComponent.h"
 #include "AbilitySystemGlobals.h"
+#include "Misc/ScopeLock.h"
+
+DECLARE_STATS_GROUP(TEXT("RPG Target Data"), STATGROUP_RPGTargetData, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Target Data Requested"), STAT_RPGTargetDataRequested, STATGROUP_RPGTargetData);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Target Data Allocated"), STAT_RPGTargetDataAllocated, STATGROUP_RPGTargetData);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Target Data Pooled"), STAT_RPGTargetDataPooled, STATGROUP_RPGTargetData);
+
+/** Clears what the previous use left in recycled target data before it is handed out again */
+static void ResetPooledTargetData(FGameplayAbilityTargetData_SingleTargetHit& Data)
+{
+	Data.HitResult = FHitResult();
+	Data.bHitReplaced = false;
+}
+
+static void ResetPooledTargetData(FGameplayAbilityTargetData_ActorArray& Data)
+{
+	Data.SourceLocation = FGameplayAbilityTargetingLocationInfo();
+	// Keep the allocation, most swings hit a similar number of actors
+	Data.TargetActorArray.Reset();
+}
+
+/**
+ * Recycles target data of one type. The pool keeps its own shared pointer to every object it created, and an object is free again once that is its
+ * only reference. Reusing one hands out a copy of the pooled pointer, so neither the object nor its reference controller is allocated again
+ * Handles own a reference like any other shared pointer, so target data can safely outlive the container spec that created it
+ * Reference counts are thread safe, as they are for every shared pointer a target data handle holds, so handles may be released on any thread
+ */
+template<typename TargetDataType>
+class TRPGTargetDataPool
+{
+public:
+	/** Most objects kept around per type, anything created past this is not pooled */
+	static constexpr int32 MaxPooled = 256;
+
+	static TRPGTargetDataPool& Get()
+	{
+		static TRPGTargetDataPool Pool;
+		return Pool;
+	}
+
+	~TRPGTargetDataPool()
+	{
+		DEC_DWORD_STAT_BY(STAT_RPGTargetDataPooled, Entries.Num());
+	}
+
+	/** Returns a reset object, reusing a pooled one that nothing else references. Can be called from any thread */
+	TSharedPtr<FGameplayAbilityTargetData> Acquire()
+	{
+		INC_DWORD_STAT(STAT_RPGTargetDataRequested);
+
+		FScopeLock Lock(&EntriesLock);
+
+		AcquiresSinceSweep++;
+
+		// Releasing a handle doesn't tell the pool, so free entries are found by sweeping. Sweeps are spaced out so their cost stays constant per
+		// Acquire even when every entry is in use
+		if (FreeEntries.Num() == 0 && AcquiresSinceSweep > Entries.Num() / 2)
+		{
+			AcquiresSinceSweep = 0;
+
+			for (int32 EntryIndex = Entries.Num() - 1; EntryIndex >= 0; EntryIndex--)
+			{
+				// Only the pool can add references to an entry nothing else holds, and it does so under the lock, so a free entry stays free
+				if (Entries[EntryIndex].GetSharedReferenceCount() == 1)
+				{
+					FreeEntries.Add(EntryIndex);
+				}
+			}
+		}
+
+		if (FreeEntries.Num() > 0)
+		{
+			TSharedPtr<TargetDataType, ESPMode::ThreadSafe>& Entry = Entries[FreeEntries.Pop(false)];
+			ResetPooledTargetData(*Entry);
+			return Entry;
+		}
+
+		// Object and reference controller in one allocation
+		TSharedPtr<TargetDataType, ESPMode::ThreadSafe> NewData = MakeShared<TargetDataType, ESPMode::ThreadSafe>();
+		INC_DWORD_STAT(STAT_RPGTargetDataAllocated);
+
+		if (Entries.Num() < MaxPooled)
+		{
+			Entries.Add(NewData);
+			INC_DWORD_STAT(STAT_RPGTargetDataPooled);
+		}
+		return NewData;
+	}
+
+private:
+	/** Every pooled object, in use or not */
+	TArray<TSharedPtr<TargetDataType, ESPMode::ThreadSafe>> Entries;
+
+	/** Indices of entries that were free at the last sweep and haven't been handed out since */
+	TArray<int32> FreeEntries;
+
+	/** Acquires since the last sweep of Entries */
+	int32 AcquiresSinceSweep = 0;
+
+	FCriticalSection EntriesLock;
+};
 
 bool FRPGGameplayEffectContainerSpec::HasValidEffects() const
 {
@@ -16,16 +117,25 @@ bool FRPGGameplayEffectContainerSpec::HasValidTargets() const
 
 void FRPGGameplayEffectContainerSpec::AddTargets(const TArray<FHitResult>& HitResults, const TArray<AActor*>& TargetActors)
 {
-	for (const FHitResult& HitResult : HitResults)
+	// One entry per hit, plus one for all of the actors
+	TargetData.Data.Reserve(TargetData.Data.Num() + HitResults.Num() + (TargetActors.Num() > 0 ? 1 : 0));
+
+	if (HitResults.Num() > 0)
 	{
-		FGameplayAbilityTargetData_SingleTargetHit* NewData = new FGameplayAbilityTargetData_SingleTargetHit(HitResult);
-		TargetData.Add(NewData);
+		TRPGTargetDataPool<FGameplayAbilityTargetData_SingleTargetHit>& HitPool = TRPGTargetDataPool<FGameplayAbilityTargetData_SingleTargetHit>::Get();
+
+		for (const FHitResult& HitResult : HitResults)
+		{
+			TSharedPtr<FGameplayAbilityTargetData> NewData = HitPool.Acquire();
+			static_cast<FGameplayAbilityTargetData_SingleTargetHit*>(NewData.Get())->HitResult = HitResult;
+			TargetData.Data.Add(MoveTemp(NewData));
+		}
 	}
 
 	if (TargetActors.Num() > 0)
 	{
-		FGameplayAbilityTargetData_ActorArray* NewData = new FGameplayAbilityTargetData_ActorArray();
-		NewData->TargetActorArray.Append(TargetActors);
-		TargetData.Add(NewData);
+		TSharedPtr<FGameplayAbilityTargetData> NewData = TRPGTargetDataPool<FGameplayAbilityTargetData_ActorArray>::Get().Acquire();
+		static_cast<FGameplayAbilityTargetData_ActorArray*>(NewData.Get())->TargetActorArray.Append(TargetActors);
+		TargetData.Data.Add(MoveTemp(NewData));
 	}
 }
\ No newline at end of file
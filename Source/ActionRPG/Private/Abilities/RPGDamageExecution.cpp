@@ -2,6 +2,7 @@
 
 #include "Abilities/RPGDamageExecution.h"
 #include "Abilities/RPGAttributeSet.h"
+#include "Abilities/RPGAbilityTypes.h"
 #include "AbilitySystemComponent.h"
 
 struct RPGDamageStatics
@@ -69,10 +70,29 @@ void URPGDamageExecution::Execute_Implementation(const FGameplayEffectCustomExec
 	}
 
 	float AttackPower = 0.f;
-	ExecutionParams.AttemptCalculateCapturedAttributeMagnitude(DamageStatics().AttackPowerDef, EvaluationParameters, AttackPower);
-
 	float Damage = 0.f;
-	ExecutionParams.AttemptCalculateCapturedAttributeMagnitude(DamageStatics().DamageDef, EvaluationParameters, Damage);
+
+	// In snapshot mode the source side is evaluated by the first target and reused by the rest, every target's context shares the snapshot
+	FRPGGameplayEffectContext* Context = FRPGGameplayEffectContext::Get(Spec.GetContext());
+	FRPGSourceAttributeSnapshot* Snapshot = Context ? Context->SourceSnapshot.Get() : nullptr;
+
+	if (Snapshot && Snapshot->bCaptured)
+	{
+		AttackPower = Snapshot->AttackPower;
+		Damage = Snapshot->Damage;
+	}
+	else
+	{
+		ExecutionParams.AttemptCalculateCapturedAttributeMagnitude(DamageStatics().AttackPowerDef, EvaluationParameters, AttackPower);
+		ExecutionParams.AttemptCalculateCapturedAttributeMagnitude(DamageStatics().DamageDef, EvaluationParameters, Damage);
+
+		if (Snapshot)
+		{
+			Snapshot->AttackPower = AttackPower;
+			Snapshot->Damage = Damage;
+			Snapshot->bCaptured = true;
+		}
+	}
 
 	float DamageDone = Damage * AttackPower / DefensePower;
 	if (DamageDone > 0.f)
@@ -5,7 +5,9 @@
 #include "Abilities/RPGTargetType.h"
 #include "RPGCharacterBase.h"
 
-URPGGameplayAbility::URPGGameplayAbility() {}
+URPGGameplayAbility::URPGGameplayAbility()
+	: bSnapshotSourceAttributes(false)
+{}
 
 FRPGGameplayEffectContainerSpec URPGGameplayAbility::MakeEffectContainerSpecFromContainer(const FRPGGameplayEffectContainer& Container, const FGameplayEventData& EventData, int32 OverrideGameplayLevel)
 {
@@ -37,7 +39,19 @@ FRPGGameplayEffectContainerSpec URPGGameplayAbility::MakeEffectContainerSpecFrom
 		// Build GameplayEffectSpecs for each applied effect
 		for (const TSubclassOf<UGameplayEffect>& EffectClass : Container.TargetGameplayEffectClasses)
 		{
-			ReturnSpec.TargetGameplayEffectSpecs.Add(MakeOutgoingGameplayEffectSpec(EffectClass, OverrideGameplayLevel));
+			FGameplayEffectSpecHandle SpecHandle = MakeOutgoingGameplayEffectSpec(EffectClass, OverrideGameplayLevel);
+
+			if (bSnapshotSourceAttributes && SpecHandle.IsValid())
+			{
+				// Every target gets a duplicate of this context, the duplicates share its snapshot
+				FRPGGameplayEffectContext* Context = FRPGGameplayEffectContext::Get(SpecHandle.Data->GetContext());
+				if (Context)
+				{
+					Context->EnableSourceSnapshot();
+				}
+			}
+
+			ReturnSpec.TargetGameplayEffectSpecs.Add(SpecHandle);
 		}
 	}
 	return ReturnSpec;
@@ -3,6 +3,7 @@
 #include "Abilities/RPGTargetType.h"
 #include "Abilities/RPGGameplayAbility.h"
 #include "RPGCharacterBase.h"
+#include "RPGCharacterGridSubsystem.h"
 
 void URPGTargetType::GetTargets_Implementation(ARPGCharacterBase* TargetingCharacter, AActor* TargetingActor, FGameplayEventData EventData, TArray<FHitResult>& OutHitResults, TArray<AActor*>& OutActors) const
 {
@@ -25,4 +26,115 @@ void URPGTargetType_UseEventData::GetTargets_Implementation(ARPGCharacterBase* T
 	{
 		OutActors.Add(const_cast<AActor*>(EventData.Target.Get()));
 	}
-}
\ No newline at end of file
+}
+
+URPGTargetType_Area::URPGTargetType_Area()
+	: OriginOffset(FVector::ZeroVector)
+	, MaxHeightDifference(300.f)
+	, bIncludeTargetingCharacter(false)
+	, bIgnoreSameTeam(true)
+	, bIgnoreDead(true)
+{}
+
+void URPGTargetType_Area::GetTargets_Implementation(ARPGCharacterBase* TargetingCharacter, AActor* TargetingActor, FGameplayEventData EventData, TArray<FHitResult>& OutHitResults, TArray<AActor*>& OutActors) const
+{
+	AActor* SourceActor = TargetingActor ? TargetingActor : TargetingCharacter;
+	UWorld* World = SourceActor ? SourceActor->GetWorld() : nullptr;
+	URPGCharacterGridSubsystem* Grid = World ? World->GetSubsystem<URPGCharacterGridSubsystem>() : nullptr;
+
+	if (!Grid)
+	{
+		return;
+	}
+
+	const FTransform& SourceTransform = SourceActor->GetActorTransform();
+	const FVector Origin = SourceTransform.TransformPosition(OriginOffset);
+	const FVector Forward = SourceTransform.GetUnitAxis(EAxis::X).GetSafeNormal2D();
+	const float Extent = GetQueryExtent();
+	const FGenericTeamId SourceTeam = TargetingCharacter ? TargetingCharacter->GetGenericTeamId() : FGenericTeamId::NoTeam;
+
+	Grid->ForEachCharacterInBounds(FVector2D(Origin.X - Extent, Origin.Y - Extent), FVector2D(Origin.X + Extent, Origin.Y + Extent), [&](ARPGCharacterBase* Character)
+	{
+		if (Character == TargetingCharacter && !bIncludeTargetingCharacter)
+		{
+			return;
+		}
+
+		if (bIgnoreSameTeam && TargetingCharacter && Character != TargetingCharacter && Character->GetGenericTeamId() == SourceTeam)
+		{
+			return;
+		}
+
+		if (bIgnoreDead && Character->GetHealth() <= 0.f)
+		{
+			return;
+		}
+
+		const FVector Location = Character->GetActorLocation();
+		if (FMath::Abs(Location.Z - Origin.Z) <= MaxHeightDifference && IsInShape(Origin, Forward, Location))
+		{
+			OutActors.Add(Character);
+		}
+	});
+}
+
+URPGTargetType_Cylinder::URPGTargetType_Cylinder()
+	: Radius(300.f)
+{}
+
+float URPGTargetType_Cylinder::GetQueryExtent() const
+{
+	return Radius;
+}
+
+bool URPGTargetType_Cylinder::IsInShape(const FVector& Origin, const FVector& Forward, const FVector& Location) const
+{
+	return FVector::DistSquared2D(Origin, Location) <= FMath::Square(Radius);
+}
+
+URPGTargetType_Cone::URPGTargetType_Cone()
+	: Radius(400.f)
+	, HalfAngle(45.f)
+{}
+
+float URPGTargetType_Cone::GetQueryExtent() const
+{
+	return Radius;
+}
+
+bool URPGTargetType_Cone::IsInShape(const FVector& Origin, const FVector& Forward, const FVector& Location) const
+{
+	const FVector Offset = (Location - Origin) * FVector(1.f, 1.f, 0.f);
+	const float DistSquared = Offset.SizeSquared();
+
+	if (DistSquared > FMath::Square(Radius))
+	{
+		return false;
+	}
+
+	// Standing right on the origin counts as inside
+	if (DistSquared < KINDA_SMALL_NUMBER)
+	{
+		return true;
+	}
+
+	return FVector::DotProduct(Offset, Forward) >= FMath::Cos(FMath::DegreesToRadians(HalfAngle)) * FMath::Sqrt(DistSquared);
+}
+
+URPGTargetType_Capsule::URPGTargetType_Capsule()
+	: Length(600.f)
+	, Radius(100.f)
+{}
+
+float URPGTargetType_Capsule::GetQueryExtent() const
+{
+	return Length + Radius;
+}
+
+bool URPGTargetType_Capsule::IsInShape(const FVector& Origin, const FVector& Forward, const FVector& Location) const
+{
+	const FVector Offset = (Location - Origin) * FVector(1.f, 1.f, 0.f);
+	const float AlongLine = FMath::Clamp(FVector::DotProduct(Offset, Forward), 0.f, Length);
+
+	return FVector::DistSquared(Offset, Forward * AlongLine) <= FMath::Square(Radius);
+}
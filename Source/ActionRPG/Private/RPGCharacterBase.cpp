@@ -2,6 +2,8 @@
 
 #include "RPGCharacterBase.h"
 #include "Items/RPGItem.h"
+#include "RPGAssetManager.h"
+#include "RPGCharacterGridSubsystem.h"
 #include "AbilitySystemGlobals.h"
 #include "Abilities/RPGGameplayAbility.h"
 
@@ -16,6 +18,30 @@ ARPGCharacterBase::ARPGCharacterBase()
 
 	CharacterLevel = 1;
 	bAbilitiesInitialized = false;
+	CooldownCacheMaxAge = 0.5f;
+}
+
+void ARPGCharacterBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Make this character visible to native area target types
+	URPGCharacterGridSubsystem* Grid = GetWorld()->GetSubsystem<URPGCharacterGridSubsystem>();
+	if (Grid)
+	{
+		Grid->RegisterCharacter(this);
+	}
+}
+
+void ARPGCharacterBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	URPGCharacterGridSubsystem* Grid = GetWorld()->GetSubsystem<URPGCharacterGridSubsystem>();
+	if (Grid)
+	{
+		Grid->UnregisterCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 UAbilitySystemComponent* ARPGCharacterBase::GetAbilitySystemComponent() const
@@ -87,59 +113,133 @@ void ARPGCharacterBase::RemoveStartupGameplayAbilities()
 	}
 }
 
-void ARPGCharacterBase::OnItemSlotChanged(FRPGItemSlot ItemSlot, URPGItem* Item)
+void ARPGCharacterBase::OnInventoryChangeSet(const FRPGInventoryChangeSet& ChangeSet)
 {
-	RefreshSlottedGameplayAbilities();
+	if (ChangeSet.ChangedSlots.Num() > 0)
+	{
+		RefreshSlottedGameplayAbilitiesForSlots(ChangeSet.ChangedSlots);
+	}
 }
 
 void ARPGCharacterBase::RefreshSlottedGameplayAbilities()
 {
 	if (bAbilitiesInitialized)
 	{
-		// Refresh any invalid abilities and adds new ones
-		RemoveSlottedGameplayAbilities(false);
-		AddSlottedGameplayAbilities();
+		TMap<FRPGItemSlot, FGameplayAbilitySpec> SlottedAbilitySpecs;
+		FillSlottedAbilitySpecs(SlottedAbilitySpecs);
+
+		// Fix up slots we already granted for, this removes ones that are no longer desired
+		for (TPair<FRPGItemSlot, FGameplayAbilitySpecHandle>& ExistingPair : SlottedAbilities)
+		{
+			ApplySlottedAbilitySpec(ExistingPair.Value, SlottedAbilitySpecs.Find(ExistingPair.Key));
+		}
+
+		// Then grant for slots we have never seen, SlottedAbilities is only added to once the loop above is done
+		for (const TPair<FRPGItemSlot, FGameplayAbilitySpec>& SpecPair : SlottedAbilitySpecs)
+		{
+			if (!SlottedAbilities.Contains(SpecPair.Key))
+			{
+				ApplySlottedAbilitySpec(SlottedAbilities.Add(SpecPair.Key), &SpecPair.Value);
+			}
+		}
 	}
 }
 
-void ARPGCharacterBase::FillSlottedAbilitySpecs(TMap<FRPGItemSlot, FGameplayAbilitySpec>& SlottedAbilitySpecs)
+void ARPGCharacterBase::RefreshSlottedGameplayAbilitiesForSlots(const TArray<FRPGItemSlot>& ItemSlots)
 {
-	// First add default ones
-	for (const TPair<FRPGItemSlot, TSubclassOf<URPGGameplayAbility>>& DefaultPair : DefaultSlottedAbilities)
+	if (bAbilitiesInitialized)
 	{
-		if (DefaultPair.Value.Get())
+		for (const FRPGItemSlot& ItemSlot : ItemSlots)
 		{
-			SlottedAbilitySpecs.Add(DefaultPair.Key, FGameplayAbilitySpec(DefaultPair.Value, GetCharacterLevel(), INDEX_NONE, this));
+			FGameplayAbilitySpec DesiredSpec;
+			const bool bHasSpec = FindSlottedAbilitySpec(ItemSlot, DesiredSpec);
+			FGameplayAbilitySpecHandle* ExistingHandle = SlottedAbilities.Find(ItemSlot);
+
+			if (ExistingHandle)
+			{
+				ApplySlottedAbilitySpec(*ExistingHandle, bHasSpec ? &DesiredSpec : nullptr);
+			}
+			else if (bHasSpec)
+			{
+				ApplySlottedAbilitySpec(SlottedAbilities.Add(ItemSlot), &DesiredSpec);
+			}
 		}
 	}
+}
 
-	// Now potentially override with inventory
-	if (InventorySource)
-	{
-		const TMap<FRPGItemSlot, URPGItem*>& SlottedItemMap = InventorySource->GetSlottedItemMap();
+void ARPGCharacterBase::ApplySlottedAbilitySpec(FGameplayAbilitySpecHandle& SpecHandle, const FGameplayAbilitySpec* DesiredSpec)
+{
+	FGameplayAbilitySpec* FoundSpec = SpecHandle.IsValid() ? AbilitySystemComponent->FindAbilitySpecFromHandle(SpecHandle) : nullptr;
 
-		for (const TPair<FRPGItemSlot, URPGItem*>& ItemPair : SlottedItemMap)
+	if (FoundSpec && DesiredSpec && DesiredSpec->Ability == FoundSpec->Ability && DesiredSpec->SourceObject == FoundSpec->SourceObject)
+	{
+		// Same ability from the same source, leave the granted spec alone unless the level moved
+		if (FoundSpec->Level != DesiredSpec->Level)
 		{
-			URPGItem* SlottedItem = ItemPair.Value;
+			FoundSpec->Level = DesiredSpec->Level;
+			AbilitySystemComponent->MarkAbilitySpecDirty(*FoundSpec);
+		}
+		return;
+	}
 
-			// Use the character level as default
-			int32 AbilityLevel = GetCharacterLevel();
+	if (FoundSpec)
+	{
+		// Need to remove registered ability
+		AbilitySystemComponent->ClearAbility(SpecHandle);
+	}
 
-			if (SlottedItem && SlottedItem->ItemType.GetName() == FName(TEXT("Weapon")))
-			{
-				// Override the ability level to use the data from the slotted item
-				AbilityLevel = SlottedItem->AbilityLevel;
-			}
+	// Written through the handle, so callers iterating SlottedAbilities keep a valid map. Cleared even if the ability wasn't found
+	SpecHandle = DesiredSpec ? AbilitySystemComponent->GiveAbility(*DesiredSpec) : FGameplayAbilitySpecHandle();
+}
 
-			if (SlottedItem && SlottedItem->GrantedAbility)
+void ARPGCharacterBase::FillSlottedAbilitySpecs(TMap<FRPGItemSlot, FGameplayAbilitySpec>& SlottedAbilitySpecs)
+{
+	// Every slot with a default or an item, FindSlottedAbilitySpec decides which one wins
+	FGameplayAbilitySpec SlotSpec;
+
+	for (const TPair<FRPGItemSlot, TSubclassOf<URPGGameplayAbility>>& DefaultPair : DefaultSlottedAbilities)
+	{
+		if (FindSlottedAbilitySpec(DefaultPair.Key, SlotSpec))
+		{
+			SlottedAbilitySpecs.Add(DefaultPair.Key, SlotSpec);
+		}
+	}
+
+	if (InventorySource)
+	{
+		for (const TPair<FRPGItemSlot, URPGItem*>& ItemPair : InventorySource->GetSlottedItemMap())
+		{
+			if (!SlottedAbilitySpecs.Contains(ItemPair.Key) && FindSlottedAbilitySpec(ItemPair.Key, SlotSpec))
 			{
-				// This will override anything from default
-				SlottedAbilitySpecs.Add(ItemPair.Key, FGameplayAbilitySpec(SlottedItem->GrantedAbility, AbilityLevel, INDEX_NONE, SlottedItem));
+				SlottedAbilitySpecs.Add(ItemPair.Key, SlotSpec);
 			}
 		}
 	}
 }
 
+bool ARPGCharacterBase::FindSlottedAbilitySpec(const FRPGItemSlot& ItemSlot, FGameplayAbilitySpec& OutSpec)
+{
+	// Inventory overrides default
+	URPGItem* SlottedItem = InventorySource ? InventorySource->GetSlottedItemMap().FindRef(ItemSlot) : nullptr;
+
+	if (SlottedItem && SlottedItem->GrantedAbility)
+	{
+		int32 AbilityLevel = SlottedItem->ItemType == URPGAssetManager::WeaponItemType ? SlottedItem->AbilityLevel : GetCharacterLevel();
+		OutSpec = FGameplayAbilitySpec(SlottedItem->GrantedAbility, AbilityLevel, INDEX_NONE, SlottedItem);
+		return true;
+	}
+
+	const TSubclassOf<URPGGameplayAbility>* DefaultAbility = DefaultSlottedAbilities.Find(ItemSlot);
+
+	if (DefaultAbility && DefaultAbility->Get())
+	{
+		OutSpec = FGameplayAbilitySpec(*DefaultAbility, GetCharacterLevel(), INDEX_NONE, this);
+		return true;
+	}
+
+	return false;
+}
+
 void ARPGCharacterBase::AddSlottedGameplayAbilities()
 {
 	TMap<FRPGItemSlot, FGameplayAbilitySpec> SlottedAbilitySpecs;
@@ -206,7 +306,7 @@ void ARPGCharacterBase::PossessedBy(AController* NewController)
 
 	if (InventorySource)
 	{
-		InventoryUpdateHandle = InventorySource->GetSlottedItemChangedDelegate().AddUObject(this, &ARPGCharacterBase::OnItemSlotChanged);
+		InventoryUpdateHandle = InventorySource->GetInventoryChangeSetDelegate().AddUObject(this, &ARPGCharacterBase::OnInventoryChangeSet);
 		InventoryLoadedHandle = InventorySource->GetInventoryLoadedDelegate().AddUObject(this, &ARPGCharacterBase::RefreshSlottedGameplayAbilities);
 	}
 
@@ -223,7 +323,7 @@ void ARPGCharacterBase::UnPossessed()
 	// Unmap from inventory source
 	if (InventorySource && InventoryUpdateHandle.IsValid())
 	{
-		InventorySource->GetSlottedItemChangedDelegate().Remove(InventoryUpdateHandle);
+		InventorySource->GetInventoryChangeSetDelegate().Remove(InventoryUpdateHandle);
 		InventoryUpdateHandle.Reset();
 
 		InventorySource->GetInventoryLoadedDelegate().Remove(InventoryLoadedHandle);
@@ -341,7 +441,7 @@ bool ARPGCharacterBase::ActivateAbilitiesWithTags(FGameplayTagContainer AbilityT
 	return false;
 }
 
-void ARPGCharacterBase::GetActiveAbilitiesWithTags(FGameplayTagContainer AbilityTags, TArray<URPGGameplayAbility*>& ActiveAbilities)
+void ARPGCharacterBase::GetActiveAbilitiesWithTags(const FGameplayTagContainer& AbilityTags, TArray<URPGGameplayAbility*>& ActiveAbilities)
 {
 	if (AbilitySystemComponent)
 	{
@@ -349,13 +449,90 @@ void ARPGCharacterBase::GetActiveAbilitiesWithTags(FGameplayTagContainer Ability
 	}
 }
 
+bool ARPGCharacterBase::HasActiveAbilityWithTags(const FGameplayTagContainer& AbilityTags) const
+{
+	if (AbilitySystemComponent)
+	{
+		return AbilitySystemComponent->HasActiveAbilityWithAllTags(AbilityTags);
+	}
+	return false;
+}
+
 bool ARPGCharacterBase::GetCooldownRemainingForTag(FGameplayTagContainer CooldownTags, float& TimeRemaining, float& CooldownDuration)
 {
-	if (AbilitySystemComponent && CooldownTags.Num() > 0)
+	TimeRemaining = 0.f;
+	CooldownDuration = 0.f;
+
+	if (!AbilitySystemComponent || CooldownTags.Num() == 0)
+	{
+		return false;
+	}
+
+	UWorld* World = GetWorld();
+
+	if (!World || CooldownCacheMaxAge <= 0.f)
+	{
+		return QueryCooldownRemainingForTag(CooldownTags, TimeRemaining, CooldownDuration);
+	}
+
+	const float CurrentTime = World->GetTimeSeconds();
+	const uint32 EffectsGeneration = AbilitySystemComponent->GetActiveEffectsGeneration();
+	const uint32 TagsHash = GetCooldownTagsHash(CooldownTags);
+
+	// Expired entries would be queried again anyway, dropping them keeps the cache down to the tags that are still being polled
+	CooldownCache.RemoveAllSwap([this, CurrentTime](const FRPGCooldownCacheEntry& Existing)
+	{
+		return CurrentTime - Existing.QueryTime > CooldownCacheMaxAge;
+	});
+
+	FRPGCooldownCacheEntry* Entry = CooldownCache.FindByPredicate([&](const FRPGCooldownCacheEntry& Existing)
+	{
+		return Existing.TagsHash == TagsHash && Existing.CooldownTags == CooldownTags;
+	});
+
+	if (Entry && Entry->EffectsGeneration == EffectsGeneration && CurrentTime - Entry->QueryTime <= CooldownCacheMaxAge)
 	{
-		TimeRemaining = 0.f;
-		CooldownDuration = 0.f;
+		// No effect was added or removed, so the cooldown just kept counting down
+		TimeRemaining = FMath::Max(Entry->TimeRemaining - (CurrentTime - Entry->QueryTime), 0.f);
+		CooldownDuration = Entry->CooldownDuration;
+		return Entry->bFoundCooldown;
+	}
+
+	if (!Entry)
+	{
+		Entry = &CooldownCache.AddDefaulted_GetRef();
+		Entry->CooldownTags = CooldownTags;
+		Entry->TagsHash = TagsHash;
+	}
 
+	Entry->EffectsGeneration = EffectsGeneration;
+	Entry->QueryTime = CurrentTime;
+	Entry->bFoundCooldown = QueryCooldownRemainingForTag(CooldownTags, Entry->TimeRemaining, Entry->CooldownDuration);
+
+	TimeRemaining = Entry->TimeRemaining;
+	CooldownDuration = Entry->CooldownDuration;
+	return Entry->bFoundCooldown;
+}
+
+uint32 ARPGCharacterBase::GetCooldownTagsHash(const FGameplayTagContainer& CooldownTags)
+{
+	uint32 Hash = 0;
+
+	// Order independent, the container compare ignores order as well
+	for (const FGameplayTag& Tag : CooldownTags)
+	{
+		Hash += GetTypeHash(Tag);
+	}
+	return Hash;
+}
+
+bool ARPGCharacterBase::QueryCooldownRemainingForTag(const FGameplayTagContainer& CooldownTags, float& TimeRemaining, float& CooldownDuration) const
+{
+	TimeRemaining = 0.f;
+	CooldownDuration = 0.f;
+
+	if (AbilitySystemComponent && CooldownTags.Num() > 0)
+	{
 		FGameplayEffectQuery const Query = FGameplayEffectQuery::MakeQuery_MatchAnyOwningTags(CooldownTags);
 		TArray< TPair<float, float> > DurationAndTimeRemaining = AbilitySystemComponent->GetActiveEffectsTimeRemainingAndDuration(Query);
 		if (DurationAndTimeRemaining.Num() > 0)
@@ -0,0 +1,69 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "RPGCharacterGridSubsystem.h"
+#include "RPGCharacterBase.h"
+
+void URPGCharacterGridSubsystem::Tick(float DeltaTime)
+{
+	for (TMap<TWeakObjectPtr<ARPGCharacterBase>, FIntPoint>::TIterator It = CharacterCells.CreateIterator(); It; ++It)
+	{
+		ARPGCharacterBase* Character = It.Key().Get();
+
+		if (!Character)
+		{
+			// Destroyed without going through EndPlay
+			RemoveFromCell(It.Key(), It.Value());
+			It.RemoveCurrent();
+			continue;
+		}
+
+		const FIntPoint NewCell = GetCell(FVector2D(Character->GetActorLocation()));
+
+		// Most characters stay inside their cell between frames, so this is usually just the compare
+		if (NewCell != It.Value())
+		{
+			RemoveFromCell(It.Key(), It.Value());
+			AddToCell(It.Key(), NewCell);
+			It.Value() = NewCell;
+		}
+	}
+}
+
+TStatId URPGCharacterGridSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URPGCharacterGridSubsystem, STATGROUP_Tickables);
+}
+
+void URPGCharacterGridSubsystem::RegisterCharacter(ARPGCharacterBase* Character)
+{
+	if (Character && !CharacterCells.Contains(Character))
+	{
+		const FIntPoint Cell = GetCell(FVector2D(Character->GetActorLocation()));
+		CharacterCells.Add(Character, Cell);
+		AddToCell(Character, Cell);
+	}
+}
+
+void URPGCharacterGridSubsystem::UnregisterCharacter(ARPGCharacterBase* Character)
+{
+	FIntPoint Cell;
+	if (CharacterCells.RemoveAndCopyValue(Character, Cell))
+	{
+		RemoveFromCell(Character, Cell);
+	}
+}
+
+void URPGCharacterGridSubsystem::RemoveFromCell(const TWeakObjectPtr<ARPGCharacterBase>& Character, const FIntPoint& Cell)
+{
+	TArray<TWeakObjectPtr<ARPGCharacterBase>>* CellCharacters = Cells.Find(Cell);
+	if (CellCharacters)
+	{
+		// Empty cells are kept, characters walking back and forth over a boundary would otherwise reallocate them
+		CellCharacters->RemoveSingleSwap(Character, false);
+	}
+}
+
+void URPGCharacterGridSubsystem::AddToCell(const TWeakObjectPtr<ARPGCharacterBase>& Character, const FIntPoint& Cell)
+{
+	Cells.FindOrAdd(Cell).Add(Character);
+}
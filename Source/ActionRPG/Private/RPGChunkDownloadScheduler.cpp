@@ -0,0 +1,370 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "RPGChunkDownloadScheduler.h"
+#include "ChunkDownloader.h"
+#include "HAL/FileManager.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+
+FRPGChunkDownloadScheduler::FRPGChunkDownloadScheduler(int32 InMinDownloadsInFlight, int32 InMaxDownloadsInFlight)
+	: MinDownloadsInFlight(FMath::Max(InMinDownloadsInFlight, 1))
+	, MaxDownloadsInFlight(FMath::Max(InMaxDownloadsInFlight, InMinDownloadsInFlight))
+	, NextQueueOrder(0)
+	, bRunning(false)
+	, bAnyFailed(false)
+	, StartTime(0.0)
+	, FinishTime(0.0)
+	, LastAdaptTime(0.0)
+	, LastThroughput(0.0)
+{
+	// Start in the middle, the first samples move it quickly in either direction
+	DownloadsInFlightTarget = FMath::Clamp((MinDownloadsInFlight + MaxDownloadsInFlight) / 2, MinDownloadsInFlight, MaxDownloadsInFlight);
+}
+
+void FRPGChunkDownloadScheduler::QueueChunk(int32 ChunkId, int32 Priority)
+{
+	if (DownloadingChunks.Contains(ChunkId) || MountingChunks.Contains(ChunkId))
+	{
+		return;
+	}
+
+	FQueuedChunk* Existing = QueuedChunks.FindByPredicate([ChunkId](const FQueuedChunk& Queued) { return Queued.ChunkId == ChunkId; });
+	if (Existing)
+	{
+		Existing->Priority = Priority;
+	}
+	else
+	{
+		QueuedChunks.Add({ ChunkId, Priority, NextQueueOrder++ });
+	}
+
+	FChunkRecord& Record = FindOrAddRecord(ChunkId);
+	Record.Priority = Priority;
+	Record.State = ERPGChunkPatchState::Queued;
+
+	// Lowest priority first so the next chunk can be popped off the end
+	QueuedChunks.Sort([](const FQueuedChunk& A, const FQueuedChunk& B)
+	{
+		return A.Priority != B.Priority ? A.Priority < B.Priority : A.QueueOrder > B.QueueOrder;
+	});
+
+	if (bRunning)
+	{
+		IssueDownloads();
+	}
+}
+
+void FRPGChunkDownloadScheduler::Start()
+{
+	if (bRunning)
+	{
+		return;
+	}
+
+	TSharedRef<FChunkDownloader> Downloader = FChunkDownloader::GetChecked();
+
+	bRunning = true;
+	bAnyFailed = false;
+	StartTime = FPlatformTime::Seconds();
+	FinishTime = 0.0;
+	LastAdaptTime = StartTime;
+	LastThroughput = 0.0;
+
+	ThroughputSamples.Reset();
+	ThroughputSamples.Add({ StartTime, (int64)Downloader->GetLoadingStats().BytesDownloaded });
+
+	Downloader->SetTargetDownloadsInFlight(DownloadsInFlightTarget);
+	IssueDownloads();
+	CheckFinished();
+}
+
+void FRPGChunkDownloadScheduler::Cancel()
+{
+	bRunning = false;
+	QueuedChunks.Reset();
+	DownloadingChunks.Reset();
+	MountingChunks.Reset();
+}
+
+void FRPGChunkDownloadScheduler::GetProgress(FRPGPatchProgress& OutProgress)
+{
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	TSharedPtr<FChunkDownloader> Downloader = FChunkDownloader::Get();
+	if (Downloader.IsValid())
+	{
+		if (bRunning)
+		{
+			SampleThroughput();
+		}
+
+		const FChunkDownloader::FStats& LoadingStats = Downloader->GetLoadingStats();
+		OutProgress.BytesDownloaded = LoadingStats.BytesDownloaded;
+		OutProgress.TotalBytesToDownload = LoadingStats.TotalBytesToDownload;
+		OutProgress.ChunksMounted = LoadingStats.ChunksMounted;
+		OutProgress.TotalChunksToMount = LoadingStats.TotalChunksToMount;
+	}
+
+	// Totals are 0 when everything was already cached, which counts as done rather than dividing by zero
+	OutProgress.DownloadPercent = OutProgress.TotalBytesToDownload > 0 ? 100.f * (float)((double)OutProgress.BytesDownloaded / (double)OutProgress.TotalBytesToDownload) : 100.f;
+	OutProgress.MountPercent = OutProgress.TotalChunksToMount > 0 ? 100.f * (float)OutProgress.ChunksMounted / (float)OutProgress.TotalChunksToMount : 100.f;
+
+	const double BytesPerSecond = bRunning ? GetBytesPerSecond() : 0.0;
+	const int64 BytesRemaining = FMath::Max<int64>(OutProgress.TotalBytesToDownload - OutProgress.BytesDownloaded, 0);
+	OutProgress.BytesPerSecond = (float)BytesPerSecond;
+
+	if (BytesRemaining == 0)
+	{
+		OutProgress.EstimatedSecondsRemaining = 0.f;
+	}
+	else
+	{
+		OutProgress.EstimatedSecondsRemaining = BytesPerSecond > 0.0 ? (float)(BytesRemaining / BytesPerSecond) : -1.f;
+	}
+
+	OutProgress.ElapsedSeconds = StartTime > 0.0 ? (float)((FinishTime > 0.0 ? FinishTime : CurrentTime) - StartTime) : 0.f;
+
+	OutProgress.Chunks.Reset(ChunkRecords.Num());
+	for (const FChunkRecord& Record : ChunkRecords)
+	{
+		FRPGChunkPatchProgress& ChunkProgress = OutProgress.Chunks.AddDefaulted_GetRef();
+		ChunkProgress.ChunkId = Record.ChunkId;
+		ChunkProgress.Priority = Record.Priority;
+		ChunkProgress.State = Record.State;
+
+		if (Record.DownloadStartTime > 0.0)
+		{
+			const double DownloadEnd = Record.DownloadEndTime > 0.0 ? Record.DownloadEndTime : CurrentTime;
+			ChunkProgress.DownloadSeconds = (float)(DownloadEnd - Record.DownloadStartTime);
+		}
+		if (Record.DownloadEndTime > 0.0 && Record.State != ERPGChunkPatchState::Failed)
+		{
+			const double MountEnd = Record.MountEndTime > 0.0 ? Record.MountEndTime : CurrentTime;
+			ChunkProgress.MountSeconds = (float)(MountEnd - Record.DownloadEndTime);
+		}
+	}
+}
+
+double FRPGChunkDownloadScheduler::GetBytesPerSecond() const
+{
+	if (ThroughputSamples.Num() < 2)
+	{
+		return 0.0;
+	}
+
+	const FThroughputSample& Oldest = ThroughputSamples[0];
+	const FThroughputSample& Newest = ThroughputSamples.Last();
+	const double Elapsed = Newest.Time - Oldest.Time;
+
+	return Elapsed > 0.0 ? (Newest.Bytes - Oldest.Bytes) / Elapsed : 0.0;
+}
+
+bool FRPGChunkDownloadScheduler::WriteTimingsCsv(const FString& Filename) const
+{
+	FString Csv;
+
+	if (!IFileManager::Get().FileExists(*Filename))
+	{
+		Csv += TEXT("Date,BuildVersion,ChunkId,Priority,State,StartSeconds,DownloadSeconds,MountSeconds,BytesDownloaded,DownloadsInFlight\n");
+	}
+
+	const FString Date = FDateTime::UtcNow().ToIso8601();
+	const FString BuildVersion = FApp::GetBuildVersion();
+	const UEnum* StateEnum = StaticEnum<ERPGChunkPatchState>();
+
+	for (const FChunkRecord& Record : ChunkRecords)
+	{
+		const double StartSeconds = Record.DownloadStartTime > 0.0 ? Record.DownloadStartTime - StartTime : 0.0;
+		const double DownloadSeconds = Record.DownloadEndTime > 0.0 ? Record.DownloadEndTime - Record.DownloadStartTime : 0.0;
+		const double MountSeconds = Record.MountEndTime > 0.0 ? Record.MountEndTime - Record.DownloadEndTime : 0.0;
+
+		Csv += FString::Printf(TEXT("%s,%s,%d,%d,%s,%.3f,%.3f,%.3f,,\n"), *Date, *BuildVersion, Record.ChunkId, Record.Priority,
+			*StateEnum->GetNameStringByValue((int64)Record.State), StartSeconds, DownloadSeconds, MountSeconds);
+	}
+
+	// Summary row for the whole patch, chunk downloads overlap so the per chunk times do not add up to it
+	int64 BytesDownloaded = 0;
+	TSharedPtr<FChunkDownloader> Downloader = FChunkDownloader::Get();
+	if (Downloader.IsValid())
+	{
+		BytesDownloaded = Downloader->GetLoadingStats().BytesDownloaded;
+	}
+
+	const double TotalSeconds = StartTime > 0.0 ? (FinishTime > 0.0 ? FinishTime : FPlatformTime::Seconds()) - StartTime : 0.0;
+	Csv += FString::Printf(TEXT("%s,%s,All,,%s,0.000,%.3f,,%lld,%d\n"), *Date, *BuildVersion, bAnyFailed ? TEXT("Failed") : TEXT("Mounted"),
+		TotalSeconds, BytesDownloaded, DownloadsInFlightTarget);
+
+	return FFileHelper::SaveStringToFile(Csv, *Filename, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append);
+}
+
+FRPGChunkDownloadScheduler::FChunkRecord& FRPGChunkDownloadScheduler::FindOrAddRecord(int32 ChunkId)
+{
+	FChunkRecord* Record = ChunkRecords.FindByPredicate([ChunkId](const FChunkRecord& Existing) { return Existing.ChunkId == ChunkId; });
+	if (Record)
+	{
+		return *Record;
+	}
+
+	return ChunkRecords.Add_GetRef({ ChunkId, 0, ERPGChunkPatchState::Queued, 0.0, 0.0, 0.0 });
+}
+
+void FRPGChunkDownloadScheduler::SampleThroughput()
+{
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	if (ThroughputSamples.Num() > 0 && CurrentTime - ThroughputSamples.Last().Time < SampleInterval)
+	{
+		return;
+	}
+
+	ThroughputSamples.Add({ CurrentTime, (int64)FChunkDownloader::GetChecked()->GetLoadingStats().BytesDownloaded });
+
+	// Keep one sample at or beyond the window edge so the average always covers the full window
+	int32 NumExpired = 0;
+	while (NumExpired + 1 < ThroughputSamples.Num() && CurrentTime - ThroughputSamples[NumExpired + 1].Time >= ThroughputWindow)
+	{
+		NumExpired++;
+	}
+
+	if (NumExpired > 0)
+	{
+		ThroughputSamples.RemoveAt(0, NumExpired, false);
+	}
+}
+
+void FRPGChunkDownloadScheduler::IssueDownloads()
+{
+	TSharedRef<FChunkDownloader> Downloader = FChunkDownloader::GetChecked();
+	TWeakPtr<FRPGChunkDownloadScheduler> WeakThis = AsShared();
+
+	while (bRunning && QueuedChunks.Num() > 0 && DownloadingChunks.Num() < DownloadsInFlightTarget)
+	{
+		const FQueuedChunk Next = QueuedChunks.Pop(false);
+		DownloadingChunks.Add(Next.ChunkId);
+
+		FChunkRecord& Record = FindOrAddRecord(Next.ChunkId);
+		Record.State = ERPGChunkPatchState::Downloading;
+		Record.DownloadStartTime = FPlatformTime::Seconds();
+
+		// Cached chunks complete right away, mounted ones are reported as mounted by HandleChunkDownloaded
+		Downloader->DownloadChunk(Next.ChunkId, [WeakThis, ChunkId = Next.ChunkId](bool bSuccess)
+		{
+			TSharedPtr<FRPGChunkDownloadScheduler> PinnedThis = WeakThis.Pin();
+			if (PinnedThis.IsValid())
+			{
+				PinnedThis->HandleChunkDownloaded(ChunkId, bSuccess);
+			}
+		}, Next.Priority);
+	}
+}
+
+void FRPGChunkDownloadScheduler::HandleChunkDownloaded(int32 ChunkId, bool bSuccess)
+{
+	if (!bRunning || DownloadingChunks.Remove(ChunkId) == 0)
+	{
+		return;
+	}
+
+	FChunkRecord& Record = FindOrAddRecord(ChunkId);
+	Record.DownloadEndTime = FPlatformTime::Seconds();
+
+	UpdateDownloadsInFlightTarget();
+
+	if (!bSuccess)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("FRPGChunkDownloadScheduler: Chunk %d failed to download"), ChunkId);
+		Record.State = ERPGChunkPatchState::Failed;
+		bAnyFailed = true;
+		OnChunkMounted.ExecuteIfBound(ChunkId, false);
+	}
+	else
+	{
+		// Mount right away so content in this chunk is usable before the rest of the batch lands
+		Record.State = ERPGChunkPatchState::Mounting;
+		MountingChunks.Add(ChunkId);
+
+		TWeakPtr<FRPGChunkDownloadScheduler> WeakThis = AsShared();
+		FChunkDownloader::GetChecked()->MountChunk(ChunkId, [WeakThis, ChunkId](bool bMountSuccess)
+		{
+			TSharedPtr<FRPGChunkDownloadScheduler> PinnedThis = WeakThis.Pin();
+			if (PinnedThis.IsValid())
+			{
+				PinnedThis->HandleChunkMounted(ChunkId, bMountSuccess);
+			}
+		});
+	}
+
+	IssueDownloads();
+	CheckFinished();
+}
+
+void FRPGChunkDownloadScheduler::HandleChunkMounted(int32 ChunkId, bool bSuccess)
+{
+	if (!bRunning || MountingChunks.Remove(ChunkId) == 0)
+	{
+		return;
+	}
+
+	FChunkRecord& Record = FindOrAddRecord(ChunkId);
+	Record.MountEndTime = FPlatformTime::Seconds();
+	Record.State = bSuccess ? ERPGChunkPatchState::Mounted : ERPGChunkPatchState::Failed;
+
+	if (!bSuccess)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("FRPGChunkDownloadScheduler: Chunk %d failed to mount"), ChunkId);
+		bAnyFailed = true;
+	}
+
+	OnChunkMounted.ExecuteIfBound(ChunkId, bSuccess);
+	CheckFinished();
+}
+
+void FRPGChunkDownloadScheduler::UpdateDownloadsInFlightTarget()
+{
+	SampleThroughput();
+
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	if (CurrentTime - LastAdaptTime < AdaptInterval)
+	{
+		return;
+	}
+
+	// The windowed rate smooths over the gaps between chunks that a rate measured since the last adjustment would react to
+	const double Throughput = GetBytesPerSecond();
+	const int32 OldTarget = DownloadsInFlightTarget;
+
+	if (Throughput < SlowLinkBytesPerSecond)
+	{
+		// Parallel downloads only split a slow link, which delays the highest priority chunk
+		DownloadsInFlightTarget = MinDownloadsInFlight;
+	}
+	else if (LastThroughput <= 0.0 || Throughput > LastThroughput * 1.1)
+	{
+		DownloadsInFlightTarget = FMath::Min(DownloadsInFlightTarget + 1, MaxDownloadsInFlight);
+	}
+	else if (Throughput < LastThroughput * 0.8)
+	{
+		DownloadsInFlightTarget = FMath::Max(DownloadsInFlightTarget - 1, MinDownloadsInFlight);
+	}
+
+	if (DownloadsInFlightTarget != OldTarget)
+	{
+		UE_LOG(LogActionRPG, Verbose, TEXT("FRPGChunkDownloadScheduler: %.0f bytes/s, downloads in flight %d -> %d"), Throughput, OldTarget, DownloadsInFlightTarget);
+		FChunkDownloader::GetChecked()->SetTargetDownloadsInFlight(DownloadsInFlightTarget);
+	}
+
+	LastAdaptTime = CurrentTime;
+	LastThroughput = Throughput;
+}
+
+void FRPGChunkDownloadScheduler::CheckFinished()
+{
+	if (bRunning && QueuedChunks.Num() == 0 && DownloadingChunks.Num() == 0 && MountingChunks.Num() == 0)
+	{
+		bRunning = false;
+		FinishTime = FPlatformTime::Seconds();
+		OnAllChunksMounted.ExecuteIfBound(!bAnyFailed);
+	}
+}
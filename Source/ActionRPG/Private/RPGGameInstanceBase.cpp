@@ -4,6 +4,7 @@
 
 /** 访问ChunkDownloader，以及一些用于管理资产和委托的有用工具 */
 #include "ChunkDownloader.h"
+#include "RPGChunkDownloadScheduler.h"
 #include "Misc/CoreDelegates.h"
 #include "AssetRegistry/AssetRegistryModule.h"
 #include "Serialization/JsonSerializerMacros.h"
@@ -12,14 +13,45 @@
 #include "RPGSaveGame.h"
 #include "Items/RPGItem.h"
 #include "Kismet/GameplayStatics.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/NameAsStringProxyArchive.h"
+
+/** Header written at the start of every inventory journal file */
+static const uint32 InventoryJournalMagic = 0x4A565052; // 'RPVJ'
+static const int32 InventoryJournalVersion = 1;
 
 URPGGameInstanceBase::URPGGameInstanceBase()
 	: SaveSlot(TEXT("SaveGame"))
 	, SaveUserIndex(0)
+	, bUseInventoryJournal(true)
+	, SaveGameCompression(ERPGSaveGameCompression::None)
+	, bLoadSaveGameAsyncOnInit(false)
+	, MaxInventoryJournalEntries(256)
+	, InventoryJournalCompactInterval(60.f)
+	, InventoryJournalEntriesSinceSnapshot(0)
+	, InventoryJournalOldestEntryTime(0.0)
+	, bSaveGameLoadInProgress(false)
+	, SaveGameLoadSerial(0)
+	, SaveGameLoadStartTime(0.0)
+	, bCurrentSaveGameLoaded(false)
+	, bSaveSlotCorrupt(false)
+	, MinChunkDownloadsInFlight(1)
+	, MaxChunkDownloadsInFlight(8)
+	, bRecordPatchTimings(false)
 {}
 
 void URPGGameInstanceBase::Init()
 {
+	// Start before the blueprint Init event so the native async load is what provides the save game, a load the blueprint finishes later still replaces it
+	if (bLoadSaveGameAsyncOnInit)
+	{
+		LoadOrCreateSaveGameAsyncNative(FOnSaveGameLoadCompleteNative());
+	}
+
 	Super::Init();
 
 	/** 执行以下步骤可确保ChunkDownloader已初始化，准备开始下载内容，并告知其他函数清单的状态。 */
@@ -33,10 +65,23 @@ void URPGGameInstanceBase::Init()
 	const FString DeploymentName = "PatchingLive";
 	const FString ContentBuildId = "PatchingKey";
 
+	// Testing against a local static file server, e.g. -ChunkCdnUrl=http://127.0.0.1:8000/PatchingCDN
+	FString CdnUrlOverride;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ChunkCdnUrl="), CdnUrlOverride))
+	{
+		GConfig->SetArray(*(TEXT("/Script/Plugins.ChunkDownloader ") + DeploymentName), TEXT("CdnBaseUrls"), { CdnUrlOverride }, GGameIni);
+	}
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("RecordPatchTimings")))
+	{
+		bRecordPatchTimings = true;
+	}
+
 	// 用选定平台初始化文件块下载器
 	TSharedRef<FChunkDownloader> Downloader = FChunkDownloader::GetOrCreate();
-	// 所需平台名称 TargetDownloadsInFlight赋予值 8 ，该值设置ChunkDownloader同时处理的最大下载数量。
-	Downloader->Initialize("Windows", 8);
+	// The scheduler adjusts downloads in flight once patching starts, start at the upper bound for the manifest
+	const FString PlatformName = ChunkDownloadPlatformName.IsEmpty() ? FString(FPlatformProperties::IniPlatformName()) : ChunkDownloadPlatformName;
+	Downloader->Initialize(PlatformName, FMath::Max(MaxChunkDownloadsInFlight, 1));
 
 	// 加载缓存的版本ID 检查磁盘上是否已经下载文件，如果它们是最新清单文件，则ChunkDownloader可以跳过下载流程。
 	Downloader->LoadCachedBuild(DeploymentName);
@@ -52,8 +97,17 @@ void URPGGameInstanceBase::Init()
 
 void URPGGameInstanceBase::Shutdown()
 {
+	WaitForInventoryJournalWrites();
+	FlushSaveGameWrites();
+
 	Super::Shutdown();
 
+	if (ChunkScheduler.IsValid())
+	{
+		ChunkScheduler->Cancel();
+		ChunkScheduler.Reset();
+	}
+
 	// 关闭ChunkDownloader 停止当前正在进行的所有ChunkDownloader下载，然后清理并卸载该模块
 	FChunkDownloader::Shutdown();
 }
@@ -75,8 +129,21 @@ void URPGGameInstanceBase::GetLoadingProgress(int32& BytesDownloaded, int32& Tot
 	TotalChunksToMount = LoadingStats.TotalChunksToMount;
 
 	// 使用以上统计信息计算下载和挂载百分比
-	DownloadPercent = ((float)BytesDownloaded / (float)TotalBytesToDownload) * 100.0f;
-	MountPercent = ((float)ChunksMounted / (float)TotalChunksToMount) * 100.0f;
+	// Totals are 0 when there is nothing to patch, which counts as complete
+	DownloadPercent = LoadingStats.TotalBytesToDownload > 0 ? ((float)((double)LoadingStats.BytesDownloaded / (double)LoadingStats.TotalBytesToDownload)) * 100.0f : 100.0f;
+	MountPercent = TotalChunksToMount > 0 ? ((float)ChunksMounted / (float)TotalChunksToMount) * 100.0f : 100.0f;
+}
+
+FRPGPatchProgress URPGGameInstanceBase::GetPatchProgress() const
+{
+	FRPGPatchProgress Progress;
+
+	if (ChunkScheduler.IsValid())
+	{
+		ChunkScheduler->GetProgress(Progress);
+	}
+
+	return Progress;
 }
 
 bool URPGGameInstanceBase::PatchGame()
@@ -96,12 +163,21 @@ bool URPGGameInstanceBase::PatchGame()
 			UE_LOG(LogTemp, Display, TEXT("Chunk %i status: %i"), ChunkID, ChunkStatus);
 		}
 
-		TFunction<void(bool bSuccess)> DownloadCompleteCallback = [&](bool bSuccess) {
-			// 当每个单独的文件块完成下载时，将调用 当每个文件块成功下载或下载失败时，它将输出一条消息。
-			OnDownloadComplete(bSuccess);
-		};
-		// 开始下载所需文件块，这些文件块在 ChunkDownloadList 中列出。在调用此函数之前，必须用你想要的文件块ID填充此列表
-		Downloader->DownloadChunks(ChunkDownloadList, DownloadCompleteCallback, 1);
+		if (ChunkScheduler.IsValid() && ChunkScheduler->IsRunning())
+		{
+			UE_LOG(LogActionRPG, Warning, TEXT("PatchGame: Already patching"));
+			return true;
+		}
+
+		// Chunks are handed to the downloader in priority order and each one is mounted as soon as it lands
+		ChunkScheduler = MakeShared<FRPGChunkDownloadScheduler>(MinChunkDownloadsInFlight, MaxChunkDownloadsInFlight);
+		ChunkScheduler->OnChunkMounted.BindUObject(this, &URPGGameInstanceBase::HandleChunkMounted);
+		ChunkScheduler->OnAllChunksMounted.BindUObject(this, &URPGGameInstanceBase::OnMountComplete);
+
+		for (int32 ChunkID : ChunkDownloadList)
+		{
+			ChunkScheduler->QueueChunk(ChunkID, ChunkDownloadPriorities.FindRef(ChunkID));
+		}
 
 		// 启动加载模式
 		TFunction<void(bool bSuccess)> LoadingModeCompleteCallback = [&](bool bSuccess) {
@@ -112,7 +188,9 @@ bool URPGGameInstanceBase::PatchGame()
 		// 可以在不调用加载模式的情况下在后台被动下载文件块，使用它将输出下载统计信息，使你可以创建一个可以跟踪用户下载进度的UI。
 		// 下载整批文件块时，你还可以使用该回调函数运行特定功能。
 		Downloader->BeginLoadingMode(LoadingModeCompleteCallback);
-		
+
+		ChunkScheduler->Start();
+
 		return true;
 	}
 
@@ -129,52 +207,40 @@ void URPGGameInstanceBase::OnManifestUpdateComplete(bool bSuccess)
 	bIsDownloadManifestUpToDate = bSuccess;
 }
 
-// 当打包文件已成功下载到用户的设备上时，它将运行。
-void URPGGameInstanceBase::OnDownloadComplete(bool bSuccess)
+void URPGGameInstanceBase::SetChunkDownloadPriority(int32 ChunkId, int32 Priority)
 {
-	if (bSuccess)
-	{
-		UE_LOG(LogTemp, Display, TEXT("Download Complete"));
-
-		// 获取文件块下载器
-		TSharedRef<FChunkDownloader> Downloader = FChunkDownloader::GetChecked();
-		// 用于发出的请求
-		FJsonSerializableArrayInt DownloadedChunks;
-
-		for (int32 ChunkID : ChunkDownloadList)
-		{
-			DownloadedChunks.Add(ChunkID);
-		}
+	ChunkDownloadPriorities.Add(ChunkId, Priority);
 
-		// 挂载文件块
-		// 输出是否已成功应用补丁
-		TFunction<void(bool bSuccess)> MountCompleteCallback = [&](bool bSuccess) {
-			OnMountComplete(bSuccess);
-		};
-		// 开始挂载已下载文件块
-		Downloader->MountChunks(DownloadedChunks, MountCompleteCallback);
-
-		// 如果下载成功，则该函数激活值为true的 OnPatchComplete 委托
-		OnPatchComplete.Broadcast(true);
-	}
-	else
+	// Reorders the chunk if it is still waiting to download
+	if (ChunkScheduler.IsValid() && ChunkScheduler->IsRunning() && ChunkDownloadList.Contains(ChunkId))
 	{
-		UE_LOG(LogTemp, Display, TEXT("Load process failed"));
-
-		// 调用委托
-		// 如果失败，则会以 false 值激活
-		OnPatchComplete.Broadcast(false);
+		ChunkScheduler->QueueChunk(ChunkId, Priority);
 	}
 }
 
 void URPGGameInstanceBase::OnLoadingModeComplete(bool bSuccess)
 {
-	// 将传递给 OnDownloadComplete ，后者将在后续步骤中继续挂载文件块。
-	OnDownloadComplete(bSuccess);
+	// Mounting is driven per chunk by the scheduler, loading mode is only used for the download stats
+	UE_LOG(LogTemp, Display, TEXT("Loading mode complete, success: %d"), bSuccess);
+}
+
+void URPGGameInstanceBase::HandleChunkMounted(int32 ChunkId, bool bSuccess)
+{
+	UE_LOG(LogTemp, Display, TEXT("Chunk %i mounted, success: %d"), ChunkId, bSuccess);
+	OnChunkMounted.Broadcast(ChunkId, bSuccess);
 }
 
 void URPGGameInstanceBase::OnMountComplete(bool bSuccess)
 {
+	if (bRecordPatchTimings && ChunkScheduler.IsValid())
+	{
+		const FString TimingsFilename = FPaths::ProjectSavedDir() / TEXT("Patching") / TEXT("PatchTimings.csv");
+		if (!ChunkScheduler->WriteTimingsCsv(TimingsFilename))
+		{
+			UE_LOG(LogActionRPG, Warning, TEXT("OnMountComplete: Failed to write patch timings to %s"), *TimingsFilename);
+		}
+	}
+
 	// 将指示所有文件块均已完成挂载，并且内容可用。
 	OnPatchComplete.Broadcast(bSuccess);
 }
@@ -225,14 +291,87 @@ bool URPGGameInstanceBase::LoadOrCreateSaveGame()
 {
 	URPGSaveGame* LoadedSave = nullptr;
 
-	if (UGameplayStatics::DoesSaveGameExist(SaveSlot, SaveUserIndex) && bSavingEnabled)
+	if (bSavingEnabled)
 	{
+		// A missing slot just returns null, checking for it first would read the slot twice
+		const double LoadStartTime = FPlatformTime::Seconds();
 		LoadedSave = Cast<URPGSaveGame>(UGameplayStatics::LoadGameFromSlot(SaveSlot, SaveUserIndex));
+		UE_LOG(LogActionRPG, Log, TEXT("LoadOrCreateSaveGame: Blocked the game thread for %.1f ms loading %s"), (FPlatformTime::Seconds() - LoadStartTime) * 1000.0, *SaveSlot);
 	}
 
 	return HandleSaveGameLoaded(LoadedSave);
 }
 
+void URPGGameInstanceBase::LoadOrCreateSaveGameAsync(FOnSaveGameLoadComplete OnComplete)
+{
+	LoadOrCreateSaveGameAsyncNative(FOnSaveGameLoadCompleteNative::CreateLambda([OnComplete](bool bLoaded)
+	{
+		OnComplete.ExecuteIfBound(bLoaded);
+	}));
+}
+
+void URPGGameInstanceBase::LoadOrCreateSaveGameAsyncNative(FOnSaveGameLoadCompleteNative OnComplete)
+{
+	PendingSaveGameLoadCallbacks.Add(OnComplete);
+
+	if (bSaveGameLoadInProgress)
+	{
+		return;
+	}
+
+	if (!bSavingEnabled)
+	{
+		// Nothing to read, creating the default save is cheap
+		CompleteSaveGameLoad(HandleSaveGameLoaded(nullptr));
+		return;
+	}
+
+	bSaveGameLoadInProgress = true;
+	SaveGameLoadStartTime = FPlatformTime::Seconds();
+
+	// Reading and deserializing happen on a worker thread, the result is handed back on the game thread. A missing slot comes back as null and creates a new save
+	UGameplayStatics::AsyncLoadGameFromSlot(SaveSlot, SaveUserIndex, FAsyncLoadGameFromSlotDelegate::CreateUObject(this, &URPGGameInstanceBase::HandleAsyncSaveGameLoaded, SaveGameLoadSerial));
+}
+
+bool URPGGameInstanceBase::IsSaveSlotCorrupt() const
+{
+	return bSaveSlotCorrupt;
+}
+
+bool URPGGameInstanceBase::IsSaveGameLoadInProgress() const
+{
+	return bSaveGameLoadInProgress;
+}
+
+void URPGGameInstanceBase::HandleAsyncSaveGameLoaded(const FString& SlotName, const int32 UserIndex, USaveGame* SaveGameObject, int32 LoadSerial)
+{
+	bSaveGameLoadInProgress = false;
+
+	if (LoadSerial != SaveGameLoadSerial)
+	{
+		// The save game was loaded or reset synchronously in the meantime, that one is newer and is what the callbacks get
+		UE_LOG(LogActionRPG, Verbose, TEXT("HandleAsyncSaveGameLoaded: Discarding load of %s, the save game was replaced while loading"), *SlotName);
+		CompleteSaveGameLoad(bCurrentSaveGameLoaded);
+		return;
+	}
+
+	UE_LOG(LogActionRPG, Log, TEXT("HandleAsyncSaveGameLoaded: Loaded %s in %.1f ms without blocking the game thread"), *SlotName, (FPlatformTime::Seconds() - SaveGameLoadStartTime) * 1000.0);
+
+	CompleteSaveGameLoad(HandleSaveGameLoaded(SaveGameObject));
+}
+
+void URPGGameInstanceBase::CompleteSaveGameLoad(bool bLoaded)
+{
+	// Callbacks may start another load
+	TArray<FOnSaveGameLoadCompleteNative> Callbacks = MoveTemp(PendingSaveGameLoadCallbacks);
+	PendingSaveGameLoadCallbacks.Reset();
+
+	for (FOnSaveGameLoadCompleteNative& Callback : Callbacks)
+	{
+		Callback.ExecuteIfBound(bLoaded);
+	}
+}
+
 bool URPGGameInstanceBase::HandleSaveGameLoaded(USaveGame* SaveGameObject)
 {
 	bool bLoaded = false;
@@ -243,11 +382,25 @@ bool URPGGameInstanceBase::HandleSaveGameLoaded(USaveGame* SaveGameObject)
 		SaveGameObject = nullptr;
 	}
 
+	URPGSaveGame* LoadedSave = Cast<URPGSaveGame>(SaveGameObject);
+	bSaveSlotCorrupt = LoadedSave && LoadedSave->HasLoadFailed();
+
+	if (bSaveSlotCorrupt)
+	{
+		// Play on a new save but keep the slot and journal as they are, writing now would lose whatever can still be recovered from them
+		UE_LOG(LogActionRPG, Error, TEXT("HandleSaveGameLoaded: Save slot %s is corrupt, starting a new save game without saving over it"), *SaveSlot);
+		LoadedSave = nullptr;
+	}
+
 	// Replace current save, old object will GC out
-	CurrentSaveGame = Cast<URPGSaveGame>(SaveGameObject);
+	CurrentSaveGame = LoadedSave;
+	SaveGameLoadSerial++;
 
 	if (CurrentSaveGame)
 	{
+		// Bring the snapshot up to date with any changes journaled since it was written
+		ReplayInventoryJournal(CurrentSaveGame);
+
 		// Make sure it has any newly added default inventory
 		AddDefaultInventory(CurrentSaveGame, false);
 		bLoaded = true;
@@ -258,8 +411,16 @@ bool URPGGameInstanceBase::HandleSaveGameLoaded(USaveGame* SaveGameObject)
 		CurrentSaveGame = Cast<URPGSaveGame>(UGameplayStatics::CreateSaveGameObject(URPGSaveGame::StaticClass()));
 
 		AddDefaultInventory(CurrentSaveGame, true);
+
+		if (bSavingEnabled && !bSaveSlotCorrupt)
+		{
+			// A journal without a snapshot means we never finished the first full save
+			ReplayInventoryJournal(CurrentSaveGame);
+		}
 	}
 
+	bCurrentSaveGameLoaded = bLoaded;
+
 	OnSaveGameLoaded.Broadcast(CurrentSaveGame);
 	OnSaveGameLoadedNative.Broadcast(CurrentSaveGame);
 
@@ -274,40 +435,351 @@ void URPGGameInstanceBase::GetSaveSlotInfo(FString& SlotName, int32& UserIndex)
 
 bool URPGGameInstanceBase::WriteSaveGame()
 {
-	if (bSavingEnabled)
+	if (bSaveSlotCorrupt)
 	{
-		if (bCurrentlySaving)
+		UE_LOG(LogActionRPG, Warning, TEXT("WriteSaveGame: Not saving over corrupt save slot %s"), *SaveSlot);
+		return false;
+	}
+
+	if (bSavingEnabled && CurrentSaveGame)
+	{
+		// The snapshot gets a sequence of its own, so journal entries written before it are never replayed over it, including ones still being appended
+		CurrentSaveGame->JournalSequence++;
+
+		// This goes off in the background, a save requested while this one is writing replaces any save still waiting
+		if (!QueueSaveGameWrite(CurrentSaveGame, SaveSlot, SaveUserIndex, FOnSaveGameWrittenNative::CreateUObject(this, &URPGGameInstanceBase::HandleAsyncSave, CurrentSaveGame->JournalSequence)))
 		{
-			// Schedule another save to happen after current one finishes. We only queue one save
-			bPendingSaveRequested = true;
-			return true;
+			return false;
 		}
 
-		// Indicate that we're currently doing an async save
-		bCurrentlySaving = true;
-
-		// This goes off in the background
-		UGameplayStatics::AsyncSaveGameToSlot(GetCurrentSaveGame(), SaveSlot, SaveUserIndex, FAsyncSaveGameToSlotDelegate::CreateUObject(this, &URPGGameInstanceBase::HandleAsyncSave));
+		// The save object is serialized when its write starts, so everything journaled so far is part of the snapshot
+		InventoryJournalEntriesSinceSnapshot = 0;
 		return true;
 	}
 	return false;
 }
 
+bool URPGGameInstanceBase::WriteSaveGameToSlot(USaveGame* SaveGame, const FString& SlotName, int32 UserIndex, FOnSaveGameWritten OnComplete)
+{
+	return QueueSaveGameWrite(SaveGame, SlotName, UserIndex, FOnSaveGameWrittenNative::CreateLambda([OnComplete](bool bSuccess)
+	{
+		OnComplete.ExecuteIfBound(bSuccess);
+	}));
+}
+
+bool URPGGameInstanceBase::QueueSaveGameWrite(USaveGame* SaveGame, const FString& SlotName, int32 UserIndex, FOnSaveGameWrittenNative OnComplete)
+{
+	if (!SaveGame || SlotName.IsEmpty())
+	{
+		return false;
+	}
+
+	URPGSaveGame* RPGSaveGame = Cast<URPGSaveGame>(SaveGame);
+	if (RPGSaveGame && RPGSaveGame->HasLoadFailed())
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("QueueSaveGameWrite: Not writing a save game that failed to load to slot %s"), *SlotName);
+		return false;
+	}
+
+	// Only the newest save is kept, a save replaced before its write started is never serialized
+	const TPair<FString, int32> SlotKey(SlotName, UserIndex);
+	FSaveSlotWriteState& WriteState = SaveSlotWrites.FindOrAdd(SlotKey);
+	WriteState.PendingSaveGame.Reset(SaveGame);
+	WriteState.PendingCallbacks.Add(OnComplete);
+
+	if (!WriteState.InFlightWrite.IsValid())
+	{
+		StartSaveSlotWrite(SlotKey);
+	}
+	return true;
+}
+
+bool URPGGameInstanceBase::IsSaveSlotWriteInProgress(const FString& SlotName, int32 UserIndex) const
+{
+	return SaveSlotWrites.Contains(TPair<FString, int32>(SlotName, UserIndex));
+}
+
+void URPGGameInstanceBase::StartSaveSlotWrite(const TPair<FString, int32>& SlotKey)
+{
+	FSaveSlotWriteState& WriteState = SaveSlotWrites.FindChecked(SlotKey);
+
+	WriteState.InFlightCallbacks = MoveTemp(WriteState.PendingCallbacks);
+	WriteState.PendingCallbacks.Reset();
+
+	// Serializing touches the save object so it stays on the game thread, only the write to storage goes to the background
+	if (URPGSaveGame* RPGSaveGame = Cast<URPGSaveGame>(WriteState.PendingSaveGame.Get()))
+	{
+		RPGSaveGame->SetCompression(SaveGameCompression);
+	}
+
+	TArray<uint8> SaveData;
+	if (!UGameplayStatics::SaveGameToMemory(WriteState.PendingSaveGame.Get(), SaveData))
+	{
+		// Still goes through the background write, so the failure reaches the callbacks the same way
+		UE_LOG(LogActionRPG, Warning, TEXT("StartSaveSlotWrite: Failed to serialize save game for slot %s"), *SlotKey.Key);
+		SaveData.Reset();
+	}
+	WriteState.PendingSaveGame.Reset();
+
+	TSharedPtr<bool, ESPMode::ThreadSafe> WriteResult = MakeShared<bool, ESPMode::ThreadSafe>(false);
+	WriteState.InFlightWriteResult = WriteResult;
+
+	TWeakObjectPtr<URPGGameInstanceBase> WeakThis(this);
+	WriteState.InFlightWrite = FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis, SlotKey, WriteResult, SaveData = MoveTemp(SaveData)]()
+	{
+		*WriteResult = SaveData.Num() > 0 && UGameplayStatics::SaveDataToSlot(SaveData, SlotKey.Key, SlotKey.Value);
+
+		FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis, SlotKey, WriteResult]()
+		{
+			if (URPGGameInstanceBase* GameInstance = WeakThis.Get())
+			{
+				GameInstance->HandleSaveSlotWritten(SlotKey, WriteResult);
+			}
+		}, TStatId(), nullptr, ENamedThreads::GameThread);
+	}, TStatId(), nullptr, ENamedThreads::AnyBackgroundHiPriTask);
+}
+
+void URPGGameInstanceBase::HandleSaveSlotWritten(TPair<FString, int32> SlotKey, TSharedPtr<bool, ESPMode::ThreadSafe> WriteResult)
+{
+	FSaveSlotWriteState* WriteState = SaveSlotWrites.Find(SlotKey);
+	if (!WriteState || WriteState->InFlightWriteResult != WriteResult)
+	{
+		// Already handled by FlushSaveGameWrites
+		return;
+	}
+
+	const bool bSuccess = *WriteResult;
+	TArray<FOnSaveGameWrittenNative> Callbacks = MoveTemp(WriteState->InFlightCallbacks);
+	WriteState->InFlightCallbacks.Reset();
+	WriteState->InFlightWrite = nullptr;
+	WriteState->InFlightWriteResult.Reset();
+
+	if (!bSuccess)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("HandleSaveSlotWritten: Failed to write save slot %s for user %d"), *SlotKey.Key, SlotKey.Value);
+	}
+
+	if (WriteState->PendingSaveGame.IsValid())
+	{
+		// A newer save came in while this one was writing
+		StartSaveSlotWrite(SlotKey);
+	}
+	else
+	{
+		SaveSlotWrites.Remove(SlotKey);
+	}
+
+	// Callbacks may queue more writes, the state above is already up to date
+	OnSaveSlotWritten.Broadcast(SlotKey.Key, SlotKey.Value, bSuccess);
+	for (FOnSaveGameWrittenNative& Callback : Callbacks)
+	{
+		Callback.ExecuteIfBound(bSuccess);
+	}
+}
+
+void URPGGameInstanceBase::FlushSaveGameWrites()
+{
+	// Finishing a write starts the pending one and its callbacks may queue more, so this goes on until no slot has anything left
+	while (SaveSlotWrites.Num() > 0)
+	{
+		const TPair<FString, int32> SlotKey = SaveSlotWrites.CreateConstIterator().Key();
+		if (!SaveSlotWrites[SlotKey].InFlightWrite.IsValid())
+		{
+			StartSaveSlotWrite(SlotKey);
+		}
+
+		const FGraphEventRef InFlightWrite = SaveSlotWrites[SlotKey].InFlightWrite;
+		const TSharedPtr<bool, ESPMode::ThreadSafe> WriteResult = SaveSlotWrites[SlotKey].InFlightWriteResult;
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(InFlightWrite);
+
+		// Waiting may have run the game thread notification already, otherwise the write is finished here and the notification finds nothing to do
+		HandleSaveSlotWritten(SlotKey, WriteResult);
+	}
+}
+
 void URPGGameInstanceBase::ResetSaveGame()
 {
+	// Old journal entries would otherwise be replayed on top of the reset data
+	DeleteInventoryJournal();
+
 	// Call handle function with no loaded save, this will reset the data
 	HandleSaveGameLoaded(nullptr);
 }
 
-void URPGGameInstanceBase::HandleAsyncSave(const FString& SlotName, const int32 UserIndex, bool bSuccess)
+bool URPGGameInstanceBase::AppendInventoryJournal(TArray<FRPGInventoryJournalEntry>& Entries)
+{
+	if (!bSavingEnabled || !bUseInventoryJournal || !CurrentSaveGame || bSaveSlotCorrupt)
+	{
+		return false;
+	}
+
+	if (Entries.Num() == 0)
+	{
+		return true;
+	}
+
+	TArray<uint8> EntryBytes;
+	FMemoryWriter MemoryWriter(EntryBytes);
+	FNameAsStringProxyArchive Ar(MemoryWriter);
+
+	for (FRPGInventoryJournalEntry& Entry : Entries)
+	{
+		// Keep the in memory save up to date, so a later snapshot includes this change
+		Entry.Sequence = CurrentSaveGame->JournalSequence + 1;
+		CurrentSaveGame->ApplyJournalEntry(Entry);
+
+		Ar << Entry;
+	}
+
+	const FString JournalPath = GetInventoryJournalPath();
+	TWeakObjectPtr<URPGGameInstanceBase> WeakThis(this);
+	QueueInventoryJournalWrite([WeakThis, JournalPath, EntryBytes = MoveTemp(EntryBytes)]()
+	{
+		TArray<uint8> JournalBytes;
+		if (IFileManager::Get().FileSize(*JournalPath) <= 0)
+		{
+			// Starting a new journal file
+			FMemoryWriter HeaderWriter(JournalBytes);
+			uint32 Magic = InventoryJournalMagic;
+			int32 Version = InventoryJournalVersion;
+			HeaderWriter << Magic;
+			HeaderWriter << Version;
+		}
+		JournalBytes.Append(EntryBytes);
+
+		if (!FFileHelper::SaveArrayToFile(JournalBytes, *JournalPath, &IFileManager::Get(), FILEWRITE_Append))
+		{
+			FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis, JournalPath]()
+			{
+				if (URPGGameInstanceBase* GameInstance = WeakThis.Get())
+				{
+					GameInstance->HandleInventoryJournalAppendFailed(JournalPath);
+				}
+			}, TStatId(), nullptr, ENamedThreads::GameThread);
+		}
+	});
+
+	if (InventoryJournalEntriesSinceSnapshot == 0)
+	{
+		InventoryJournalOldestEntryTime = FPlatformTime::Seconds();
+	}
+	InventoryJournalEntriesSinceSnapshot += Entries.Num();
+
+	if (InventoryJournalEntriesSinceSnapshot >= MaxInventoryJournalEntries || FPlatformTime::Seconds() - InventoryJournalOldestEntryTime >= InventoryJournalCompactInterval)
+	{
+		CompactInventoryJournal();
+	}
+	return true;
+}
+
+bool URPGGameInstanceBase::CompactInventoryJournal()
+{
+	// The current save game already has every journaled change applied, so writing it is the compaction
+	return WriteSaveGame();
+}
+
+FString URPGGameInstanceBase::GetInventoryJournalPath() const
+{
+	return FPaths::ProjectSavedDir() / TEXT("SaveGames") / FString::Printf(TEXT("%s_%d.journal"), *SaveSlot, SaveUserIndex);
+}
+
+int32 URPGGameInstanceBase::ReplayInventoryJournal(URPGSaveGame* SaveGame)
+{
+	InventoryJournalEntriesSinceSnapshot = 0;
+
+	// Reading has to see every append and delete queued so far
+	WaitForInventoryJournalWrites();
+
+	TArray<uint8> JournalBytes;
+	if (!SaveGame || !FFileHelper::LoadFileToArray(JournalBytes, *GetInventoryJournalPath(), FILEREAD_Silent))
+	{
+		return 0;
+	}
+
+	FMemoryReader MemoryReader(JournalBytes);
+	FNameAsStringProxyArchive Ar(MemoryReader);
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsError() || Magic != InventoryJournalMagic || Version != InventoryJournalVersion)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("ReplayInventoryJournal: Ignoring journal with unknown format"));
+		return 0;
+	}
+
+	int32 NumReplayed = 0;
+	while (!Ar.AtEnd())
+	{
+		FRPGInventoryJournalEntry Entry;
+		Ar << Entry;
+
+		if (Ar.IsError())
+		{
+			// Last write was interrupted, everything before it is still valid
+			UE_LOG(LogActionRPG, Warning, TEXT("ReplayInventoryJournal: Journal is truncated, ignoring partial entry"));
+			break;
+		}
+
+		// Entries at or below the snapshot sequence were already saved in the snapshot
+		if (Entry.Sequence > SaveGame->JournalSequence)
+		{
+			SaveGame->ApplyJournalEntry(Entry);
+			NumReplayed++;
+		}
+	}
+
+	if (NumReplayed > 0)
+	{
+		InventoryJournalEntriesSinceSnapshot = NumReplayed;
+		InventoryJournalOldestEntryTime = FPlatformTime::Seconds();
+	}
+	return NumReplayed;
+}
+
+void URPGGameInstanceBase::DeleteInventoryJournal()
+{
+	const FString JournalPath = GetInventoryJournalPath();
+	QueueInventoryJournalWrite([JournalPath]()
+	{
+		IFileManager::Get().Delete(*JournalPath, false, false, true);
+	});
+}
+
+void URPGGameInstanceBase::QueueInventoryJournalWrite(TUniqueFunction<void()> Write)
 {
-	ensure(bCurrentlySaving);
-	bCurrentlySaving = false;
+	FGraphEventArray Prerequisites;
+	if (InventoryJournalWrite.IsValid())
+	{
+		Prerequisites.Add(InventoryJournalWrite);
+	}
 
-	if (bPendingSaveRequested)
+	InventoryJournalWrite = FFunctionGraphTask::CreateAndDispatchWhenReady(MoveTemp(Write), TStatId(), &Prerequisites, ENamedThreads::AnyBackgroundHiPriTask);
+}
+
+void URPGGameInstanceBase::WaitForInventoryJournalWrites()
+{
+	if (InventoryJournalWrite.IsValid())
+	{
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(InventoryJournalWrite);
+		InventoryJournalWrite = nullptr;
+	}
+}
+
+void URPGGameInstanceBase::HandleInventoryJournalAppendFailed(FString JournalPath)
+{
+	// The entries are already applied to the current save game, a full snapshot of it is newer than anything the journal holds
+	UE_LOG(LogActionRPG, Warning, TEXT("AppendInventoryJournal: Failed to write %s, writing full save instead"), *JournalPath);
+	CompactInventoryJournal();
+}
+
+void URPGGameInstanceBase::HandleAsyncSave(bool bSuccess, int64 SnapshotJournalSequence)
+{
+	if (bSuccess && CurrentSaveGame && CurrentSaveGame->JournalSequence == SnapshotJournalSequence)
 	{
-		// Start another save as we got a request while saving
-		bPendingSaveRequested = false;
-		WriteSaveGame();
+		// Snapshot on disk contains every journaled change, so the journal is no longer needed
+		DeleteInventoryJournal();
 	}
 }
@@ -5,6 +5,8 @@
 #include "RPGGameInstanceBase.h"
 #include "RPGSaveGame.h"
 #include "Items/RPGItem.h"
+#include "TimerManager.h"
+#include "Engine/World.h"
 
 bool ARPGPlayerControllerBase::AddInventoryItem(URPGItem* NewItem, int32 ItemCount, int32 ItemLevel, bool bAutoSlot)
 {
@@ -21,9 +23,21 @@ bool ARPGPlayerControllerBase::AddInventoryItem(URPGItem* NewItem, int32 ItemCou
 		return false;
 	}
 
+	if (IsInventoryLoading())
+	{
+		// Counts are not known yet, apply on top of the saved data once it is restored
+		FPendingInventoryChange& Change = PendingInventoryChanges.AddDefaulted_GetRef();
+		Change.Op = FPendingInventoryChange::EOp::Add;
+		Change.Item = NewItem;
+		Change.ItemCount = ItemCount;
+		Change.ItemLevel = ItemLevel;
+		Change.bAutoSlot = bAutoSlot;
+		return true;
+	}
+
 	// Find current item data, which may be empty
 	FRPGItemData OldData;
-	GetInventoryItemData(NewItem, OldData);
+	const bool bWasInInventory = GetInventoryItemData(NewItem, OldData);
 
 	// Find modified data
 	FRPGItemData NewData = OldData;
@@ -33,6 +47,7 @@ bool ARPGPlayerControllerBase::AddInventoryItem(URPGItem* NewItem, int32 ItemCou
 	{
 		// If data changed, need to update storage and call callback
 		InventoryData.Add(NewItem, NewData);
+		JournalItemChanged(NewItem, bWasInInventory);
 		NotifyInventoryItemChanged(true, NewItem);
 		bChanged = true;
 	}
@@ -46,7 +61,7 @@ bool ARPGPlayerControllerBase::AddInventoryItem(URPGItem* NewItem, int32 ItemCou
 	if (bChanged)
 	{
 		// If anything changed, write to save game
-		SaveInventory();
+		SaveInventoryChanges();
 		return true;
 	}
 	return false;
@@ -60,6 +75,15 @@ bool ARPGPlayerControllerBase::RemoveInventoryItem(URPGItem* RemovedItem, int32
 		return false;
 	}
 
+	if (IsInventoryLoading())
+	{
+		FPendingInventoryChange& Change = PendingInventoryChanges.AddDefaulted_GetRef();
+		Change.Op = FPendingInventoryChange::EOp::Remove;
+		Change.Item = RemovedItem;
+		Change.ItemCount = RemoveCount;
+		return true;
+	}
+
 	// Find current item data, which may be empty
 	FRPGItemData NewData;
 	GetInventoryItemData(RemovedItem, NewData);
@@ -90,20 +114,22 @@ bool ARPGPlayerControllerBase::RemoveInventoryItem(URPGItem* RemovedItem, int32
 		// Remove item entirely, make sure it is unslotted
 		InventoryData.Remove(RemovedItem);
 
-		for (TPair<FRPGItemSlot, URPGItem*>& Pair : SlottedItems)
+		TArray<FRPGItemSlot> OccupiedSlots;
+		SlotsByItem.MultiFind(RemovedItem, OccupiedSlots);
+
+		for (const FRPGItemSlot& OccupiedSlot : OccupiedSlots)
 		{
-			if (Pair.Value == RemovedItem)
-			{
-				Pair.Value = nullptr;
-				NotifySlottedItemChanged(Pair.Key, Pair.Value);
-			}
+			SetSlotContents(OccupiedSlot, nullptr);
+			JournalSlotChanged(OccupiedSlot, nullptr);
+			NotifySlottedItemChanged(OccupiedSlot, nullptr);
 		}
 	}
 
 	// If we got this far, there is a change so notify and save
+	JournalItemChanged(RemovedItem, true);
 	NotifyInventoryItemChanged(false, RemovedItem);
 
-	SaveInventory();
+	SaveInventoryChanges();
 	return true;
 }
 
@@ -126,32 +152,45 @@ void ARPGPlayerControllerBase::GetInventoryItems(TArray<URPGItem*>& Items, FPrim
 
 bool ARPGPlayerControllerBase::SetSlottedItem(FRPGItemSlot ItemSlot, URPGItem* Item)
 {
-	// Iterate entire inventory because we need to remove from old slot
-	bool bFound = false;
-	for (TPair<FRPGItemSlot, URPGItem*>& Pair : SlottedItems)
+	if (!SlottedItems.Contains(ItemSlot))
 	{
-		if (Pair.Key == ItemSlot)
-		{
-			// Add to new slot
-			bFound = true;
-			Pair.Value = Item;
-			NotifySlottedItemChanged(Pair.Key, Pair.Value);
-		}
-		else if (Item != nullptr && Pair.Value == Item)
-		{
-			// If this item was found in another slot, remove it
-			Pair.Value = nullptr;
-			NotifySlottedItemChanged(Pair.Key, Pair.Value);
-		}
+		return false;
 	}
 
-	if (bFound)
+	if (IsInventoryLoading())
 	{
-		SaveInventory();
+		// The restore replaces every slot, so the change has to wait for it
+		FPendingInventoryChange& Change = PendingInventoryChanges.AddDefaulted_GetRef();
+		Change.Op = FPendingInventoryChange::EOp::SetSlot;
+		Change.Item = Item;
+		Change.ItemSlot = ItemSlot;
 		return true;
 	}
 
-	return false;
+	if (Item != nullptr)
+	{
+		// If this item was found in another slot, remove it. The reverse index means we only visit slots holding this item
+		TArray<FRPGItemSlot> OccupiedSlots;
+		SlotsByItem.MultiFind(Item, OccupiedSlots);
+
+		for (const FRPGItemSlot& OccupiedSlot : OccupiedSlots)
+		{
+			if (OccupiedSlot != ItemSlot)
+			{
+				SetSlotContents(OccupiedSlot, nullptr);
+				JournalSlotChanged(OccupiedSlot, nullptr);
+				NotifySlottedItemChanged(OccupiedSlot, nullptr);
+			}
+		}
+	}
+
+	// Add to new slot
+	SetSlotContents(ItemSlot, Item);
+	JournalSlotChanged(ItemSlot, Item);
+	NotifySlottedItemChanged(ItemSlot, Item);
+
+	SaveInventoryChanges();
+	return true;
 }
 
 int32 ARPGPlayerControllerBase::GetInventoryItemCount(URPGItem* Item) const
@@ -191,15 +230,29 @@ URPGItem* ARPGPlayerControllerBase::GetSlottedItem(FRPGItemSlot ItemSlot) const
 
 void ARPGPlayerControllerBase::GetSlottedItems(TArray<URPGItem*>& Items, FPrimaryAssetType ItemType, bool bOutputEmptyIndexes)
 {
-	for (TPair<FRPGItemSlot, URPGItem*>& Pair : SlottedItems)
+	if (ItemType.IsValid())
 	{
-		if (Pair.Key.ItemType == ItemType || !ItemType.IsValid())
+		// Dense per type array is already in slot order
+		const TArray<URPGItem*>* TypeSlots = SlottedItemsByType.Find(ItemType);
+
+		if (TypeSlots)
 		{
-			Items.Add(Pair.Value);
+			Items.Append(*TypeSlots);
 		}
+		return;
+	}
+
+	for (TPair<FRPGItemSlot, URPGItem*>& Pair : SlottedItems)
+	{
+		Items.Add(Pair.Value);
 	}
 }
 
+void ARPGPlayerControllerBase::GetSlotsForItem(URPGItem* Item, TArray<FRPGItemSlot>& ItemSlots) const
+{
+	SlotsByItem.MultiFind(Item, ItemSlots);
+}
+
 void ARPGPlayerControllerBase::FillEmptySlots()
 {
 	bool bShouldSave = false;
@@ -210,7 +263,7 @@ void ARPGPlayerControllerBase::FillEmptySlots()
 
 	if (bShouldSave)
 	{
-		SaveInventory();
+		SaveInventoryChanges();
 	}
 }
 
@@ -227,6 +280,9 @@ bool ARPGPlayerControllerBase::SaveInventory()
 	URPGSaveGame* CurrentSaveGame = GameInstance->GetCurrentSaveGame();
 	if (CurrentSaveGame)
 	{
+		// A full snapshot supersedes any queued journal entries
+		PendingJournalEntries.Reset();
+
 		// Reset cached data in save game before writing to it
 		CurrentSaveGame->InventoryData.Reset();
 		CurrentSaveGame->SlottedItems.Reset();
@@ -262,8 +318,12 @@ bool ARPGPlayerControllerBase::SaveInventory()
 
 bool ARPGPlayerControllerBase::LoadInventory()
 {
+	// Cancel any restore that is still in progress, it would be replaced anyway
+	CancelAsyncInventoryLoad();
+
 	InventoryData.Reset();
-	SlottedItems.Reset();
+	ResetSlots();
+	PendingJournalEntries.Reset();
 
 	// Fill in slots from game instance
 	UWorld* World = GetWorld();
@@ -280,85 +340,331 @@ bool ARPGPlayerControllerBase::LoadInventory()
 		GameInstance->OnSaveGameLoadedNative.AddUObject(this, &ARPGPlayerControllerBase::HandleSaveGameLoaded);
 	}
 
+	InitializeEmptySlots(GameInstance);
+
+	URPGSaveGame* CurrentSaveGame = GameInstance->GetCurrentSaveGame();
+	if (CurrentSaveGame)
+	{
+		if (!bAsyncInventoryLoad || !StartAsyncInventoryLoad(CurrentSaveGame))
+		{
+			// Either async loading is disabled or there was nothing to wait for
+			RestoreInventoryFromSaveGame();
+		}
+		return true;
+	}
+
+	if (GameInstance->IsSaveGameLoadInProgress())
+	{
+		// Restored from HandleSaveGameLoaded once the save game has loaded, the UI gets a single inventory loaded notification then
+		return false;
+	}
+
+	// Load failed but we reset inventory, so need to notify UI
+	NotifyInventoryLoaded();
+
+	return false;
+}
+
+bool ARPGPlayerControllerBase::IsInventoryLoading() const
+{
+	return bInventoryLoading;
+}
+
+void ARPGPlayerControllerBase::InitializeEmptySlots(URPGGameInstanceBase* GameInstance)
+{
 	for (const TPair<FPrimaryAssetType, int32>& Pair : GameInstance->ItemSlotsPerType)
 	{
+		TArray<URPGItem*>& TypeSlots = SlottedItemsByType.FindOrAdd(Pair.Key);
+		TypeSlots.SetNumZeroed(FMath::Max(Pair.Value, 0));
+
 		for (int32 SlotNumber = 0; SlotNumber < Pair.Value; SlotNumber++)
 		{
 			SlottedItems.Add(FRPGItemSlot(Pair.Key, SlotNumber), nullptr);
 		}
 	}
+}
 
-	URPGSaveGame* CurrentSaveGame = GameInstance->GetCurrentSaveGame();
+void ARPGPlayerControllerBase::ResetSlots()
+{
+	SlottedItems.Reset();
+	SlottedItemsByType.Reset();
+	SlotsByItem.Reset();
+}
+
+void ARPGPlayerControllerBase::SetSlotContents(const FRPGItemSlot& ItemSlot, URPGItem* Item)
+{
+	URPGItem*& SlotItem = SlottedItems.FindChecked(ItemSlot);
+
+	if (SlotItem)
+	{
+		SlotsByItem.RemoveSingle(SlotItem, ItemSlot);
+	}
+
+	SlotItem = Item;
+
+	if (Item)
+	{
+		SlotsByItem.Add(Item, ItemSlot);
+	}
+
+	TArray<URPGItem*>* TypeSlots = SlottedItemsByType.Find(ItemSlot.ItemType);
+	if (TypeSlots && TypeSlots->IsValidIndex(ItemSlot.SlotNumber))
+	{
+		(*TypeSlots)[ItemSlot.SlotNumber] = Item;
+	}
+}
+
+bool ARPGPlayerControllerBase::StartAsyncInventoryLoad(URPGSaveGame* SaveGame)
+{
 	URPGAssetManager& AssetManager = URPGAssetManager::Get();
-	if (CurrentSaveGame)
+
+	// Gather every item referenced by the save, skipping ones that are already in memory
+	TSet<FPrimaryAssetId> ItemsToLoad;
+	for (const TPair<FPrimaryAssetId, FRPGItemData>& ItemPair : SaveGame->InventoryData)
+	{
+		if (ItemPair.Key.IsValid() && !AssetManager.GetPrimaryAssetObject<URPGItem>(ItemPair.Key))
+		{
+			ItemsToLoad.Add(ItemPair.Key);
+		}
+	}
+
+	for (const TPair<FRPGItemSlot, FPrimaryAssetId>& SlotPair : SaveGame->SlottedItems)
+	{
+		if (SlotPair.Value.IsValid() && !AssetManager.GetPrimaryAssetObject<URPGItem>(SlotPair.Value))
+		{
+			ItemsToLoad.Add(SlotPair.Value);
+		}
+	}
+
+	if (ItemsToLoad.Num() == 0)
+	{
+		return false;
+	}
+
+	// Issue one batched request for the whole inventory, the serial lets us ignore callbacks from cancelled requests
+	bInventoryLoading = true;
+	InventoryLoadSerial++;
+
+	FStreamableDelegate LoadedDelegate = FStreamableDelegate::CreateUObject(this, &ARPGPlayerControllerBase::HandleInventoryItemsLoaded, InventoryLoadSerial);
+	TSharedPtr<FStreamableHandle> LoadHandle = AssetManager.LoadPrimaryAssets(ItemsToLoad.Array(), TArray<FName>(), LoadedDelegate);
+
+	if (!bInventoryLoading)
+	{
+		// Delegate was called inline, everything is already restored
+		return true;
+	}
+
+	if (!LoadHandle.IsValid())
+	{
+		// Request could not be made, restore synchronously instead
+		bInventoryLoading = false;
+		return false;
+	}
+
+	InventoryLoadHandle = LoadHandle;
+
+	if (InventoryLoadTimeout > 0.f)
+	{
+		GetWorldTimerManager().SetTimer(InventoryLoadTimeoutHandle, FTimerDelegate::CreateUObject(this, &ARPGPlayerControllerBase::HandleInventoryLoadTimeout, InventoryLoadSerial), InventoryLoadTimeout, false);
+	}
+	return true;
+}
+
+void ARPGPlayerControllerBase::CancelAsyncInventoryLoad()
+{
+	if (InventoryLoadHandle.IsValid())
+	{
+		if (InventoryLoadHandle->IsLoadingInProgress())
+		{
+			InventoryLoadHandle->CancelHandle();
+		}
+		InventoryLoadHandle.Reset();
+	}
+
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(InventoryLoadTimeoutHandle);
+	}
+	bInventoryLoading = false;
+}
+
+void ARPGPlayerControllerBase::HandleInventoryItemsLoaded(int32 LoadSerial)
+{
+	if (bInventoryLoading && LoadSerial == InventoryLoadSerial)
+	{
+		RestoreInventoryFromSaveGame();
+	}
+}
+
+void ARPGPlayerControllerBase::HandleInventoryLoadTimeout(int32 LoadSerial)
+{
+	if (bInventoryLoading && LoadSerial == InventoryLoadSerial)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("LoadInventory: Item load did not finish within %.1f seconds, loading remaining items synchronously"), InventoryLoadTimeout);
+		RestoreInventoryFromSaveGame();
+	}
+}
+
+void ARPGPlayerControllerBase::RestoreInventoryFromSaveGame()
+{
+	// Stop waiting on the batched load, anything it did not finish is loaded synchronously below
+	CancelAsyncInventoryLoad();
+
+	InventoryData.Reset();
+	ResetSlots();
+
+	UWorld* World = GetWorld();
+	URPGGameInstanceBase* GameInstance = World ? World->GetGameInstance<URPGGameInstanceBase>() : nullptr;
+	URPGSaveGame* CurrentSaveGame = GameInstance ? GameInstance->GetCurrentSaveGame() : nullptr;
+
+	if (!CurrentSaveGame)
 	{
-		// Copy from save game into controller data
-		bool bFoundAnySlots = false;
-		for (const TPair<FPrimaryAssetId, FRPGItemData>& ItemPair : CurrentSaveGame->InventoryData)
+		NotifyInventoryLoaded();
+		ApplyPendingInventoryChanges();
+		return;
+	}
+
+	InitializeEmptySlots(GameInstance);
+
+	// Copy from save game into controller data
+	bool bFoundAnySlots = false;
+	for (const TPair<FPrimaryAssetId, FRPGItemData>& ItemPair : CurrentSaveGame->InventoryData)
+	{
+		URPGItem* LoadedItem = FindOrLoadItem(ItemPair.Key);
+
+		if (LoadedItem != nullptr)
 		{
-			URPGItem* LoadedItem = AssetManager.ForceLoadItem(ItemPair.Key);
+			InventoryData.Add(LoadedItem, ItemPair.Value);
+		}
+	}
 
-			if (LoadedItem != nullptr)
+	for (const TPair<FRPGItemSlot, FPrimaryAssetId>& SlotPair : CurrentSaveGame->SlottedItems)
+	{
+		if (SlotPair.Value.IsValid())
+		{
+			URPGItem* LoadedItem = FindOrLoadItem(SlotPair.Value);
+			if (GameInstance->IsValidItemSlot(SlotPair.Key) && LoadedItem)
 			{
-				InventoryData.Add(LoadedItem, ItemPair.Value);
+				SetSlotContents(SlotPair.Key, LoadedItem);
+				bFoundAnySlots = true;
 			}
 		}
+	}
+
+	if (!bFoundAnySlots)
+	{
+		// Auto slot items as no slots were saved
+		FillEmptySlots();
+	}
+
+	NotifyInventoryLoaded();
+	ApplyPendingInventoryChanges();
+}
 
-		for (const TPair<FRPGItemSlot, FPrimaryAssetId>& SlotPair : CurrentSaveGame->SlottedItems)
+void ARPGPlayerControllerBase::ApplyPendingInventoryChanges()
+{
+	// Move out first, a change may start another load through the callbacks
+	TArray<FPendingInventoryChange> Changes = MoveTemp(PendingInventoryChanges);
+	PendingInventoryChanges.Reset();
+
+	for (const FPendingInventoryChange& Change : Changes)
+	{
+		URPGItem* Item = Change.Item.Get();
+
+		switch (Change.Op)
 		{
-			if (SlotPair.Value.IsValid())
+		case FPendingInventoryChange::EOp::Add:
+			if (Item && !AddInventoryItem(Item, Change.ItemCount, Change.ItemLevel, Change.bAutoSlot))
+			{
+				NotifyPendingInventoryChangeFailed(Change, Item);
+			}
+			break;
+		case FPendingInventoryChange::EOp::Remove:
+			if (Item && !RemoveInventoryItem(Item, Change.ItemCount))
+			{
+				NotifyPendingInventoryChangeFailed(Change, Item);
+			}
+			break;
+		case FPendingInventoryChange::EOp::SetSlot:
+			// A null item empties the slot, but an item that has gone away must not
+			if (Item || Change.Item.IsExplicitlyNull())
 			{
-				URPGItem* LoadedItem = AssetManager.ForceLoadItem(SlotPair.Value);
-				if (GameInstance->IsValidItemSlot(SlotPair.Key) && LoadedItem)
+				if (!SetSlottedItem(Change.ItemSlot, Item))
 				{
-					SlottedItems.Add(SlotPair.Key, LoadedItem);
-					bFoundAnySlots = true;
+					NotifyPendingInventoryChangeFailed(Change, Item);
 				}
 			}
+			else
+			{
+				NotifyPendingInventoryChangeFailed(Change, nullptr);
+			}
+			break;
 		}
+	}
+}
 
-		if (!bFoundAnySlots)
+void ARPGPlayerControllerBase::NotifyPendingInventoryChangeFailed(const FPendingInventoryChange& Change, URPGItem* Item)
+{
+	UE_LOG(LogActionRPG, Warning, TEXT("LoadInventory: Change to %s requested while the inventory was loading could not be applied"), Item ? *Item->GetName() : *Change.ItemSlot.ItemType.ToString());
+
+	if (Change.Op == FPendingInventoryChange::EOp::SetSlot)
+	{
+		if (SlottedItems.Contains(Change.ItemSlot))
 		{
-			// Auto slot items as no slots were saved
-			FillEmptySlots();
+			NotifySlottedItemChanged(Change.ItemSlot, GetSlottedItem(Change.ItemSlot));
 		}
-
-		NotifyInventoryLoaded();
-
-		return true;
 	}
+	else
+	{
+		NotifyInventoryItemChanged(InventoryData.Contains(Item), Item);
+	}
+}
 
-	// Load failed but we reset inventory, so need to notify UI
-	NotifyInventoryLoaded();
+URPGItem* ARPGPlayerControllerBase::FindOrLoadItem(const FPrimaryAssetId& ItemId) const
+{
+	URPGAssetManager& AssetManager = URPGAssetManager::Get();
 
-	return false;
+	// Items from the batched request will already be in memory, this only hitches for items that failed or timed out
+	URPGItem* LoadedItem = AssetManager.GetPrimaryAssetObject<URPGItem>(ItemId);
+	if (!LoadedItem)
+	{
+		LoadedItem = AssetManager.ForceLoadItem(ItemId);
+	}
+	return LoadedItem;
 }
 
 bool ARPGPlayerControllerBase::FillEmptySlotWithItem(URPGItem* NewItem)
 {
 	// Look for an empty item slot to fill with this item
 	FPrimaryAssetType NewItemType = NewItem->GetPrimaryAssetId().PrimaryAssetType;
+	TArray<URPGItem*>* TypeSlots = SlottedItemsByType.Find(NewItemType);
+
+	if (!TypeSlots)
+	{
+		return false;
+	}
+
 	FRPGItemSlot EmptySlot;
-	for (TPair<FRPGItemSlot, URPGItem*>& Pair : SlottedItems)
+	for (int32 SlotNumber = 0; SlotNumber < TypeSlots->Num(); SlotNumber++)
 	{
-		if (Pair.Key.ItemType == NewItemType)
+		URPGItem* SlotItem = (*TypeSlots)[SlotNumber];
+
+		if (SlotItem == NewItem)
 		{
-			if (Pair.Value == NewItem)
-			{
-				// Item is already slotted
-				return false;
-			}
-			else if (Pair.Value == nullptr && (!EmptySlot.IsValid() || EmptySlot.SlotNumber > Pair.Key.SlotNumber))
-			{
-				// We found an empty slot worth filling
-				EmptySlot = Pair.Key;
-			}
+			// Item is already slotted
+			return false;
+		}
+		else if (SlotItem == nullptr && !EmptySlot.IsValid())
+		{
+			// Lowest numbered empty slot is the one worth filling
+			EmptySlot = FRPGItemSlot(NewItemType, SlotNumber);
 		}
 	}
 
 	if (EmptySlot.IsValid())
 	{
-		SlottedItems[EmptySlot] = NewItem;
+		SetSlotContents(EmptySlot, NewItem);
+		JournalSlotChanged(EmptySlot, NewItem);
 		NotifySlottedItemChanged(EmptySlot, NewItem);
 		return true;
 	}
@@ -366,7 +672,163 @@ bool ARPGPlayerControllerBase::FillEmptySlotWithItem(URPGItem* NewItem)
 	return false;
 }
 
+void ARPGPlayerControllerBase::JournalItemChanged(URPGItem* Item, bool bWasInInventory)
+{
+	const FRPGItemData* FoundData = InventoryData.Find(Item);
+
+	if (FoundData)
+	{
+		ERPGInventoryJournalOp Op = bWasInInventory ? ERPGInventoryJournalOp::ItemDataChanged : ERPGInventoryJournalOp::ItemAdded;
+		PendingJournalEntries.Add(FRPGInventoryJournalEntry::MakeItemChange(Op, Item->GetPrimaryAssetId(), *FoundData));
+	}
+	else
+	{
+		PendingJournalEntries.Add(FRPGInventoryJournalEntry::MakeItemChange(ERPGInventoryJournalOp::ItemRemoved, Item->GetPrimaryAssetId(), FRPGItemData(0, 0)));
+	}
+}
+
+void ARPGPlayerControllerBase::JournalSlotChanged(FRPGItemSlot ItemSlot, URPGItem* Item)
+{
+	PendingJournalEntries.Add(FRPGInventoryJournalEntry::MakeSlotChange(ItemSlot, Item ? Item->GetPrimaryAssetId() : FPrimaryAssetId()));
+}
+
+bool ARPGPlayerControllerBase::SaveInventoryChanges()
+{
+	UWorld* World = GetWorld();
+	URPGGameInstanceBase* GameInstance = World ? World->GetGameInstance<URPGGameInstanceBase>() : nullptr;
+
+	if (GameInstance && GameInstance->AppendInventoryJournal(PendingJournalEntries))
+	{
+		PendingJournalEntries.Reset();
+		return true;
+	}
+
+	// Journal not available, rewrite the whole inventory
+	return SaveInventory();
+}
+
 void ARPGPlayerControllerBase::NotifyInventoryItemChanged(bool bAdded, URPGItem* Item)
+{
+	if (bBatchInventoryNotifications)
+	{
+		if (bAdded)
+		{
+			PendingAddedItems.Add(Item);
+		}
+		else
+		{
+			PendingRemovedItems.Add(Item);
+		}
+
+		// Wait for the end of frame flush
+		if (!PendingChangeSetFlushHandle.IsValid())
+		{
+			PendingChangeSetFlushHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ARPGPlayerControllerBase::HandleWorldPostActorTick);
+		}
+		return;
+	}
+
+	FRPGInventoryChangeSet ChangeSet;
+	if (bAdded)
+	{
+		ChangeSet.AddedItems.Add(Item);
+	}
+	else
+	{
+		ChangeSet.RemovedItems.Add(Item);
+	}
+
+	BroadcastInventoryItemChanged(bAdded, Item);
+	BroadcastInventoryChangeSet(ChangeSet);
+}
+
+void ARPGPlayerControllerBase::NotifySlottedItemChanged(FRPGItemSlot ItemSlot, URPGItem* Item)
+{
+	if (bBatchInventoryNotifications)
+	{
+		// Current contents are read back at flush time, so only the slot needs to be remembered
+		PendingChangedSlots.Add(ItemSlot);
+
+		if (!PendingChangeSetFlushHandle.IsValid())
+		{
+			PendingChangeSetFlushHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ARPGPlayerControllerBase::HandleWorldPostActorTick);
+		}
+		return;
+	}
+
+	FRPGInventoryChangeSet ChangeSet;
+	ChangeSet.ChangedSlots.Add(ItemSlot);
+
+	BroadcastSlottedItemChanged(ItemSlot, Item);
+	BroadcastInventoryChangeSet(ChangeSet);
+}
+
+void ARPGPlayerControllerBase::NotifyInventoryLoaded()
+{
+	// Everything may have been replaced, so pending changes are superseded by the load notification
+	ResetPendingChanges();
+	if (PendingChangeSetFlushHandle.IsValid())
+	{
+		FWorldDelegates::OnWorldPostActorTick.Remove(PendingChangeSetFlushHandle);
+		PendingChangeSetFlushHandle.Reset();
+	}
+
+	// Notify native before blueprint
+	OnInventoryLoadedNative.Broadcast();
+	OnInventoryLoaded.Broadcast();
+}
+
+void ARPGPlayerControllerBase::FlushInventoryNotifications()
+{
+	if (PendingChangeSetFlushHandle.IsValid())
+	{
+		FWorldDelegates::OnWorldPostActorTick.Remove(PendingChangeSetFlushHandle);
+		PendingChangeSetFlushHandle.Reset();
+	}
+
+	if (!HasPendingChanges())
+	{
+		return;
+	}
+
+	// Copy out first, callbacks may cause more changes which start a new set
+	FRPGInventoryChangeSet ChangeSet;
+	ChangeSet.AddedItems = PendingAddedItems.Array();
+	ChangeSet.RemovedItems = PendingRemovedItems.Array();
+	ChangeSet.ChangedSlots = PendingChangedSlots.Array();
+	ResetPendingChanges();
+
+	for (URPGItem* Item : ChangeSet.AddedItems)
+	{
+		BroadcastInventoryItemChanged(true, Item);
+	}
+
+	for (URPGItem* Item : ChangeSet.RemovedItems)
+	{
+		BroadcastInventoryItemChanged(false, Item);
+	}
+
+	for (const FRPGItemSlot& ItemSlot : ChangeSet.ChangedSlots)
+	{
+		BroadcastSlottedItemChanged(ItemSlot, GetSlottedItem(ItemSlot));
+	}
+
+	BroadcastInventoryChangeSet(ChangeSet);
+}
+
+bool ARPGPlayerControllerBase::HasPendingChanges() const
+{
+	return PendingAddedItems.Num() > 0 || PendingRemovedItems.Num() > 0 || PendingChangedSlots.Num() > 0;
+}
+
+void ARPGPlayerControllerBase::ResetPendingChanges()
+{
+	PendingAddedItems.Reset();
+	PendingRemovedItems.Reset();
+	PendingChangedSlots.Reset();
+}
+
+void ARPGPlayerControllerBase::BroadcastInventoryItemChanged(bool bAdded, URPGItem* Item)
 {
 	// Notify native before blueprint
 	OnInventoryItemChangedNative.Broadcast(bAdded, Item);
@@ -376,7 +838,7 @@ void ARPGPlayerControllerBase::NotifyInventoryItemChanged(bool bAdded, URPGItem*
 	InventoryItemChanged(bAdded, Item);
 }
 
-void ARPGPlayerControllerBase::NotifySlottedItemChanged(FRPGItemSlot ItemSlot, URPGItem* Item)
+void ARPGPlayerControllerBase::BroadcastSlottedItemChanged(FRPGItemSlot ItemSlot, URPGItem* Item)
 {
 	// Notify native before blueprint
 	OnSlottedItemChangedNative.Broadcast(ItemSlot, Item);
@@ -386,11 +848,22 @@ void ARPGPlayerControllerBase::NotifySlottedItemChanged(FRPGItemSlot ItemSlot, U
 	SlottedItemChanged(ItemSlot, Item);
 }
 
-void ARPGPlayerControllerBase::NotifyInventoryLoaded()
+void ARPGPlayerControllerBase::BroadcastInventoryChangeSet(const FRPGInventoryChangeSet& ChangeSet)
 {
 	// Notify native before blueprint
-	OnInventoryLoadedNative.Broadcast();
-	OnInventoryLoaded.Broadcast();
+	OnInventoryChangeSetNative.Broadcast(ChangeSet);
+	OnInventoryChangeSet.Broadcast(ChangeSet);
+
+	// Call BP update event
+	InventoryChangeSetDispatched(ChangeSet);
+}
+
+void ARPGPlayerControllerBase::HandleWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		FlushInventoryNotifications();
+	}
 }
 
 void ARPGPlayerControllerBase::HandleSaveGameLoaded(URPGSaveGame* NewSaveGame)
@@ -404,4 +877,13 @@ void ARPGPlayerControllerBase::BeginPlay()
 	LoadInventory();
 
 	Super::BeginPlay();
+}
+
+void ARPGPlayerControllerBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	CancelAsyncInventoryLoad();
+	PendingInventoryChanges.Reset();
+	FlushInventoryNotifications();
+
+	Super::EndPlay(EndPlayReason);
 }
\ No newline at end of file
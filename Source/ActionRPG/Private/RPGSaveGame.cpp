@@ -2,11 +2,180 @@
 
 #include "RPGSaveGame.h"
 #include "RPGGameInstanceBase.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/CustomVersion.h"
+
+const FGuid FRPGSaveGameCustomVersion::GUID(0x5D3A7C21, 0x8E4B4F06, 0xA1C93B72, 0x64F0D8E5);
+FCustomVersionRegistration GRegisterRPGSaveGameCustomVersion(FRPGSaveGameCustomVersion::GUID, FRPGSaveGameCustomVersion::LatestVersion, TEXT("RPGSaveGameVer"));
+
+/** Largest compact inventory block that will be read, anything bigger is a corrupt save */
+static const uint32 MaxCompactInventorySize = 64 * 1024 * 1024;
+
+/** Block is only compressed when it is at least this large, below that the compression header costs more than it saves */
+static const int32 MinCompressedInventorySize = 256;
+
+/** Maps signed values to unsigned so small negative numbers stay small when packed */
+static uint32 ZigZagEncode(int32 Value)
+{
+	return ((uint32)Value << 1) ^ (uint32)(Value >> 31);
+}
+
+static int32 ZigZagDecode(uint32 Value)
+{
+	return (int32)(Value >> 1) ^ -(int32)(Value & 1);
+}
+
+static void SerializePackedSigned(FArchive& Ar, int32& Value)
+{
+	uint32 Packed = ZigZagEncode(Value);
+	Ar.SerializeIntPacked(Packed);
+	Value = ZigZagDecode(Packed);
+}
+
+static FName GetCompressionFormat(ERPGSaveGameCompression Compression)
+{
+	switch (Compression)
+	{
+	case ERPGSaveGameCompression::Zlib:
+		return NAME_Zlib;
+	case ERPGSaveGameCompression::Oodle:
+		return NAME_Oodle;
+	default:
+		return NAME_None;
+	}
+}
+
+/** Interned strings for the compact inventory block, written once and referenced by index */
+struct FRPGSaveGameStringTable
+{
+	TArray<FName> Names;
+	TMap<FName, uint32> Indices;
+
+	uint32 Intern(FName Name)
+	{
+		if (const uint32* Index = Indices.Find(Name))
+		{
+			return *Index;
+		}
+
+		const uint32 Index = Names.Add(Name);
+		Indices.Add(Name, Index);
+		return Index;
+	}
+
+	void Serialize(FArchive& Ar)
+	{
+		uint32 NumNames = Names.Num();
+		Ar.SerializeIntPacked(NumNames);
+
+		if (Ar.IsLoading())
+		{
+			// Every string takes at least one byte, so a larger count can only come from a corrupt save
+			if (NumNames > (uint32)(Ar.TotalSize() - Ar.Tell()))
+			{
+				Ar.SetError();
+				return;
+			}
+			Names.SetNum(NumNames);
+		}
+
+		for (FName& Name : Names)
+		{
+			if (Ar.IsLoading())
+			{
+				uint32 Length = 0;
+				Ar.SerializeIntPacked(Length);
+				if (Ar.IsError() || Length > (uint32)(Ar.TotalSize() - Ar.Tell()))
+				{
+					Ar.SetError();
+					return;
+				}
+
+				TArray<ANSICHAR> Utf8;
+				Utf8.SetNumUninitialized(Length + 1);
+				Ar.Serialize(Utf8.GetData(), Length);
+				Utf8[Length] = 0;
+
+				Name = FName(FUTF8ToTCHAR(Utf8.GetData()).Get());
+			}
+			else
+			{
+				FTCHARToUTF8 Utf8(*Name.ToString());
+				uint32 Length = Utf8.Length();
+				Ar.SerializeIntPacked(Length);
+				Ar.Serialize((void*)Utf8.Get(), Length);
+			}
+		}
+	}
+
+	/** Returns the name at Index, flagging the archive if it is out of range */
+	FName Get(FArchive& Ar, uint32 Index) const
+	{
+		if (!Names.IsValidIndex(Index))
+		{
+			Ar.SetError();
+			return NAME_None;
+		}
+		return Names[Index];
+	}
+};
 
 void URPGSaveGame::Serialize(FArchive& Ar)
 {
+	// Only archives that read or write the full object carry the compact block, reference collectors and the like just see the tagged properties
+	const bool bFullSerialize = (Ar.IsLoading() || Ar.IsSaving()) && !Ar.IsObjectReferenceCollector() && !Ar.IsCountingMemory();
+
+	Ar.UsingCustomVersion(FRPGSaveGameCustomVersion::GUID);
+
+	if (Ar.IsSaving() && bFullSerialize)
+	{
+		if (!bWriteCompactInventory)
+		{
+			const int32 CurrentVersion = SavedDataVersion;
+			SavedDataVersion = ERPGSaveGameVersion::AddedInventoryJournal;
+			Super::Serialize(Ar);
+			SavedDataVersion = CurrentVersion;
+			return;
+		}
+
+		SavedDataVersion = ERPGSaveGameVersion::LatestVersion;
+
+		// Empty maps match the class defaults so tagged serialization leaves them out entirely
+		TMap<FPrimaryAssetId, FRPGItemData> SavedInventoryData = MoveTemp(InventoryData);
+		TMap<FRPGItemSlot, FPrimaryAssetId> SavedSlottedItems = MoveTemp(SlottedItems);
+		InventoryData.Reset();
+		SlottedItems.Reset();
+
+		Super::Serialize(Ar);
+
+		InventoryData = MoveTemp(SavedInventoryData);
+		SlottedItems = MoveTemp(SavedSlottedItems);
+
+		SerializeCompactInventory(Ar);
+		return;
+	}
+
 	Super::Serialize(Ar);
 
+	if (Ar.IsLoading() && Ar.IsSaveGame() && Ar.CustomVer(FRPGSaveGameCustomVersion::GUID) < FRPGSaveGameCustomVersion::SavedDataVersionIsReliable)
+	{
+		// A slot written before the compact block existed, a missing SavedDataVersion was loaded as the current default
+		SavedDataVersion = FMath::Min(SavedDataVersion, (int32)ERPGSaveGameVersion::AddedInventoryJournal);
+	}
+
+	if (Ar.IsLoading() && bFullSerialize && SavedDataVersion >= ERPGSaveGameVersion::CompactInventory)
+	{
+		SerializeCompactInventory(Ar);
+	}
+
+	if (Ar.IsLoading() && bFullSerialize)
+	{
+		// LoadGameFromMemory returns the object without looking at the archive, so the error has to be kept on the object
+		bLoadFailed = Ar.IsError();
+	}
+
 	if (Ar.IsLoading() && SavedDataVersion != ERPGSaveGameVersion::LatestVersion)
 	{
 		if (SavedDataVersion < ERPGSaveGameVersion::AddedItemData)
@@ -19,7 +188,213 @@ void URPGSaveGame::Serialize(FArchive& Ar)
 
 			InventoryItems_DEPRECATED.Empty();
 		}
-		
+
+		// Older saves read the inventory from tagged properties above, the next save writes it in the compact layout
 		SavedDataVersion = ERPGSaveGameVersion::LatestVersion;
 	}
-}
\ No newline at end of file
+}
+
+void URPGSaveGame::SerializeCompactInventory(FArchive& Ar)
+{
+	if (Ar.IsSaving())
+	{
+		FRPGSaveGameStringTable Strings;
+		TArray<uint8> Entries;
+		FMemoryWriter EntryWriter(Entries);
+
+		uint32 NumItems = InventoryData.Num();
+		EntryWriter.SerializeIntPacked(NumItems);
+		for (const TPair<FPrimaryAssetId, FRPGItemData>& Pair : InventoryData)
+		{
+			uint32 TypeIndex = Strings.Intern(Pair.Key.PrimaryAssetType.GetName());
+			uint32 NameIndex = Strings.Intern(Pair.Key.PrimaryAssetName);
+			int32 ItemCount = Pair.Value.ItemCount;
+			int32 ItemLevel = Pair.Value.ItemLevel;
+			EntryWriter.SerializeIntPacked(TypeIndex);
+			EntryWriter.SerializeIntPacked(NameIndex);
+			SerializePackedSigned(EntryWriter, ItemCount);
+			SerializePackedSigned(EntryWriter, ItemLevel);
+		}
+
+		uint32 NumSlots = SlottedItems.Num();
+		EntryWriter.SerializeIntPacked(NumSlots);
+		for (const TPair<FRPGItemSlot, FPrimaryAssetId>& Pair : SlottedItems)
+		{
+			uint32 SlotTypeIndex = Strings.Intern(Pair.Key.ItemType.GetName());
+			int32 SlotNumber = Pair.Key.SlotNumber;
+			EntryWriter.SerializeIntPacked(SlotTypeIndex);
+			SerializePackedSigned(EntryWriter, SlotNumber);
+
+			// Index 0 is an empty slot, everything else is offset by one
+			uint32 ItemTypeIndex = Pair.Value.IsValid() ? Strings.Intern(Pair.Value.PrimaryAssetType.GetName()) + 1 : 0;
+			EntryWriter.SerializeIntPacked(ItemTypeIndex);
+			if (ItemTypeIndex != 0)
+			{
+				uint32 ItemNameIndex = Strings.Intern(Pair.Value.PrimaryAssetName);
+				EntryWriter.SerializeIntPacked(ItemNameIndex);
+			}
+		}
+
+		// The string table goes first so loading can resolve entries in a single pass
+		TArray<uint8> Block;
+		FMemoryWriter BlockWriter(Block);
+		Strings.Serialize(BlockWriter);
+		BlockWriter.Serialize(Entries.GetData(), Entries.Num());
+
+		uint8 CompressionMethod = (uint8)ERPGSaveGameCompression::None;
+		TArray<uint8> CompressedBlock;
+
+		const FName CompressionFormat = GetCompressionFormat(Compression);
+		if (!CompressionFormat.IsNone() && Block.Num() >= MinCompressedInventorySize)
+		{
+			int32 CompressedSize = FCompression::CompressMemoryBound(CompressionFormat, Block.Num());
+			CompressedBlock.SetNumUninitialized(CompressedSize);
+
+			if (FCompression::CompressMemory(CompressionFormat, CompressedBlock.GetData(), CompressedSize, Block.GetData(), Block.Num()) && CompressedSize < Block.Num())
+			{
+				CompressedBlock.SetNum(CompressedSize, false);
+				CompressionMethod = (uint8)Compression;
+			}
+		}
+
+		uint32 UncompressedSize = Block.Num();
+		Ar << CompressionMethod;
+		Ar.SerializeIntPacked(UncompressedSize);
+
+		if (CompressionMethod != (uint8)ERPGSaveGameCompression::None)
+		{
+			uint32 CompressedSize = CompressedBlock.Num();
+			Ar.SerializeIntPacked(CompressedSize);
+			Ar.Serialize(CompressedBlock.GetData(), CompressedBlock.Num());
+		}
+		else
+		{
+			Ar.Serialize(Block.GetData(), Block.Num());
+		}
+		return;
+	}
+
+	uint8 CompressionMethod = 0;
+	uint32 UncompressedSize = 0;
+	Ar << CompressionMethod;
+	Ar.SerializeIntPacked(UncompressedSize);
+
+	if (Ar.IsError() || UncompressedSize > MaxCompactInventorySize)
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("URPGSaveGame: Compact inventory block is corrupt, inventory not loaded"));
+		Ar.SetError();
+		return;
+	}
+
+	TArray<uint8> Block;
+	Block.SetNumUninitialized(UncompressedSize);
+
+	if (CompressionMethod != (uint8)ERPGSaveGameCompression::None)
+	{
+		uint32 CompressedSize = 0;
+		Ar.SerializeIntPacked(CompressedSize);
+
+		const FName CompressionFormat = GetCompressionFormat((ERPGSaveGameCompression)CompressionMethod);
+		if (Ar.IsError() || CompressionFormat.IsNone() || CompressedSize > MaxCompactInventorySize)
+		{
+			UE_LOG(LogActionRPG, Warning, TEXT("URPGSaveGame: Compact inventory block uses unknown compression %d, inventory not loaded"), CompressionMethod);
+			Ar.SetError();
+			return;
+		}
+
+		TArray<uint8> CompressedBlock;
+		CompressedBlock.SetNumUninitialized(CompressedSize);
+		Ar.Serialize(CompressedBlock.GetData(), CompressedSize);
+
+		if (Ar.IsError() || !FCompression::UncompressMemory(CompressionFormat, Block.GetData(), Block.Num(), CompressedBlock.GetData(), CompressedBlock.Num()))
+		{
+			UE_LOG(LogActionRPG, Warning, TEXT("URPGSaveGame: Failed to decompress compact inventory block, inventory not loaded"));
+			Ar.SetError();
+			return;
+		}
+	}
+	else
+	{
+		Ar.Serialize(Block.GetData(), Block.Num());
+
+		if (Ar.IsError())
+		{
+			UE_LOG(LogActionRPG, Warning, TEXT("URPGSaveGame: Compact inventory block is truncated, inventory not loaded"));
+			return;
+		}
+	}
+
+	FMemoryReader BlockReader(Block);
+	FRPGSaveGameStringTable Strings;
+	Strings.Serialize(BlockReader);
+
+	TMap<FPrimaryAssetId, FRPGItemData> LoadedInventoryData;
+	TMap<FRPGItemSlot, FPrimaryAssetId> LoadedSlottedItems;
+
+	uint32 NumItems = 0;
+	BlockReader.SerializeIntPacked(NumItems);
+	for (uint32 ItemIndex = 0; ItemIndex < NumItems && !BlockReader.IsError(); ItemIndex++)
+	{
+		uint32 TypeIndex = 0;
+		uint32 NameIndex = 0;
+		FRPGItemData ItemData;
+		BlockReader.SerializeIntPacked(TypeIndex);
+		BlockReader.SerializeIntPacked(NameIndex);
+		SerializePackedSigned(BlockReader, ItemData.ItemCount);
+		SerializePackedSigned(BlockReader, ItemData.ItemLevel);
+
+		const FPrimaryAssetId ItemId(Strings.Get(BlockReader, TypeIndex), Strings.Get(BlockReader, NameIndex));
+		LoadedInventoryData.Add(ItemId, ItemData);
+	}
+
+	uint32 NumSlots = 0;
+	BlockReader.SerializeIntPacked(NumSlots);
+	for (uint32 SlotIndex = 0; SlotIndex < NumSlots && !BlockReader.IsError(); SlotIndex++)
+	{
+		uint32 SlotTypeIndex = 0;
+		int32 SlotNumber = 0;
+		uint32 ItemTypeIndex = 0;
+		BlockReader.SerializeIntPacked(SlotTypeIndex);
+		SerializePackedSigned(BlockReader, SlotNumber);
+		BlockReader.SerializeIntPacked(ItemTypeIndex);
+
+		FPrimaryAssetId ItemId;
+		if (ItemTypeIndex != 0)
+		{
+			uint32 ItemNameIndex = 0;
+			BlockReader.SerializeIntPacked(ItemNameIndex);
+			ItemId = FPrimaryAssetId(Strings.Get(BlockReader, ItemTypeIndex - 1), Strings.Get(BlockReader, ItemNameIndex));
+		}
+
+		LoadedSlottedItems.Add(FRPGItemSlot(Strings.Get(BlockReader, SlotTypeIndex), SlotNumber), ItemId);
+	}
+
+	if (BlockReader.IsError())
+	{
+		UE_LOG(LogActionRPG, Warning, TEXT("URPGSaveGame: Compact inventory block is corrupt, inventory not loaded"));
+		Ar.SetError();
+		return;
+	}
+
+	InventoryData = MoveTemp(LoadedInventoryData);
+	SlottedItems = MoveTemp(LoadedSlottedItems);
+}
+
+void URPGSaveGame::ApplyJournalEntry(const FRPGInventoryJournalEntry& Entry)
+{
+	switch (Entry.Op)
+	{
+	case ERPGInventoryJournalOp::ItemAdded:
+	case ERPGInventoryJournalOp::ItemDataChanged:
+		InventoryData.Add(Entry.ItemId, Entry.ItemData);
+		break;
+	case ERPGInventoryJournalOp::ItemRemoved:
+		InventoryData.Remove(Entry.ItemId);
+		break;
+	case ERPGInventoryJournalOp::SlotChanged:
+		SlottedItems.Add(Entry.ItemSlot, Entry.ItemId);
+		break;
+	}
+
+	JournalSequence = FMath::Max(JournalSequence, Entry.Sequence);
+}
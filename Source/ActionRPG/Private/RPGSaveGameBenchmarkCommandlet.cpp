@@ -0,0 +1,151 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "RPGSaveGameBenchmarkCommandlet.h"
+#include "RPGAssetManager.h"
+#include "RPGGameInstanceBase.h"
+#include "Kismet/GameplayStatics.h"
+
+URPGSaveGameBenchmarkCommandlet::URPGSaveGameBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 URPGSaveGameBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 NumItems = 2000;
+	int32 NumSlots = 12;
+	int32 NumIterations = 200;
+
+	FParse::Value(*Params, TEXT("Items="), NumItems);
+	FParse::Value(*Params, TEXT("Slots="), NumSlots);
+	FParse::Value(*Params, TEXT("Iterations="), NumIterations);
+	NumIterations = FMath::Max(NumIterations, 1);
+
+	URPGSaveGame* SaveGame = Cast<URPGSaveGame>(UGameplayStatics::CreateSaveGameObject(URPGSaveGame::StaticClass()));
+	SaveGame->UserId = TEXT("RPGSaveGameBenchmark");
+
+	// Names follow the item asset naming so string lengths are representative
+	const FPrimaryAssetType ItemTypes[] = { URPGAssetManager::PotionItemType, URPGAssetManager::SkillItemType, URPGAssetManager::TokenItemType, URPGAssetManager::WeaponItemType };
+	FRandomStream Random(1234);
+
+	for (int32 ItemIndex = 0; ItemIndex < NumItems; ItemIndex++)
+	{
+		const FPrimaryAssetType& ItemType = ItemTypes[ItemIndex % UE_ARRAY_COUNT(ItemTypes)];
+		const FPrimaryAssetId ItemId(ItemType, *FString::Printf(TEXT("%s_Item_%d"), *ItemType.ToString(), ItemIndex));
+		SaveGame->InventoryData.Add(ItemId, FRPGItemData(Random.RandRange(1, 99), Random.RandRange(1, 10)));
+	}
+
+	TArray<FPrimaryAssetId> ItemIds;
+	SaveGame->InventoryData.GetKeys(ItemIds);
+
+	for (int32 SlotIndex = 0; SlotIndex < NumSlots; SlotIndex++)
+	{
+		const FPrimaryAssetType& SlotType = ItemTypes[SlotIndex % UE_ARRAY_COUNT(ItemTypes)];
+		const FPrimaryAssetId ItemId = ItemIds.Num() > 0 && SlotIndex % 3 != 2 ? ItemIds[Random.RandRange(0, ItemIds.Num() - 1)] : FPrimaryAssetId();
+		SaveGame->SlottedItems.Add(FRPGItemSlot(SlotType, SlotIndex / UE_ARRAY_COUNT(ItemTypes)), ItemId);
+	}
+
+	UE_LOG(LogActionRPG, Display, TEXT("RPGSaveGameBenchmark: %d items, %d slots, %d iterations"), SaveGame->InventoryData.Num(), SaveGame->SlottedItems.Num(), NumIterations);
+
+	bool bAllMatched = true;
+	bAllMatched &= RunFormat(TEXT("Tagged"), SaveGame, false, ERPGSaveGameCompression::None, NumIterations);
+	bAllMatched &= RunFormat(TEXT("Compact"), SaveGame, true, ERPGSaveGameCompression::None, NumIterations);
+	bAllMatched &= RunFormat(TEXT("Compact+Zlib"), SaveGame, true, ERPGSaveGameCompression::Zlib, NumIterations);
+	bAllMatched &= RunFormat(TEXT("Compact+Oodle"), SaveGame, true, ERPGSaveGameCompression::Oodle, NumIterations);
+
+	if (FParse::Param(*Params, TEXT("StartupLoad")))
+	{
+		bAllMatched &= RunStartupLoad(SaveGame, NumIterations);
+	}
+
+	return bAllMatched ? 0 : 1;
+}
+
+bool URPGSaveGameBenchmarkCommandlet::RunFormat(const TCHAR* FormatName, URPGSaveGame* SaveGame, bool bCompactInventory, ERPGSaveGameCompression Compression, int32 NumIterations)
+{
+	SaveGame->SetWriteCompactInventory(bCompactInventory);
+	SaveGame->SetCompression(Compression);
+
+	TArray<uint8> SaveData;
+	uint64 SaveCycles = 0;
+	uint64 LoadCycles = 0;
+	URPGSaveGame* LoadedSave = nullptr;
+
+	for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+	{
+		SaveData.Reset();
+
+		const uint64 SaveStartCycles = FPlatformTime::Cycles64();
+		UGameplayStatics::SaveGameToMemory(SaveGame, SaveData);
+		SaveCycles += FPlatformTime::Cycles64() - SaveStartCycles;
+
+		const uint64 LoadStartCycles = FPlatformTime::Cycles64();
+		LoadedSave = Cast<URPGSaveGame>(UGameplayStatics::LoadGameFromMemory(SaveData));
+		LoadCycles += FPlatformTime::Cycles64() - LoadStartCycles;
+	}
+
+	SaveGame->SetWriteCompactInventory(true);
+	SaveGame->SetCompression(ERPGSaveGameCompression::None);
+
+	const bool bMatched = LoadedSave && LoadedSave->InventoryData.OrderIndependentCompareEqual(SaveGame->InventoryData) && LoadedSave->SlottedItems.OrderIndependentCompareEqual(SaveGame->SlottedItems);
+
+	UE_LOG(LogActionRPG, Display, TEXT("RPGSaveGameBenchmark: %-14s %8d bytes, save %.1f us, load %.1f us%s"), FormatName, SaveData.Num(),
+		FPlatformTime::ToMilliseconds64(SaveCycles) * 1000.0 / NumIterations, FPlatformTime::ToMilliseconds64(LoadCycles) * 1000.0 / NumIterations,
+		bMatched ? TEXT("") : TEXT(", LOADED INVENTORY DOES NOT MATCH"));
+
+	return bMatched;
+}
+
+bool URPGSaveGameBenchmarkCommandlet::RunStartupLoad(URPGSaveGame* SaveGame, int32 NumIterations)
+{
+	URPGGameInstanceBase* GameInstance = NewObject<URPGGameInstanceBase>(GetTransientPackage());
+	GameInstance->SaveSlot = TEXT("RPGSaveGameBenchmark");
+	GameInstance->SetSavingEnabled(true);
+
+	if (!UGameplayStatics::SaveGameToSlot(SaveGame, GameInstance->SaveSlot, GameInstance->SaveUserIndex))
+	{
+		UE_LOG(LogActionRPG, Error, TEXT("RPGSaveGameBenchmark: Could not write slot %s"), *GameInstance->SaveSlot);
+		return false;
+	}
+
+	uint64 SyncBlockedCycles = 0;
+	uint64 AsyncBlockedCycles = 0;
+	uint64 AsyncReadyCycles = 0;
+	bool bAllLoaded = true;
+
+	for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+	{
+		const uint64 SyncStartCycles = FPlatformTime::Cycles64();
+		bAllLoaded &= GameInstance->LoadOrCreateSaveGame();
+		SyncBlockedCycles += FPlatformTime::Cycles64() - SyncStartCycles;
+
+		bool bAsyncDone = false;
+		const uint64 AsyncStartCycles = FPlatformTime::Cycles64();
+		GameInstance->LoadOrCreateSaveGameAsyncNative(FOnSaveGameLoadCompleteNative::CreateLambda([&bAsyncDone, &bAllLoaded](bool bLoaded)
+		{
+			bAllLoaded &= bLoaded;
+			bAsyncDone = true;
+		}));
+		AsyncBlockedCycles += FPlatformTime::Cycles64() - AsyncStartCycles;
+
+		// Nothing else runs on the game thread here, so the time until ready is the worker thread load plus the hand back
+		while (!bAsyncDone)
+		{
+			FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+			FPlatformProcess::Sleep(0.f);
+		}
+		AsyncReadyCycles += FPlatformTime::Cycles64() - AsyncStartCycles;
+	}
+
+	UGameplayStatics::DeleteGameInSlot(GameInstance->SaveSlot, GameInstance->SaveUserIndex);
+
+	UE_LOG(LogActionRPG, Display, TEXT("RPGSaveGameBenchmark: Startup sync  blocked %.1f us"), FPlatformTime::ToMilliseconds64(SyncBlockedCycles) * 1000.0 / NumIterations);
+	UE_LOG(LogActionRPG, Display, TEXT("RPGSaveGameBenchmark: Startup async blocked %.1f us, ready after %.1f us%s"),
+		FPlatformTime::ToMilliseconds64(AsyncBlockedCycles) * 1000.0 / NumIterations, FPlatformTime::ToMilliseconds64(AsyncReadyCycles) * 1000.0 / NumIterations,
+		bAllLoaded ? TEXT("") : TEXT(", A LOAD CREATED A NEW SAVE GAME"));
+
+	return bAllLoaded;
+}
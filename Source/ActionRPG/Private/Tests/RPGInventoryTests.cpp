@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "RPGPlayerControllerBase.h"
+#include "RPGGameInstanceBase.h"
+#include "RPGAssetManager.h"
+#include "RPGSaveGame.h"
+#include "Items/RPGItem.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRPGInventoryTest_ChangeDuringLoad, "ActionRPG.Inventory.ChangeDuringLoad", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FRPGInventoryTest_ChangeDuringLoad::RunTest(const FString& Parameters)
+{
+	URPGItem* Item = URPGAssetManager::Get().ForceLoadItem(FPrimaryAssetId(URPGAssetManager::TokenItemType, TEXT("Token_Souls")));
+	if (!TestNotNull(TEXT("Token_Souls"), Item))
+	{
+		return false;
+	}
+
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Game, false);
+
+	// Saving stays disabled, so nothing is written to a real slot
+	URPGGameInstanceBase* GameInstance = NewObject<URPGGameInstanceBase>((UObject*)GetTransientPackage());
+	GameInstance->SetSavingEnabled(false);
+	GameInstance->HandleSaveGameLoaded(nullptr);
+	GameInstance->GetCurrentSaveGame()->InventoryData.Add(Item->GetPrimaryAssetId(), FRPGItemData(3, 1));
+	TestWorld->SetGameInstance(GameInstance);
+
+	ARPGPlayerControllerBase* PlayerController = TestWorld->SpawnActor<ARPGPlayerControllerBase>();
+
+	// As if StartAsyncInventoryLoad was still waiting for the items
+	PlayerController->bInventoryLoading = true;
+
+	TestTrue(TEXT("AddInventoryItem"), PlayerController->AddInventoryItem(Item, 2, 1));
+	TestEqual(TEXT("nothing applied while loading"), PlayerController->GetInventoryItemCount(Item), 0);
+	TestEqual(TEXT("saved count untouched while loading"), GameInstance->GetCurrentSaveGame()->InventoryData.FindRef(Item->GetPrimaryAssetId()).ItemCount, 3);
+
+	PlayerController->RestoreInventoryFromSaveGame();
+
+	FRPGItemData Expected(3, 1);
+	Expected.UpdateItemData(FRPGItemData(2, 1), Item->MaxCount, Item->MaxLevel);
+
+	TestFalse(TEXT("IsInventoryLoading"), PlayerController->IsInventoryLoading());
+	TestEqual(TEXT("added on top of the saved count"), PlayerController->GetInventoryItemCount(Item), Expected.ItemCount);
+	TestEqual(TEXT("saved count includes the change"), GameInstance->GetCurrentSaveGame()->InventoryData.FindRef(Item->GetPrimaryAssetId()).ItemCount, Expected.ItemCount);
+
+	TestWorld->DestroyWorld(false);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRPGInventoryTest_FailedChangeDuringLoad, "ActionRPG.Inventory.FailedChangeDuringLoad", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FRPGInventoryTest_FailedChangeDuringLoad::RunTest(const FString& Parameters)
+{
+	URPGItem* Item = URPGAssetManager::Get().ForceLoadItem(FPrimaryAssetId(URPGAssetManager::TokenItemType, TEXT("Token_Souls")));
+	if (!TestNotNull(TEXT("Token_Souls"), Item))
+	{
+		return false;
+	}
+
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Game, false);
+
+	URPGGameInstanceBase* GameInstance = NewObject<URPGGameInstanceBase>((UObject*)GetTransientPackage());
+	GameInstance->SetSavingEnabled(false);
+	GameInstance->HandleSaveGameLoaded(nullptr);
+	GameInstance->GetCurrentSaveGame()->InventoryData.Remove(Item->GetPrimaryAssetId());
+	TestWorld->SetGameInstance(GameInstance);
+
+	ARPGPlayerControllerBase* PlayerController = TestWorld->SpawnActor<ARPGPlayerControllerBase>();
+	PlayerController->bInventoryLoading = true;
+
+	// Nothing to remove once the save is restored, but the caller can't know that yet
+	TestTrue(TEXT("RemoveInventoryItem is deferred"), PlayerController->RemoveInventoryItem(Item, 1));
+
+	int32 NumNotifications = 0;
+	bool bNotifiedAdded = true;
+	PlayerController->OnInventoryItemChangedNative.AddLambda([&NumNotifications, &bNotifiedAdded, Item](bool bAdded, URPGItem* ChangedItem)
+	{
+		if (ChangedItem == Item)
+		{
+			NumNotifications++;
+			bNotifiedAdded = bAdded;
+		}
+	});
+
+	PlayerController->RestoreInventoryFromSaveGame();
+
+	TestEqual(TEXT("failed change notified once"), NumNotifications, 1);
+	TestFalse(TEXT("item reported as not in the inventory"), bNotifiedAdded);
+	TestEqual(TEXT("item count"), PlayerController->GetInventoryItemCount(Item), 0);
+
+	TestWorld->DestroyWorld(false);
+
+	return true;
+}
+
+#endif
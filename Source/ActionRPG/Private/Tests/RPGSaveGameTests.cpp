@@ -0,0 +1,219 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "RPGSaveGame.h"
+#include "RPGAssetManager.h"
+#include "RPGGameInstanceBase.h"
+#include "Kismet/GameplayStatics.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "Misc/AutomationTest.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRPGSaveGameTest_PreCompactUpgrade, "ActionRPG.SaveGame.PreCompactUpgrade", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FRPGSaveGameTest_PreCompactUpgrade::RunTest(const FString& Parameters)
+{
+	const FPrimaryAssetId PotionId(URPGAssetManager::PotionItemType, TEXT("Potion_Health"));
+	const FPrimaryAssetId WeaponId(URPGAssetManager::WeaponItemType, TEXT("Weapon_Axe"));
+	const FRPGItemSlot WeaponSlot(URPGAssetManager::WeaponItemType, 0);
+
+	URPGSaveGame* OldSave = NewObject<URPGSaveGame>();
+	OldSave->UserId = TEXT("PreCompactUpgrade");
+	OldSave->InventoryData.Add(PotionId, FRPGItemData(5, 1));
+	OldSave->InventoryData.Add(WeaponId, FRPGItemData(1, 3));
+	OldSave->SlottedItems.Add(WeaponSlot, WeaponId);
+
+	// Before the compact block the override only fixed up loads, saving was plain tagged serialization without the custom version.
+	// SavedDataVersion matches the class default here, so like in those saves it is left out of the data
+	TArray<uint8> OldBytes;
+	FMemoryWriter MemoryWriter(OldBytes, true);
+	FObjectAndNameAsStringProxyArchive WriteAr(MemoryWriter, false);
+	WriteAr.ArIsSaveGame = true;
+	OldSave->USaveGame::Serialize(WriteAr);
+
+	URPGSaveGame* LoadedSave = NewObject<URPGSaveGame>();
+	FMemoryReader MemoryReader(OldBytes, true);
+	FObjectAndNameAsStringProxyArchive ReadAr(MemoryReader, true);
+	ReadAr.ArIsSaveGame = true;
+	static_cast<UObject*>(LoadedSave)->Serialize(ReadAr);
+
+	TestFalse(TEXT("old save read without errors"), ReadAr.IsError());
+	TestEqual(TEXT("old save UserId"), LoadedSave->UserId, OldSave->UserId);
+	TestEqual(TEXT("old save inventory size"), LoadedSave->InventoryData.Num(), 2);
+	TestEqual(TEXT("old save potion count"), LoadedSave->InventoryData.FindRef(PotionId).ItemCount, 5);
+	TestEqual(TEXT("old save weapon level"), LoadedSave->InventoryData.FindRef(WeaponId).ItemLevel, 3);
+	TestTrue(TEXT("old save slotted weapon"), LoadedSave->SlottedItems.FindRef(WeaponSlot) == WeaponId);
+
+	// The next save after the upgrade is in the compact layout and has to come back the same
+	TArray<uint8> NewBytes;
+	if (!TestTrue(TEXT("SaveGameToMemory"), UGameplayStatics::SaveGameToMemory(LoadedSave, NewBytes)))
+	{
+		return false;
+	}
+
+	URPGSaveGame* ReloadedSave = Cast<URPGSaveGame>(UGameplayStatics::LoadGameFromMemory(NewBytes));
+	if (!TestNotNull(TEXT("LoadGameFromMemory"), ReloadedSave))
+	{
+		return false;
+	}
+
+	TestEqual(TEXT("upgraded save inventory size"), ReloadedSave->InventoryData.Num(), 2);
+	TestEqual(TEXT("upgraded save potion count"), ReloadedSave->InventoryData.FindRef(PotionId).ItemCount, 5);
+	TestTrue(TEXT("upgraded save slotted weapon"), ReloadedSave->SlottedItems.FindRef(WeaponSlot) == WeaponId);
+
+	return true;
+}
+
+/** Fills a save with enough items that the compact block is large enough to be compressed */
+static URPGSaveGame* CreateTestSaveGame(int32 NumItems)
+{
+	URPGSaveGame* SaveGame = NewObject<URPGSaveGame>();
+	SaveGame->UserId = TEXT("RPGSaveGameTests");
+
+	for (int32 ItemIndex = 0; ItemIndex < NumItems; ItemIndex++)
+	{
+		SaveGame->InventoryData.Add(FPrimaryAssetId(URPGAssetManager::PotionItemType, *FString::Printf(TEXT("Potion_Item_%d"), ItemIndex)), FRPGItemData(ItemIndex % 99 + 1, ItemIndex % 10 + 1));
+	}
+	SaveGame->SlottedItems.Add(FRPGItemSlot(URPGAssetManager::PotionItemType, 0), FPrimaryAssetId(URPGAssetManager::PotionItemType, TEXT("Potion_Item_0")));
+	SaveGame->SlottedItems.Add(FRPGItemSlot(URPGAssetManager::WeaponItemType, 0), FPrimaryAssetId());
+
+	return SaveGame;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRPGSaveGameTest_CompressedRoundTrip, "ActionRPG.SaveGame.CompressedRoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FRPGSaveGameTest_CompressedRoundTrip::RunTest(const FString& Parameters)
+{
+	URPGSaveGame* SaveGame = CreateTestSaveGame(200);
+
+	TArray<uint8> UncompressedBytes;
+	if (!TestTrue(TEXT("SaveGameToMemory uncompressed"), UGameplayStatics::SaveGameToMemory(SaveGame, UncompressedBytes)))
+	{
+		return false;
+	}
+
+	const ERPGSaveGameCompression Compressions[] = { ERPGSaveGameCompression::Zlib, ERPGSaveGameCompression::Oodle };
+	for (ERPGSaveGameCompression Compression : Compressions)
+	{
+		const FString Method = UEnum::GetValueAsString(Compression);
+
+		TArray<uint8> Bytes;
+		SaveGame->SetCompression(Compression);
+		if (!TestTrue(FString::Printf(TEXT("%s SaveGameToMemory"), *Method), UGameplayStatics::SaveGameToMemory(SaveGame, Bytes)))
+		{
+			continue;
+		}
+		TestTrue(FString::Printf(TEXT("%s save is smaller than uncompressed"), *Method), Bytes.Num() < UncompressedBytes.Num());
+
+		URPGSaveGame* LoadedSave = Cast<URPGSaveGame>(UGameplayStatics::LoadGameFromMemory(Bytes));
+		if (!TestNotNull(FString::Printf(TEXT("%s LoadGameFromMemory"), *Method), LoadedSave))
+		{
+			continue;
+		}
+
+		TestFalse(FString::Printf(TEXT("%s load failed"), *Method), LoadedSave->HasLoadFailed());
+		TestTrue(FString::Printf(TEXT("%s inventory matches"), *Method), LoadedSave->InventoryData.OrderIndependentCompareEqual(SaveGame->InventoryData));
+		TestTrue(FString::Printf(TEXT("%s slots match"), *Method), LoadedSave->SlottedItems.OrderIndependentCompareEqual(SaveGame->SlottedItems));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRPGSaveGameTest_CorruptBlockRejected, "ActionRPG.SaveGame.CorruptBlockRejected", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FRPGSaveGameTest_CorruptBlockRejected::RunTest(const FString& Parameters)
+{
+	AddExpectedError(TEXT("inventory not loaded"), EAutomationExpectedErrorFlags::Contains, 0);
+	AddExpectedError(TEXT("is corrupt, starting a new save game"), EAutomationExpectedErrorFlags::Contains, 1);
+	AddExpectedError(TEXT("Not saving over corrupt save slot"), EAutomationExpectedErrorFlags::Contains, 1);
+
+	URPGSaveGame* SaveGame = CreateTestSaveGame(200);
+
+	// The compact block is the last thing in the save, cutting the end off leaves it short in both the plain and compressed layouts
+	const ERPGSaveGameCompression Compressions[] = { ERPGSaveGameCompression::None, ERPGSaveGameCompression::Zlib };
+	URPGSaveGame* CorruptSave = nullptr;
+
+	for (ERPGSaveGameCompression Compression : Compressions)
+	{
+		const FString Method = UEnum::GetValueAsString(Compression);
+
+		TArray<uint8> Bytes;
+		SaveGame->SetCompression(Compression);
+		UGameplayStatics::SaveGameToMemory(SaveGame, Bytes);
+		Bytes.SetNum(Bytes.Num() - 64, false);
+
+		CorruptSave = Cast<URPGSaveGame>(UGameplayStatics::LoadGameFromMemory(Bytes));
+		if (!TestNotNull(FString::Printf(TEXT("%s LoadGameFromMemory"), *Method), CorruptSave))
+		{
+			return false;
+		}
+		TestTrue(FString::Printf(TEXT("%s load failed"), *Method), CorruptSave->HasLoadFailed());
+		TestEqual(FString::Printf(TEXT("%s inventory size"), *Method), CorruptSave->InventoryData.Num(), 0);
+	}
+
+	// The game instance plays on a new save and refuses to write over the corrupt slot until it is reset
+	URPGGameInstanceBase* GameInstance = NewObject<URPGGameInstanceBase>(GetTransientPackage());
+	GameInstance->SaveSlot = TEXT("RPGSaveGameTests");
+	GameInstance->SetSavingEnabled(true);
+
+	TestFalse(TEXT("HandleSaveGameLoaded with a corrupt save"), GameInstance->HandleSaveGameLoaded(CorruptSave));
+	TestTrue(TEXT("save slot is corrupt"), GameInstance->IsSaveSlotCorrupt());
+	TestTrue(TEXT("corrupt save is not the current save"), GameInstance->GetCurrentSaveGame() != CorruptSave);
+	TestFalse(TEXT("WriteSaveGame over a corrupt slot"), GameInstance->WriteSaveGame());
+
+	GameInstance->ResetSaveGame();
+	TestFalse(TEXT("save slot is corrupt after reset"), GameInstance->IsSaveSlotCorrupt());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRPGSaveGameTest_WriteQueue, "ActionRPG.SaveGame.WriteQueue", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FRPGSaveGameTest_WriteQueue::RunTest(const FString& Parameters)
+{
+	URPGGameInstanceBase* GameInstance = NewObject<URPGGameInstanceBase>(GetTransientPackage());
+	const TPair<FString, int32> SlotKey(TEXT("RPGSaveGameTests_WriteQueue"), 0);
+
+	TArray<FString> Completed;
+	TArray<URPGSaveGame*> SaveGames;
+	for (const TCHAR* UserId : { TEXT("First"), TEXT("Second"), TEXT("Third") })
+	{
+		URPGSaveGame* SaveGame = NewObject<URPGSaveGame>();
+		SaveGame->UserId = UserId;
+		SaveGames.Add(SaveGame);
+
+		TestTrue(FString::Printf(TEXT("queue %s"), UserId), GameInstance->QueueSaveGameWrite(SaveGame, SlotKey.Key, SlotKey.Value, FOnSaveGameWrittenNative::CreateLambda([&Completed, UserId](bool bSuccess)
+		{
+			Completed.Add(bSuccess ? FString(UserId) : FString::Printf(TEXT("%s failed"), UserId));
+		})));
+	}
+
+	// The first write went straight out, the other two collapse into the newest while it is in flight
+	const URPGGameInstanceBase::FSaveSlotWriteState* WriteState = GameInstance->SaveSlotWrites.Find(SlotKey);
+	if (!TestNotNull(TEXT("slot write state"), WriteState))
+	{
+		return false;
+	}
+	TestTrue(TEXT("first write in flight"), WriteState->InFlightWrite.IsValid());
+	TestEqual(TEXT("in flight callbacks"), WriteState->InFlightCallbacks.Num(), 1);
+	TestEqual(TEXT("pending callbacks"), WriteState->PendingCallbacks.Num(), 2);
+	TestTrue(TEXT("newest save is pending"), WriteState->PendingSaveGame.Get() == SaveGames[2]);
+
+	// Nothing finishes until the game thread handles it, flushing has to write the pending save and call every callback
+	GameInstance->FlushSaveGameWrites();
+
+	TestFalse(TEXT("write in progress after flush"), GameInstance->IsSaveSlotWriteInProgress(SlotKey.Key, SlotKey.Value));
+	TestEqual(TEXT("callbacks called in order"), FString::Join(Completed, TEXT(",")), FString(TEXT("First,Second,Third")));
+
+	URPGSaveGame* LoadedSave = Cast<URPGSaveGame>(UGameplayStatics::LoadGameFromSlot(SlotKey.Key, SlotKey.Value));
+	if (TestNotNull(TEXT("LoadGameFromSlot"), LoadedSave))
+	{
+		TestEqual(TEXT("slot holds the newest save"), LoadedSave->UserId, FString(TEXT("Third")));
+	}
+
+	UGameplayStatics::DeleteGameInSlot(SlotKey.Key, SlotKey.Value);
+	return true;
+}
+
+#endif
@@ -7,9 +7,11 @@
 #include "ActionRPG.h"
 #include "AbilitySystemComponent.h"
 #include "Abilities/RPGAbilityTypes.h"
+#include "Abilities/RPGGameplayAbility.h"
 #include "RPGAbilitySystemComponent.generated.h"
 
-class URPGGameplayAbility;
+/** Listener for gameplay events registered with AddIndexedGameplayEventListener */
+DECLARE_DELEGATE_TwoParams(FRPGGameplayEventListener, FGameplayTag, const FGameplayEventData*);
 
 /**
  * Subclass of ability system component with game-specific data
@@ -23,14 +25,106 @@ class ACTIONRPG_API URPGAbilitySystemComponent : public UAbilitySystemComponent
 public:
 	// Constructors and overrides
 	URPGAbilitySystemComponent();
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+	virtual void NotifyAbilityActivated(const FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability) override;
+	virtual void NotifyAbilityEnded(FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability, bool bWasCancelled) override;
+	virtual int32 HandleGameplayEvent(FGameplayTag EventTag, const FGameplayEventData* Payload) override;
+
+	/**
+	 * Registers a listener for gameplay events matching any of the tags, or for every event if the container is empty
+	 * Listeners are indexed by tag, so an event only visits the listeners registered for its tag or one of its parents
+	 * This is called once per event even if several of the tags match
+	 */
+	FDelegateHandle AddIndexedGameplayEventListener(const FGameplayTagContainer& EventTags, FRPGGameplayEventListener Listener);
+
+	/** Removes a listener added with AddIndexedGameplayEventListener */
+	void RemoveIndexedGameplayEventListener(FDelegateHandle Handle);
 
 	/** Returns a list of currently active ability instances that match the tags */
 	void GetActiveAbilitiesWithTags(const FGameplayTagContainer& GameplayTagContainer, TArray<URPGGameplayAbility*>& ActiveAbilities);
 
+	/**
+	 * Calls Callback for every running ability whose tags match all of the passed in tags, without allocating
+	 * Unlike GetActiveAbilitiesWithTags this only visits abilities between activation and end
+	 * It is safe for the callback to activate or end abilities, changes are seen by the next call
+	 */
+	template<typename CallbackType>
+	void ForEachActiveAbilityWithTags(const FGameplayTagContainer& GameplayTagContainer, CallbackType&& Callback) const
+	{
+		if (!ActiveAbilityTagCounts.HasAllMatchingGameplayTags(GameplayTagContainer))
+		{
+			return;
+		}
+
+		// Copy into an inline view so the callback can change the running set
+		TArray<URPGGameplayAbility*, TInlineAllocator<16>> ActiveView(RunningAbilities);
+
+		for (URPGGameplayAbility* Ability : ActiveView)
+		{
+			if (Ability && Ability->GetAbilityTags().HasAll(GameplayTagContainer))
+			{
+				Callback(Ability);
+			}
+		}
+	}
+
+	/** Returns true if any running ability has this tag, this is a single lookup and does not visit the abilities */
+	bool HasActiveAbilityWithTag(const FGameplayTag& GameplayTag) const
+	{
+		return ActiveAbilityTagCounts.HasMatchingGameplayTag(GameplayTag);
+	}
+
+	/** Returns true if any running ability matches all of the tags */
+	bool HasActiveAbilityWithAllTags(const FGameplayTagContainer& GameplayTagContainer) const;
+
 	/** Returns the default level used for ability activations, derived from the character */
 	int32 GetDefaultAbilityLevel() const;
 
 	/** Version of function in AbilitySystemGlobals that returns correct type */
 	static URPGAbilitySystemComponent* GetAbilitySystemComponentFromActor(const AActor* Actor, bool LookForComponent = false);
 
+	/** Returns a counter that changes whenever an active gameplay effect is added or removed, used to invalidate cached effect queries */
+	uint32 GetActiveEffectsGeneration() const
+	{
+		return ActiveEffectsGeneration;
+	}
+
+protected:
+	/** A registered listener, allocated once when added and shared by every index it appears in */
+	struct FIndexedEventListener
+	{
+		FDelegateHandle Handle;
+		FGameplayTagContainer EventTags;
+		FRPGGameplayEventListener Delegate;
+	};
+	typedef TSharedRef<const FIndexedEventListener> FIndexedEventListenerRef;
+
+	/** Listeners by the exact tag they registered for */
+	TMap<FGameplayTag, TArray<FIndexedEventListenerRef>> EventListenersByTag;
+
+	/** Listeners that registered with an empty container */
+	TArray<FIndexedEventListenerRef> EventListenersForAllTags;
+
+	/** Every registered listener by handle, so it can be removed */
+	TMap<FDelegateHandle, FIndexedEventListenerRef> EventListeners;
+
+	/** Abilities between activation and end, non instanced abilities show up once per activation */
+	UPROPERTY(Transient)
+	TArray<URPGGameplayAbility*> RunningAbilities;
+
+	/** Tags of RunningAbilities with counts, including parent tags. Kept current by NotifyAbilityActivated/NotifyAbilityEnded */
+	FGameplayTagCountContainer ActiveAbilityTagCounts;
+
+	/** Bumped from the active effect added/removed delegates */
+	uint32 ActiveEffectsGeneration;
+
+	/** Delegate handles */
+	FDelegateHandle ActiveEffectAddedHandle;
+	FDelegateHandle ActiveEffectRemovedHandle;
+
+	/** Called when any active gameplay effect is added or removed, on server and clients */
+	void HandleActiveEffectAdded(UAbilitySystemComponent* Target, const FGameplayEffectSpec& SpecApplied, FActiveGameplayEffectHandle ActiveHandle);
+	void HandleActiveEffectRemoved(const FActiveGameplayEffect& RemovedEffect);
+
 };
\ No newline at end of file
@@ -0,0 +1,21 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ActionRPG.h"
+#include "AbilitySystemGlobals.h"
+#include "RPGAbilitySystemGlobals.generated.h"
+
+/**
+ * Game-specific ability system globals, set with AbilitySystemGlobalsClassName in DefaultGame.ini
+ * Used so every effect spec gets an FRPGGameplayEffectContext
+ */
+UCLASS()
+class ACTIONRPG_API URPGAbilitySystemGlobals : public UAbilitySystemGlobals
+{
+	GENERATED_BODY()
+
+public:
+	// Overrides
+	virtual FGameplayEffectContext* AllocGameplayEffectContext() const override;
+};
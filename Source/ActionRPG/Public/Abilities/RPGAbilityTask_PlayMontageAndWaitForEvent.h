@@ -11,6 +11,9 @@ class URPGAbilitySystemComponent;
 /** Delegate type used, EventTag and Payload may be empty if it came from the montage callbacks */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FRPGPlayMontageAndWaitForEventDelegate, FGameplayTag, EventTag, FGameplayEventData, EventData);
 
+/** Delegate type used for events that only need the tag, such as anim notifies */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FRPGPlayMontageEventTagDelegate, FGameplayTag, EventTag);
+
 /**
  * This task combines PlayMontageAndWait and WaitForEvent into one task, so you can wait for multiple types of activations such as from a melee combo
  * Much of this code is copied from one of those two ability tasks
@@ -50,6 +53,10 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FRPGPlayMontageAndWaitForEventDelegate EventReceived;
 
+	/** Same as EventReceived but without the payload, use this for notify-only events so the event data is never copied */
+	UPROPERTY(BlueprintAssignable)
+	FRPGPlayMontageEventTagDelegate EventTagReceived;
+
 	/**
 	 * Play a montage and wait for it end. If a gameplay event happens that matches EventTags (or EventTags is empty), the EventReceived delegate will fire with a tag and event data.
 	 * If StopWhenAbilityEnds is true, this montage will be aborted if the ability ends normally. It is always stopped when the ability is explicitly cancelled.
@@ -17,6 +17,77 @@ class URPGAbilitySystemComponent;
 class UGameplayEffect;
 class URPGTargetType;
 
+/** Source attributes evaluated by the first execution of a spec and reused by every other target, see URPGGameplayAbility::bSnapshotSourceAttributes */
+struct FRPGSourceAttributeSnapshot
+{
+	bool bCaptured = false;
+	float AttackPower = 0.f;
+	float Damage = 0.f;
+};
+
+/**
+ * Game-specific effect context, allocated for every effect spec by URPGAbilitySystemGlobals
+ * Applying a spec to target data duplicates the context for every target, so data that should only be computed once
+ * for the whole activation is kept behind a shared pointer that Duplicate copies by reference
+ */
+USTRUCT()
+struct ACTIONRPG_API FRPGGameplayEffectContext : public FGameplayEffectContext
+{
+	GENERATED_BODY()
+
+public:
+	virtual UScriptStruct* GetScriptStruct() const override
+	{
+		return FRPGGameplayEffectContext::StaticStruct();
+	}
+
+	virtual FRPGGameplayEffectContext* Duplicate() const override
+	{
+		FRPGGameplayEffectContext* NewContext = new FRPGGameplayEffectContext();
+		// SourceSnapshot is copied by pointer, so every target shares one capture
+		*NewContext = *this;
+		if (GetHitResult())
+		{
+			// Does a deep copy of the hit result
+			NewContext->AddHitResult(*GetHitResult(), true);
+		}
+		return NewContext;
+	}
+
+	/** Returns the context as our type if it is one, null otherwise */
+	static FRPGGameplayEffectContext* Get(const FGameplayEffectContextHandle& Handle)
+	{
+		FGameplayEffectContext* Context = Handle.Get();
+		if (Context && Context->GetScriptStruct()->IsChildOf(FRPGGameplayEffectContext::StaticStruct()))
+		{
+			return static_cast<FRPGGameplayEffectContext*>(Context);
+		}
+		return nullptr;
+	}
+
+	/** Makes executions evaluate the source's offensive attributes once, every duplicate of this context made from now on shares the result */
+	void EnableSourceSnapshot()
+	{
+		if (!SourceSnapshot.IsValid())
+		{
+			SourceSnapshot = MakeShared<FRPGSourceAttributeSnapshot>();
+		}
+	}
+
+	/** Filled in by the first execution, null unless EnableSourceSnapshot was called. Server side only, not replicated */
+	TSharedPtr<FRPGSourceAttributeSnapshot> SourceSnapshot;
+};
+
+template<>
+struct TStructOpsTypeTraits<FRPGGameplayEffectContext> : public TStructOpsTypeTraitsBase2<FRPGGameplayEffectContext>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithCopy = true
+	};
+};
+
 
 /**
  * Struct defining a list of gameplay effects, a tag, and targeting info
@@ -62,6 +133,6 @@ public:
 	/** Returns true if this has any valid targets */
 	bool HasValidTargets() const;
 
-	/** Adds new targets to target data */
+	/** Adds new targets to target data, the target data objects are recycled through a pool (see STATGROUP_RPGTargetData) */
 	void AddTargets(const TArray<FHitResult>& HitResults, const TArray<AActor*>& TargetActors);
 };
@@ -21,10 +21,23 @@ public:
 	// Constructor and overrides
 	URPGGameplayAbility();
 
+	/** Returns the tags describing this ability, used by the ability system component to index running abilities */
+	const FGameplayTagContainer& GetAbilityTags() const
+	{
+		return AbilityTags;
+	}
+
 	/** Map of gameplay tags to gameplay effect containers */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = GameplayEffects)
 	TMap<FGameplayTag, FRPGGameplayEffectContainer> EffectContainerMap;
 
+	/**
+	 * If true, effect specs made from containers evaluate the source's AttackPower and Damage once and reuse them for every target they are applied to
+	 * Good for AoE abilities, but source modifiers that depend on target tags will only see the first target
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = GameplayEffects)
+	bool bSnapshotSourceAttributes;
+
 	/** Make gameplay effect container spec to be applied later, using the passed in container */
 	UFUNCTION(BlueprintCallable, Category = Ability, meta=(AutoCreateRefTerm = "EventData"))
 	virtual FRPGGameplayEffectContainerSpec MakeEffectContainerSpecFromContainer(const FRPGGameplayEffectContainer& Container, const FGameplayEventData& EventData, int32 OverrideGameplayLevel = -1);
@@ -59,3 +59,112 @@ public:
 	/** Uses the passed in event data */
 	virtual void GetTargets_Implementation(ARPGCharacterBase* TargetingCharacter, AActor* TargetingActor, FGameplayEventData EventData, TArray<FHitResult>& OutHitResults, TArray<AActor*>& OutActors) const override;
 };
+
+/**
+ * Base for native area target types, finds characters around the targeting actor using URPGCharacterGridSubsystem
+ * Blueprint a subclass to set the shape for an ability, no blueprint logic runs when targeting
+ */
+UCLASS(Abstract)
+class ACTIONRPG_API URPGTargetType_Area : public URPGTargetType
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGTargetType_Area();
+
+	/** Queries the grid around the targeting actor and adds every character that passes IsInShape and the filters */
+	virtual void GetTargets_Implementation(ARPGCharacterBase* TargetingCharacter, AActor* TargetingActor, FGameplayEventData EventData, TArray<FHitResult>& OutHitResults, TArray<AActor*>& OutActors) const override;
+
+protected:
+	/** Offset of the shape origin from the targeting actor, in the actor's local space */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting)
+	FVector OriginOffset;
+
+	/** Characters further than this above or below the origin are ignored */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting)
+	float MaxHeightDifference;
+
+	/** If true the targeting character can be one of the targets */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting)
+	bool bIncludeTargetingCharacter;
+
+	/** If true characters on the same team as the targeting character are ignored */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting)
+	bool bIgnoreSameTeam;
+
+	/** If true characters with no health left are ignored */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting)
+	bool bIgnoreDead;
+
+	/** Returns the distance from the origin the shape can reach in the 2D plane, used to pick grid cells */
+	virtual float GetQueryExtent() const PURE_VIRTUAL(URPGTargetType_Area::GetQueryExtent, return 0.f;);
+
+	/** Returns true if the location is inside the shape, Origin and Forward are in world space and Forward is flattened and normalized */
+	virtual bool IsInShape(const FVector& Origin, const FVector& Forward, const FVector& Location) const PURE_VIRTUAL(URPGTargetType_Area::IsInShape, return false;);
+};
+
+/** Targets every character within a radius in the ground plane, and within MaxHeightDifference above or below the origin. That is a vertical cylinder, not a sphere */
+UCLASS()
+class ACTIONRPG_API URPGTargetType_Cylinder : public URPGTargetType_Area
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGTargetType_Cylinder();
+
+protected:
+	/** Radius of the cylinder, measured in the ground plane */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting)
+	float Radius;
+
+	virtual float GetQueryExtent() const override;
+	virtual bool IsInShape(const FVector& Origin, const FVector& Forward, const FVector& Location) const override;
+};
+
+/** Targets characters within a radius that are inside a cone in front of the targeting actor */
+UCLASS()
+class ACTIONRPG_API URPGTargetType_Cone : public URPGTargetType_Area
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGTargetType_Cone();
+
+protected:
+	/** Length of the cone */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting)
+	float Radius;
+
+	/** Half of the cone's opening angle, in degrees */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting, meta = (ClampMin = "0.0", ClampMax = "180.0"))
+	float HalfAngle;
+
+	virtual float GetQueryExtent() const override;
+	virtual bool IsInShape(const FVector& Origin, const FVector& Forward, const FVector& Location) const override;
+};
+
+/** Targets characters near a line extending forward from the targeting actor, like a thrust or a beam */
+UCLASS()
+class ACTIONRPG_API URPGTargetType_Capsule : public URPGTargetType_Area
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGTargetType_Capsule();
+
+protected:
+	/** Length of the capsule's center line, starting at the origin */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting)
+	float Length;
+
+	/** Radius around the center line */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting)
+	float Radius;
+
+	virtual float GetQueryExtent() const override;
+	virtual bool IsInShape(const FVector& Origin, const FVector& Forward, const FVector& Location) const override;
+};
@@ -15,6 +15,23 @@
 class URPGGameplayAbility;
 class UGameplayEffect;
 
+/** Result of a cooldown query, reused until the active effects change */
+struct FRPGCooldownCacheEntry
+{
+	/** Tags that were queried, and their hash for a cheap compare */
+	FGameplayTagContainer CooldownTags;
+	uint32 TagsHash;
+
+	/** Active effect generation and world time when this was computed */
+	uint32 EffectsGeneration;
+	float QueryTime;
+
+	/** Results at QueryTime */
+	float TimeRemaining;
+	float CooldownDuration;
+	bool bFoundCooldown;
+};
+
 // 角色的游戏特定子类。对于ARPG，所有 蓝图角色（Blueprint Characters） 都继承此类，但是许多游戏需要具有多种角色类型的层级。
 
 /** Base class for Character, Designed to be blueprinted */
@@ -26,6 +43,8 @@ class ACTIONRPG_API ARPGCharacterBase : public ACharacter, public IAbilitySystem
 public:
 	// Constructor and overrides
 	ARPGCharacterBase();
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void PossessedBy(AController* NewController) override;
 	virtual void UnPossessed() override;
 	virtual void OnRep_Controller() override;
@@ -84,7 +103,11 @@ public:
 
 	/** Returns a list of active abilities matching the specified tags. This only returns if the ability is currently running */
 	UFUNCTION(BlueprintCallable, Category = "Abilities")
-	void GetActiveAbilitiesWithTags(FGameplayTagContainer AbilityTags, TArray<URPGGameplayAbility*>& ActiveAbilities);
+	void GetActiveAbilitiesWithTags(const FGameplayTagContainer& AbilityTags, TArray<URPGGameplayAbility*>& ActiveAbilities);
+
+	/** Returns true if an ability matching all of the tags is currently running. Cheap enough to poll every tick */
+	UFUNCTION(BlueprintCallable, Category = "Abilities")
+	bool HasActiveAbilityWithTags(const FGameplayTagContainer& AbilityTags) const;
 
 	/** Returns total time and remaining time for cooldown tags. Returns false if no active cooldowns found */
 	UFUNCTION(BlueprintCallable, Category = "Abilities")
@@ -131,6 +154,22 @@ protected:
 	FDelegateHandle InventoryUpdateHandle;
 	FDelegateHandle InventoryLoadedHandle;
 
+	/**
+	 * How long in seconds a cached cooldown query can be reused before the active effects are scanned again, even if no effect was added or removed
+	 * Remaining time is counted down from the cached value in between. 0 disables the cache
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Abilities)
+	float CooldownCacheMaxAge;
+
+	/** Cached results of GetCooldownRemainingForTag, one per distinct tag container asked for. Entries older than CooldownCacheMaxAge are dropped on the next lookup */
+	TArray<FRPGCooldownCacheEntry> CooldownCache;
+
+	/** Returns the hash used to find cooldown cache entries */
+	static uint32 GetCooldownTagsHash(const FGameplayTagContainer& CooldownTags);
+
+	/** Scans the active effects for the longest cooldown matching the tags */
+	bool QueryCooldownRemainingForTag(const FGameplayTagContainer& CooldownTags, float& TimeRemaining, float& CooldownDuration) const;
+
 	/**
 	 * Called when character takes damage, which may have killed them
 	 *
@@ -171,10 +210,18 @@ protected:
 	UFUNCTION(BlueprintImplementableEvent)
 	void OnMoveSpeedChanged(float DeltaValue, const struct FGameplayTagContainer& EventTags);
 
-	/** Called when slotted items change, bound to delegate on interface */
-	void OnItemSlotChanged(FRPGItemSlot ItemSlot, URPGItem* Item);
+	/** Called when the inventory changes, bound to delegate on interface. Only the slots in the change set are refreshed */
+	void OnInventoryChangeSet(const FRPGInventoryChangeSet& ChangeSet);
+
+	/** Diffs every slot against SlottedAbilities, only clearing or granting abilities whose slot contents changed */
 	void RefreshSlottedGameplayAbilities();
 
+	/** Same as above, but only looks at the passed in slots */
+	void RefreshSlottedGameplayAbilitiesForSlots(const TArray<FRPGItemSlot>& ItemSlots);
+
+	/** Brings the ability granted through a SlottedAbilities handle in line with the desired spec, null means the slot should grant nothing. Never adds to SlottedAbilities */
+	void ApplySlottedAbilitySpec(FGameplayAbilitySpecHandle& SpecHandle, const FGameplayAbilitySpec* DesiredSpec);
+
 	/** Apply the startup gameplay abilities and effects */
 	void AddStartupGameplayAbilities();
 
@@ -187,6 +234,9 @@ protected:
 	/** Fills in with ability specs, based on defaults and inventory */
 	void FillSlottedAbilitySpecs(TMap<FRPGItemSlot, FGameplayAbilitySpec>& SlottedAbilitySpecs);
 
+	/** Finds the ability spec a single slot should grant, returns false if it should not grant one */
+	bool FindSlottedAbilitySpec(const FRPGItemSlot& ItemSlot, FGameplayAbilitySpec& OutSpec);
+
 	/** Remove slotted gameplay abilities, if force is false it only removes invalid ones */
 	void RemoveSlottedGameplayAbilities(bool bRemoveAll);
 
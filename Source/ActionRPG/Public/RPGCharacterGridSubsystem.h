@@ -0,0 +1,78 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ActionRPG.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "RPGCharacterGridSubsystem.generated.h"
+
+class ARPGCharacterBase;
+
+/**
+ * Uniform 2D grid of character positions for each world, used by native area target types
+ * Characters register themselves on BeginPlay, the grid moves them between cells in Tick when they cross a cell boundary
+ * Queries are conservative: they return every character whose cell overlaps the query bounds, including ones outside the bounds,
+ * and the caller's shape test against the current location is what makes the result exact. Cells are only updated in Tick, so a
+ * character that crossed into the bounds from a cell outside them since the last tick is not found until the next one
+ * Characters are held by weak pointer, one destroyed without unregistering is skipped by queries and dropped on the next tick
+ */
+UCLASS()
+class ACTIONRPG_API URPGCharacterGridSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Size of a grid cell in world units, roughly the radius of a typical area ability */
+	static constexpr float CellSize = 500.f;
+
+	// Overrides
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Adds or removes a character from the grid */
+	void RegisterCharacter(ARPGCharacterBase* Character);
+	void UnregisterCharacter(ARPGCharacterBase* Character);
+
+	/** Calls Callback for every registered character whose cell overlaps the 2D bounds, a superset of the characters inside them. The callback does the shape test */
+	template<typename CallbackType>
+	void ForEachCharacterInBounds(const FVector2D& Min, const FVector2D& Max, CallbackType&& Callback) const
+	{
+		const FIntPoint MinCell = GetCell(Min);
+		const FIntPoint MaxCell = GetCell(Max);
+
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+		{
+			for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++)
+			{
+				const TArray<TWeakObjectPtr<ARPGCharacterBase>>* CellCharacters = Cells.Find(FIntPoint(CellX, CellY));
+				if (CellCharacters)
+				{
+					for (const TWeakObjectPtr<ARPGCharacterBase>& WeakCharacter : *CellCharacters)
+					{
+						if (ARPGCharacterBase* Character = WeakCharacter.Get())
+						{
+							Callback(Character);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/** Returns the cell a location falls in */
+	static FIntPoint GetCell(const FVector2D& Location)
+	{
+		return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+	}
+
+protected:
+	/** Cell each registered character was last placed in */
+	TMap<TWeakObjectPtr<ARPGCharacterBase>, FIntPoint> CharacterCells;
+
+	/** Characters in each occupied cell */
+	TMap<FIntPoint, TArray<TWeakObjectPtr<ARPGCharacterBase>>> Cells;
+
+	/** Moves a character between cells */
+	void RemoveFromCell(const TWeakObjectPtr<ARPGCharacterBase>& Character, const FIntPoint& Cell);
+	void AddToCell(const TWeakObjectPtr<ARPGCharacterBase>& Character, const FIntPoint& Cell);
+};
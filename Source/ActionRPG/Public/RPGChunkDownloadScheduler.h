@@ -0,0 +1,143 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ActionRPG.h"
+
+/**
+ * Feeds chunks to FChunkDownloader in priority order and mounts each one as soon as it has downloaded
+ * Only a limited number of chunks are handed to the downloader at a time so high priority chunks are not starved of bandwidth by
+ * everything else in the list. That limit adapts to the measured throughput: it grows while more parallel downloads keep making
+ * things faster, and shrinks when throughput drops or the link is slow enough that parallel downloads only delay the first chunk
+ * It also tracks the state and timings of every chunk, for progress UI and for comparing patch performance between builds
+ */
+class ACTIONRPG_API FRPGChunkDownloadScheduler : public TSharedFromThis<FRPGChunkDownloadScheduler>
+{
+public:
+	DECLARE_DELEGATE_TwoParams(FOnChunkMounted, int32 /*ChunkId*/, bool /*bSuccess*/);
+	DECLARE_DELEGATE_OneParam(FOnAllChunksMounted, bool /*bSuccess*/);
+
+	FRPGChunkDownloadScheduler(int32 InMinDownloadsInFlight, int32 InMaxDownloadsInFlight);
+
+	/** Adds a chunk to the queue, higher priorities download first and equal priorities keep queue order. Re-queuing a waiting chunk updates its priority */
+	void QueueChunk(int32 ChunkId, int32 Priority);
+
+	/** Starts handing chunks to the downloader, FChunkDownloader must already be initialized */
+	void Start();
+
+	/** Stops issuing new downloads, chunks already handed to the downloader still finish but are not reported */
+	void Cancel();
+
+	/** Returns true between Start and the last chunk mounting */
+	bool IsRunning() const
+	{
+		return bRunning;
+	}
+
+	/** Returns how many chunks the scheduler currently allows in flight */
+	int32 GetDownloadsInFlightTarget() const
+	{
+		return DownloadsInFlightTarget;
+	}
+
+	/** Fills in overall and per chunk progress, sampling throughput if it has not been sampled recently */
+	void GetProgress(FRPGPatchProgress& OutProgress);
+
+	/** Download rate averaged over the throughput window */
+	double GetBytesPerSecond() const;
+
+	/** Appends one row per chunk plus a summary row to a CSV file, writing the header if the file is new. Returns false if the write failed */
+	bool WriteTimingsCsv(const FString& Filename) const;
+
+	/** Called as each chunk finishes mounting */
+	FOnChunkMounted OnChunkMounted;
+
+	/** Called once every queued chunk has mounted or failed */
+	FOnAllChunksMounted OnAllChunksMounted;
+
+	/** Throughput below this, in bytes per second, counts as a slow link and drops to the minimum number of downloads in flight */
+	static constexpr double SlowLinkBytesPerSecond = 256.0 * 1024.0;
+
+	/** Seconds between adjustments of the in flight target */
+	static constexpr double AdaptInterval = 2.0;
+
+	/** Seconds of samples the throughput is averaged over, long enough to smooth over chunk boundaries */
+	static constexpr double ThroughputWindow = 5.0;
+
+	/** Minimum seconds between throughput samples */
+	static constexpr double SampleInterval = 0.25;
+
+private:
+	struct FQueuedChunk
+	{
+		int32 ChunkId;
+		int32 Priority;
+		int32 QueueOrder;
+	};
+
+	/** State and timings of a chunk, times are FPlatformTime::Seconds and 0 until reached */
+	struct FChunkRecord
+	{
+		int32 ChunkId;
+		int32 Priority;
+		ERPGChunkPatchState State;
+		double DownloadStartTime;
+		double DownloadEndTime;
+		double MountEndTime;
+	};
+
+	struct FThroughputSample
+	{
+		double Time;
+		int64 Bytes;
+	};
+
+	/** Returns the record for a chunk, adding it if this is the first time it is seen */
+	FChunkRecord& FindOrAddRecord(int32 ChunkId);
+
+	/** Adds a sample of the downloaded byte count and drops samples that fell out of the window */
+	void SampleThroughput();
+
+	/** Hands chunks to the downloader until the in flight target is reached */
+	void IssueDownloads();
+
+	/** Callbacks from FChunkDownloader */
+	void HandleChunkDownloaded(int32 ChunkId, bool bSuccess);
+	void HandleChunkMounted(int32 ChunkId, bool bSuccess);
+
+	/** Samples throughput and moves the in flight target */
+	void UpdateDownloadsInFlightTarget();
+
+	/** Broadcasts completion if nothing is left to do */
+	void CheckFinished();
+
+	/** Chunks waiting to be handed to the downloader, sorted so the next one is at the end */
+	TArray<FQueuedChunk> QueuedChunks;
+
+	/** Chunks handed to the downloader that have not finished downloading */
+	TSet<int32> DownloadingChunks;
+
+	/** Chunks that finished downloading and are mounting */
+	TSet<int32> MountingChunks;
+
+	int32 MinDownloadsInFlight;
+	int32 MaxDownloadsInFlight;
+	int32 DownloadsInFlightTarget;
+	int32 NextQueueOrder;
+	bool bRunning;
+	bool bAnyFailed;
+
+	/** Every chunk queued since construction, in queue order */
+	TArray<FChunkRecord> ChunkRecords;
+
+	/** Samples within the throughput window, oldest first */
+	TArray<FThroughputSample> ThroughputSamples;
+
+	/** Time Start was called and the time the last chunk finished, 0 until then */
+	double StartTime;
+	double FinishTime;
+
+	/** Time and result of the last in flight target adjustment */
+	double LastAdaptTime;
+	double LastThroughput;
+};
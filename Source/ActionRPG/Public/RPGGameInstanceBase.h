@@ -4,14 +4,32 @@
 
 #include "ActionRPG.h"
 #include "Engine/GameInstance.h"
+#include "RPGSaveGame.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "UObject/StrongObjectPtr.h"
 #include "RPGGameInstanceBase.generated.h"
 
 class URPGItem;
 class URPGSaveGame;
+class FRPGChunkDownloadScheduler;
 
 // 动态组播委托：该委托输出一个布尔值，该布尔值将告知你补丁下载操作是否成功。委托通常用于响应异步操作，例如下载或安装文件。
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FPatchCompleteDelegate, bool, Succeeded);
 
+/** Delegate called as each patch chunk is mounted, content in that chunk can be used from this point */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FChunkMountedDelegate, int32, ChunkId, bool, Succeeded);
+
+/** Delegate called when an asynchronous load or create of the save game finishes, bLoaded is true if the current save game came from the slot and false if it was newly created */
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnSaveGameLoadComplete, bool, bLoaded);
+DECLARE_DELEGATE_OneParam(FOnSaveGameLoadCompleteNative, bool);
+
+/** Delegate called when a queued save game write finishes, or is superseded by a newer write of the same slot that finished */
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnSaveGameWritten, bool, bSuccess);
+DECLARE_DELEGATE_OneParam(FOnSaveGameWrittenNative, bool);
+
+/** Delegate called whenever a save slot has been written */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnSaveSlotWritten, const FString&, SlotName, int32, UserIndex, bool, bSuccess);
+
 // 它是 GameInstance 的游戏特定子类，是大多数游戏所必需的。由于在整个游戏中只声明一个游戏实例，它很适合存储全局Gameplay数据。
 /**
  * Base class for GameInstance, should be blueprinted
@@ -36,11 +54,19 @@ public:
 	UFUNCTION(BlueprintPure, Category="Patching|Stats")
 	void GetLoadingProgress(int32& BytesDownloaded, int32& TotalBytesToDownload, float& DownloadPercent, int32& ChunksMounted, int32& TotalChunksToMount, float& MountPercent) const;
 
+	/** Returns overall and per chunk progress of the current or last patch, including download rate and estimated time remaining */
+	UFUNCTION(BlueprintPure, Category="Patching|Stats")
+	FRPGPatchProgress GetPatchProgress() const;
+
 	// 启动游戏补丁过程。如果补丁清单不是最新的，则返回false
 	// 此函数提供了蓝图的一种公开的补丁过程启动方式。它返回布尔值指示成功还是失败。这是下载管理和其他类型异步任务中的通用模式。
 	UFUNCTION(BlueprintCallable, Category = "Patching")
 	bool PatchGame();
 
+	/** Sets the download priority of a chunk, higher downloads first. Use this to move the chunks needed by the next level ahead of cosmetic ones, works while patching */
+	UFUNCTION(BlueprintCallable, Category = "Patching")
+	void SetChunkDownloadPriority(int32 ChunkId, int32 Priority);
+
 	/**
 	 * Adds the default inventory to the inventory array
 	 * @param InventoryArray Inventory to modify
@@ -65,6 +91,24 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Save)
 	bool LoadOrCreateSaveGame();
 
+	/**
+	 * Loads the save game on a background thread, creating a new one if there is none. OnSaveGameLoaded is broadcast before OnComplete is called
+	 * Calling this while a load is in progress only adds the callback. A synchronous load or reset while this is in progress wins over its result
+	 */
+	UFUNCTION(BlueprintCallable, Category = Save)
+	void LoadOrCreateSaveGameAsync(FOnSaveGameLoadComplete OnComplete);
+
+	/** Native version of LoadOrCreateSaveGameAsync */
+	void LoadOrCreateSaveGameAsyncNative(FOnSaveGameLoadCompleteNative OnComplete);
+
+	/** Returns true if the last loaded save game was corrupt. Saving and journaling are then off so the slot is left as it was, until ResetSaveGame or a good load */
+	UFUNCTION(BlueprintPure, Category = Save)
+	bool IsSaveSlotCorrupt() const;
+
+	/** Returns true while an asynchronous save game load is in progress, GetCurrentSaveGame is not up to date until it finishes */
+	UFUNCTION(BlueprintPure, Category = Save)
+	bool IsSaveGameLoadInProgress() const;
+
 	/** Handle the final setup required after loading a USaveGame object using AsyncLoadGameFromSlot. Returns true if it loaded, false if it created one */
 	UFUNCTION(BlueprintCallable, Category = Save)
 	bool HandleSaveGameLoaded(USaveGame* SaveGameObject);
@@ -77,10 +121,36 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Save)
 	bool WriteSaveGame();
 
+	/**
+	 * Queues SaveGame to be written to the slot, it is serialized on the game thread when its write starts and written on a background thread
+	 * Each slot has at most one write in flight. Writes queued while one is in flight collapse into the newest, which is the only one serialized, and their callbacks are called when it finishes
+	 * Different slots are written independently
+	 */
+	UFUNCTION(BlueprintCallable, Category = Save)
+	bool WriteSaveGameToSlot(USaveGame* SaveGame, const FString& SlotName, int32 UserIndex, FOnSaveGameWritten OnComplete);
+
+	/** Native version of WriteSaveGameToSlot */
+	bool QueueSaveGameWrite(USaveGame* SaveGame, const FString& SlotName, int32 UserIndex, FOnSaveGameWrittenNative OnComplete);
+
+	/** Returns true if a write to the slot is in flight or queued */
+	UFUNCTION(BlueprintPure, Category = Save)
+	bool IsSaveSlotWriteInProgress(const FString& SlotName, int32 UserIndex) const;
+
 	/** Resets the current save game to it's default. This will erase player data! This won't save to disk until the next WriteSaveGame */
 	UFUNCTION(BlueprintCallable, Category = Save)
 	void ResetSaveGame();
 
+	/**
+	 * Applies inventory changes to the current save game and appends them to the inventory journal on disk, instead of rewriting the whole save
+	 * Sequence numbers are assigned to the entries. Returns false if journaling is disabled, in which case the caller should do a full save
+	 * The append happens on a background thread, if it fails a full save is written instead
+	 */
+	bool AppendInventoryJournal(TArray<FRPGInventoryJournalEntry>& Entries);
+
+	/** Writes a full snapshot of the current save game, after which the inventory journal is discarded. Also called if appending to the journal fails */
+	UFUNCTION(BlueprintCallable, Category = Save)
+	bool CompactInventoryJournal();
+
 public:
 
 	// 委托
@@ -88,6 +158,10 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Patching")
 	FPatchCompleteDelegate OnPatchComplete;
 
+	/** Called as each chunk in ChunkDownloadList mounts, before OnPatchComplete */
+	UPROPERTY(BlueprintAssignable, Category = "Patching")
+	FChunkMountedDelegate OnChunkMounted;
+
 	/** List of inventory items to add to new players */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Inventory)
 	TMap<FPrimaryAssetId, FRPGItemData> DefaultInventory;
@@ -104,6 +178,29 @@ public:
 	UPROPERTY(BlueprintReadWrite, Category = Save)
 	int32 SaveUserIndex;
 
+	/** If true, inventory changes are appended to a journal file next to the save game rather than rewriting the whole save */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Save)
+	bool bUseInventoryJournal;
+
+	/** Compression applied to the inventory block of the save game, loading handles every method regardless of this setting */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Save)
+	ERPGSaveGameCompression SaveGameCompression;
+
+	/**
+	 * If true, Init starts loading the save game asynchronously before the blueprint Init event runs, so startup does not block on it
+	 * Off by default because BP_GameInstance still loads the slot from its own Init event, turn it on once that load is removed or the slot is read twice
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Save)
+	bool bLoadSaveGameAsyncOnInit;
+
+	/** Number of journal entries after which the journal is compacted into a full save */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Save)
+	int32 MaxInventoryJournalEntries;
+
+	/** Seconds an entry can sit in the journal before the journal is compacted into a full save */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Save)
+	float InventoryJournalCompactInterval;
+
 	/** Delegate called when the save game has been loaded/reset */
 	UPROPERTY(BlueprintAssignable, Category = Inventory)
 	FOnSaveGameLoaded OnSaveGameLoaded;
@@ -111,6 +208,10 @@ public:
 	/** Native delegate for save game load/reset */
 	FOnSaveGameLoadedNative OnSaveGameLoadedNative;
 
+	/** Called after every queued write to a save slot, including the writes done by WriteSaveGame */
+	UPROPERTY(BlueprintAssignable, Category = Save)
+	FOnSaveSlotWritten OnSaveSlotWritten;
+
 protected:
 
 	// 要尝试和下载的文件块ID列表
@@ -118,6 +219,28 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category="Patching")
 	TArray<int32> ChunkDownloadList;
 
+	/** Download priority for chunks in ChunkDownloadList, higher downloads first. Chunks not listed use 0 and keep their list order */
+	UPROPERTY(EditDefaultsOnly, Category="Patching")
+	TMap<int32, int32> ChunkDownloadPriorities;
+
+	/** Platform folder on the CDN, if empty the ini platform name of the running platform is used */
+	UPROPERTY(EditDefaultsOnly, Category="Patching")
+	FString ChunkDownloadPlatformName;
+
+	/** Bounds for the number of downloads in flight, the scheduler adapts between them based on measured throughput */
+	UPROPERTY(EditDefaultsOnly, Category="Patching")
+	int32 MinChunkDownloadsInFlight;
+
+	UPROPERTY(EditDefaultsOnly, Category="Patching")
+	int32 MaxChunkDownloadsInFlight;
+
+	/** If true, per chunk timings are appended to Saved/Patching/PatchTimings.csv when patching completes, to compare patch performance between builds. Also enabled by -RecordPatchTimings */
+	UPROPERTY(EditDefaultsOnly, Category="Patching")
+	bool bRecordPatchTimings;
+
+	/** Orders downloads and mounts chunks as they land, valid while patching */
+	TSharedPtr<FRPGChunkDownloadScheduler> ChunkScheduler;
+
 	/** The current save game object */
 	UPROPERTY()
 	URPGSaveGame* CurrentSaveGame;
@@ -126,31 +249,105 @@ protected:
 	UPROPERTY()
 	bool bSavingEnabled;
 
-	/** True if we are in the middle of doing a save */
-	UPROPERTY()
-	bool bCurrentlySaving;
-
-	/** True if another save was requested during a save */
-	UPROPERTY()
-	bool bPendingSaveRequested;
-
 	/** 用我们网站上托管的清单文件追踪本地清单文件是否为最新文件。*/
 	bool bIsDownloadManifestUpToDate;
 
+	/** Number of journal entries written since the last snapshot was started */
+	int32 InventoryJournalEntriesSinceSnapshot;
+
+	/** Time the oldest entry not yet part of a snapshot was written */
+	double InventoryJournalOldestEntryTime;
+
+	/** Last queued inventory journal file operation, appends and deletes run one after another in the order they were queued */
+	FGraphEventRef InventoryJournalWrite;
+
+	/** Write queue state of a single save slot */
+	struct FSaveSlotWriteState
+	{
+		/** Save waiting for the write in flight to finish, a newer save replaces it. Not serialized until its own write starts */
+		TStrongObjectPtr<USaveGame> PendingSaveGame;
+
+		/** Callbacks for the pending save and the write in flight */
+		TArray<FOnSaveGameWrittenNative> PendingCallbacks;
+		TArray<FOnSaveGameWrittenNative> InFlightCallbacks;
+
+		/** Background task writing to the slot, null if nothing is in flight */
+		FGraphEventRef InFlightWrite;
+
+		/** Set by the write in flight before it completes, also identifies that write to its game thread notification */
+		TSharedPtr<bool, ESPMode::ThreadSafe> InFlightWriteResult;
+	};
+
+	/** Queued and in flight writes, keyed by slot name and user index. Slots are removed once they have nothing left to write */
+	TMap<TPair<FString, int32>, FSaveSlotWriteState> SaveSlotWrites;
+
+	/** True while an asynchronous save game load is in progress */
+	bool bSaveGameLoadInProgress;
+
+	/** Incremented every time the current save game is replaced, so a stale asynchronous load can be discarded */
+	int32 SaveGameLoadSerial;
+
+	/** Time the current asynchronous load was started */
+	double SaveGameLoadStartTime;
+
+	/** True if the current save game was loaded from the slot, false if it was newly created */
+	bool bCurrentSaveGameLoaded;
+
+	/** True if the save slot held a corrupt save game, writes to the slot and its journal are refused */
+	bool bSaveSlotCorrupt;
+
+	/** Callbacks waiting for the current asynchronous load */
+	TArray<FOnSaveGameLoadCompleteNative> PendingSaveGameLoadCallbacks;
+
 
 protected:
-	/** Called when the async save happens */
-	virtual void HandleAsyncSave(const FString& SlotName, const int32 UserIndex, bool bSuccess);
+	/** Called when the save written by WriteSaveGame happens */
+	virtual void HandleAsyncSave(bool bSuccess, int64 SnapshotJournalSequence);
+
+	/** Serializes the pending save of a slot and starts writing it on a background thread */
+	void StartSaveSlotWrite(const TPair<FString, int32>& SlotKey);
+
+	/** Called on the game thread when a background slot write finishes, does nothing if that write was already handled */
+	void HandleSaveSlotWritten(TPair<FString, int32> SlotKey, TSharedPtr<bool, ESPMode::ThreadSafe> WriteResult);
+
+	/** Writes everything queued and waits for it, calling the callbacks as the writes finish, so nothing queued is lost on shutdown */
+	void FlushSaveGameWrites();
+
+	/** Called when the async load started by LoadOrCreateSaveGameAsyncNative finishes */
+	virtual void HandleAsyncSaveGameLoaded(const FString& SlotName, const int32 UserIndex, USaveGame* SaveGameObject, int32 LoadSerial);
+
+	/** Calls and clears the pending load callbacks */
+	void CompleteSaveGameLoad(bool bLoaded);
+
+	/** Returns the path of the inventory journal for the current save slot */
+	FString GetInventoryJournalPath() const;
+
+	/** Applies any journal entries newer than the save game's snapshot, returns number of entries replayed */
+	int32 ReplayInventoryJournal(URPGSaveGame* SaveGame);
+
+	/** Deletes the inventory journal for the current save slot, after any appends that are already queued */
+	void DeleteInventoryJournal();
+
+	/** Runs a journal file operation on a background thread once the previously queued one has finished */
+	void QueueInventoryJournalWrite(TUniqueFunction<void()> Write);
+
+	/** Waits for queued journal file operations, so the journal on disk is up to date */
+	void WaitForInventoryJournalWrites();
+
+	/** Called on the game thread when a background append to the journal failed */
+	void HandleInventoryJournalAppendFailed(FString JournalPath);
 
 	/** 在文件块下载进程完成时调用 */
 	void OnManifestUpdateComplete(bool bSuccess);
 
-	// 在文件块下载进程完成时调用
-	void OnDownloadComplete(bool bSuccess);
+	// 单个文件块挂载完成时调用
+	void HandleChunkMounted(int32 ChunkId, bool bSuccess);
 
 	// ChunkDownloader加载模式完成时调用
 	void OnLoadingModeComplete(bool bSuccess);
 
 	// ChunkDownloader完成挂载文件块时调用
 	void OnMountComplete(bool bSuccess);
+
+	friend class FRPGSaveGameTest_WriteQueue;
 };
\ No newline at end of file
@@ -37,5 +37,8 @@ public:
 
 	/** Gets the delegate for when the inventory loads */
 	virtual FOnInventoryLoadedNative& GetInventoryLoadedDelegate() = 0;
+
+	/** Gets the delegate for aggregated inventory changes, this is called once per change set instead of once per item or slot */
+	virtual FOnInventoryChangeSetNative& GetInventoryChangeSetDelegate() = 0;
 };
 
@@ -5,8 +5,11 @@
 #include "ActionRPG.h"
 #include "GameFramework/PlayerController.h"
 #include "RPGInventoryInterface.h"
+#include "Engine/StreamableManager.h"
 #include "RPGPlayerControllerBase.generated.h"
 
+class URPGGameInstanceBase;
+
 // 它是大多数游戏所需的 PlayerController 的游戏特定子类。对于ARPG，这里主要处理物品栏。
 
 /** Base class for PlayerController, should be blueprinted */
@@ -17,19 +20,21 @@ class ACTIONRPG_API ARPGPlayerControllerBase : public APlayerController, public
 
 public:
 	// Constructor and overrides
-	ARPGPlayerControllerBase() {}
+	ARPGPlayerControllerBase()
+		: bBatchInventoryNotifications(false)
+		, bAsyncInventoryLoad(true)
+		, InventoryLoadTimeout(10.f)
+		, InventoryLoadSerial(0)
+		, bInventoryLoading(false)
+	{}
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	// 第一个贴图是从 URPGItem* 到 FRPGItemData，存储数量和关卡。 
 	/** Map of all items owned by this player, from definition to data */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Inventory)
 	TMap<URPGItem*, FRPGItemData> InventoryData;
 
-	// 第二个贴图是从 FRPGItemSlot 到 URPGItem*，描述某些项目存储在"武器插槽1"中。
-	/** Map of slot, from type/num to item, initialized from ItemSlotsPerType on RPGGameInstanceBase */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Inventory)
-	TMap<FRPGItemSlot, URPGItem*> SlottedItems;
-
 	/** Delegate called when an inventory item has been added or removed */
 	UPROPERTY(BlueprintAssignable, Category = Inventory)
 	FOnInventoryItemChanged OnInventoryItemChanged;
@@ -59,11 +64,36 @@ public:
 	/** Native version above, called before BP delegate */
 	FOnInventoryLoadedNative OnInventoryLoadedNative;
 
-	/** Adds a new inventory item, will add it to an empty slot if possible. If the item supports count you can add more than one count. It will also update the level when adding if required */
+	/** Delegate called with the aggregated changes, once per frame if bBatchInventoryNotifications is set. Bind to this to rebuild UI once for bulk changes */
+	UPROPERTY(BlueprintAssignable, Category = Inventory)
+	FOnInventoryChangeSet OnInventoryChangeSet;
+
+	/** Native version above, called before BP delegate */
+	FOnInventoryChangeSetNative OnInventoryChangeSetNative;
+
+	/** Called after a change set was dispatched and we notified all delegates */
+	UFUNCTION(BlueprintImplementableEvent, Category = Inventory)
+	void InventoryChangeSetDispatched(const FRPGInventoryChangeSet& ChangeSet);
+
+	/**
+	 * If true, item and slot change notifications are gathered during the frame and dispatched once after actors tick
+	 * Per item and per slot delegates still fire, but only once for each distinct item or slot, followed by a single change set
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Inventory)
+	bool bBatchInventoryNotifications;
+
+	/** Immediately dispatches any batched inventory notifications */
+	UFUNCTION(BlueprintCallable, Category = Inventory)
+	void FlushInventoryNotifications();
+
+	/**
+	 * Adds a new inventory item, will add it to an empty slot if possible. If the item supports count you can add more than one count. It will also update the level when adding if required
+	 * While the inventory is loading the add is queued and true is returned, if it fails once applied the item changed delegates are called with the item as not added
+	 */
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	bool AddInventoryItem(URPGItem* NewItem, int32 ItemCount = 1, int32 ItemLevel = 1, bool bAutoSlot = true);
 
-	/** Remove an inventory item, will also remove from slots. A remove count of <= 0 means to remove all copies */
+	/** Remove an inventory item, will also remove from slots. A remove count of <= 0 means to remove all copies. Queued while the inventory is loading, like AddInventoryItem */
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	bool RemoveInventoryItem(URPGItem* RemovedItem, int32 RemoveCount = 1);
 
@@ -79,7 +109,7 @@ public:
 	UFUNCTION(BlueprintPure, Category = Inventory)
 	bool GetInventoryItemData(URPGItem* Item, FRPGItemData& ItemData) const;
 
-	/** Sets slot to item, will remove from other slots if necessary. If passing null this will empty the slot */
+	/** Sets slot to item, will remove from other slots if necessary. If passing null this will empty the slot. Queued while the inventory is loading, like AddInventoryItem */
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	bool SetSlottedItem(FRPGItemSlot ItemSlot, URPGItem* Item);
 
@@ -91,6 +121,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	void GetSlottedItems(TArray<URPGItem*>& Items, FPrimaryAssetType ItemType, bool bOutputEmptyIndexes);
 
+	/** Returns every slot the item is currently in */
+	UFUNCTION(BlueprintCallable, Category = Inventory)
+	void GetSlotsForItem(URPGItem* Item, TArray<FRPGItemSlot>& ItemSlots) const;
+
 	/** Fills in any empty slots with items in inventory */
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	void FillEmptySlots();
@@ -99,10 +133,25 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	bool SaveInventory();
 
-	/** Loads inventory from save game on game instance, this will replace arrays */
+	/** Loads inventory from save game on game instance, this will replace arrays. With async loading OnInventoryLoaded fires once the items have streamed in */
 	UFUNCTION(BlueprintCallable, Category = Inventory)
 	bool LoadInventory();
 
+	/**
+	 * Returns true while LoadInventory is waiting for items to stream in. Inventory changes made meanwhile are queued and applied once it has been restored
+	 * A queued change that fails then is reported through OnInventoryItemChanged or OnSlottedItemChanged with the actual state of the item or slot
+	 */
+	UFUNCTION(BlueprintPure, Category = Inventory)
+	bool IsInventoryLoading() const;
+
+	/** If true, LoadInventory streams all saved items in one batched async request instead of loading each one synchronously */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Inventory)
+	bool bAsyncInventoryLoad;
+
+	/** Seconds to wait for the async item load before restoring with synchronous loads for anything that is still missing. <= 0 waits forever */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Inventory)
+	float InventoryLoadTimeout;
+
 	// Implement IRPGInventoryInterface
 	virtual const TMap<URPGItem*, FRPGItemData>& GetInventoryDataMap() const override
 	{
@@ -124,16 +173,135 @@ public:
 	{
 		return OnInventoryLoadedNative;
 	}
+	virtual FOnInventoryChangeSetNative& GetInventoryChangeSetDelegate() override
+	{
+		return OnInventoryChangeSetNative;
+	}
 
 protected:
+	// 第二个贴图是从 FRPGItemSlot 到 URPGItem*，描述某些项目存储在"武器插槽1"中。
+	/**
+	 * Map of slot, from type/num to item, initialized from ItemSlotsPerType on RPGGameInstanceBase
+	 * Read only outside this class, SlottedItemsByType and SlotsByItem are kept in sync by SetSlotContents. Use SetSlottedItem to change a slot
+	 */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Inventory)
+	TMap<FRPGItemSlot, URPGItem*> SlottedItems;
+
+	/** Inventory changes that have not been written to the save game yet */
+	TArray<FRPGInventoryJournalEntry> PendingJournalEntries;
+
+	/** Secondary index of SlottedItems, per type array of items indexed by slot number */
+	TMap<FPrimaryAssetType, TArray<URPGItem*>> SlottedItemsByType;
+
+	/** Reverse index of SlottedItems, from item to every slot holding it */
+	TMultiMap<URPGItem*, FRPGItemSlot> SlotsByItem;
+
+	/** Handle for the batched async item load started by LoadInventory */
+	TSharedPtr<FStreamableHandle> InventoryLoadHandle;
+
+	/** Timer that falls back to synchronous loading if the async load takes too long */
+	FTimerHandle InventoryLoadTimeoutHandle;
+
+	/** Incremented for every async load, so callbacks from cancelled loads are ignored */
+	int32 InventoryLoadSerial;
+
+	/** True while waiting on InventoryLoadHandle */
+	bool bInventoryLoading;
+
+	/** An add, remove or slot change requested while the inventory was loading */
+	struct FPendingInventoryChange
+	{
+		enum class EOp : uint8
+		{
+			Add,
+			Remove,
+			SetSlot,
+		};
+
+		EOp Op = EOp::Add;
+		TWeakObjectPtr<URPGItem> Item;
+		FRPGItemSlot ItemSlot;
+		int32 ItemCount = 0;
+		int32 ItemLevel = 0;
+		bool bAutoSlot = false;
+	};
+
+	/** Changes waiting for the restore, InventoryData is empty until then so applying them early would overwrite the saved counts */
+	TArray<FPendingInventoryChange> PendingInventoryChanges;
+
+	/** Applies the changes queued while the inventory was loading, in the order they were requested */
+	void ApplyPendingInventoryChanges();
+
+	/** Notifies the item or slot of a queued change that could not be applied, so listeners that took the deferred result as success see the actual state */
+	void NotifyPendingInventoryChangeFailed(const FPendingInventoryChange& Change, URPGItem* Item);
+
+	/** Adds an empty slot for every slot configured on the game instance */
+	void InitializeEmptySlots(URPGGameInstanceBase* GameInstance);
+
+	/** Removes all slots and clears the slot indices */
+	void ResetSlots();
+
+	/** Changes the item in an existing slot, keeping the slot indices in sync. All slot writes must go through this */
+	void SetSlotContents(const FRPGItemSlot& ItemSlot, URPGItem* Item);
+
+	/** Starts streaming every item referenced by the save game. Returns false if nothing needs to be loaded */
+	bool StartAsyncInventoryLoad(URPGSaveGame* SaveGame);
+
+	/** Cancels an in progress async load and its timeout */
+	void CancelAsyncInventoryLoad();
+
+	/** Called when the batched item load completes or times out */
+	void HandleInventoryItemsLoaded(int32 LoadSerial);
+	void HandleInventoryLoadTimeout(int32 LoadSerial);
+
+	/** Copies the current save game into the inventory maps and notifies that the inventory was loaded */
+	void RestoreInventoryFromSaveGame();
+
+	/** Returns an item that is already in memory, or synchronously loads it */
+	URPGItem* FindOrLoadItem(const FPrimaryAssetId& ItemId) const;
+
 	/** Auto slots a specific item, returns true if anything changed */
 	bool FillEmptySlotWithItem(URPGItem* NewItem);
 
-	/** Calls the inventory update callbacks */
+	/** Queues a journal entry for the current inventory data of an item */
+	void JournalItemChanged(URPGItem* Item, bool bWasInInventory);
+
+	/** Queues a journal entry for the current contents of a slot */
+	void JournalSlotChanged(FRPGItemSlot ItemSlot, URPGItem* Item);
+
+	/** Writes queued journal entries to the save game, falling back to a full SaveInventory if journaling is unavailable */
+	bool SaveInventoryChanges();
+
+	/** Changes waiting for the end of frame flush when notifications are batched, sets so bulk changes stay linear. The change set arrays are built once at flush */
+	TSet<URPGItem*> PendingAddedItems;
+	TSet<URPGItem*> PendingRemovedItems;
+	TSet<FRPGItemSlot> PendingChangedSlots;
+
+	/** Returns true if any batched change is waiting for the flush */
+	bool HasPendingChanges() const;
+
+	/** Clears the batched changes, keeping allocations for the next frame */
+	void ResetPendingChanges();
+
+	/** Handle for the end of frame flush, valid while changes are pending */
+	FDelegateHandle PendingChangeSetFlushHandle;
+
+	/** Calls the inventory update callbacks, or queues them if notifications are batched */
 	void NotifyInventoryItemChanged(bool bAdded, URPGItem* Item);
 	void NotifySlottedItemChanged(FRPGItemSlot ItemSlot, URPGItem* Item);
 	void NotifyInventoryLoaded();
 
+	/** Broadcasts the per item, per slot and change set delegates */
+	void BroadcastInventoryItemChanged(bool bAdded, URPGItem* Item);
+	void BroadcastSlottedItemChanged(FRPGItemSlot ItemSlot, URPGItem* Item);
+	void BroadcastInventoryChangeSet(const FRPGInventoryChangeSet& ChangeSet);
+
+	/** Called after the world has ticked actors, flushes batched notifications */
+	void HandleWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
 	/** Called when a global save game as been loaded */
 	void HandleSaveGameLoaded(URPGSaveGame* NewSaveGame);
+
+	friend class FRPGInventoryTest_ChangeDuringLoad;
+	friend class FRPGInventoryTest_FailedChangeDuringLoad;
 };
@@ -20,6 +20,10 @@ namespace ERPGSaveGameVersion
 		AddedInventory,
 		// Added ItemData to store count/level
 		AddedItemData,
+		// Added JournalSequence so inventory journal entries can be replayed on top of the snapshot
+		AddedInventoryJournal,
+		// Inventory and slots are written as a compact binary block after the tagged properties, optionally compressed
+		CompactInventory,
 
 		// -----<new versions must be added before this line>-------------------------------------------------
 		VersionPlusOne,
@@ -27,6 +31,40 @@ namespace ERPGSaveGameVersion
 	};
 }
 
+/**
+ * Custom version written in the save game header. SavedDataVersion is a tagged property, so saves from before this was added
+ * left it out whenever it matched the class default of the time and it can't be used to tell their layout apart
+ */
+struct ACTIONRPG_API FRPGSaveGameCustomVersion
+{
+	enum Type
+	{
+		// Before any version changes were made
+		BeforeCustomVersionWasAdded = 0,
+		// SavedDataVersion read from the save is what it was written with
+		SavedDataVersionIsReliable,
+
+		// -----<new versions must be added before this line>-------------------------------------------------
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	// The GUID for this custom version number
+	const static FGuid GUID;
+
+private:
+	FRPGSaveGameCustomVersion() {}
+};
+
+/** Compression applied to the compact inventory block, the method used is stored in the save so any of them can be read back */
+UENUM(BlueprintType)
+enum class ERPGSaveGameCompression : uint8
+{
+	None,
+	Zlib,
+	Oodle,
+};
+
 /** Object that is written to and read from the save game archive, with a data version */
 UCLASS(BlueprintType)
 class ACTIONRPG_API URPGSaveGame : public USaveGame
@@ -39,6 +77,10 @@ public:
 	{
 		// Set to current version, this will get overwritten during serialization when loading
 		SavedDataVersion = ERPGSaveGameVersion::LatestVersion;
+		JournalSequence = 0;
+		Compression = ERPGSaveGameCompression::None;
+		bWriteCompactInventory = true;
+		bLoadFailed = false;
 	}
 
 	/** Map of items to item data */
@@ -53,6 +95,31 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = SaveGame)
 	FString UserId;
 
+	/** Sequence number of the last inventory journal entry or full snapshot included in this save, journal entries at or below it are skipped on replay */
+	UPROPERTY()
+	int64 JournalSequence;
+
+	/** Applies a single journal entry to the inventory and slot maps, used for both live changes and replay */
+	void ApplyJournalEntry(const FRPGInventoryJournalEntry& Entry);
+
+	/** Sets the compression used the next time this is saved */
+	void SetCompression(ERPGSaveGameCompression InCompression)
+	{
+		Compression = InCompression;
+	}
+
+	/** If false the next save uses the AddedInventoryJournal layout with tagged inventory properties, only used to compare the formats */
+	void SetWriteCompactInventory(bool bInWriteCompactInventory)
+	{
+		bWriteCompactInventory = bInWriteCompactInventory;
+	}
+
+	/** Returns true if this was loaded from corrupt data. The inventory is then incomplete, so it must not be used or saved over the slot it came from */
+	bool HasLoadFailed() const
+	{
+		return bLoadFailed;
+	}
+
 protected:
 	/** Deprecated way of storing items, this is read in but not saved out */
 	UPROPERTY()
@@ -62,6 +129,21 @@ protected:
 	UPROPERTY()
 	int32 SavedDataVersion;
 
+	/** Compression used when saving, not saved itself */
+	ERPGSaveGameCompression Compression;
+
+	/** Layout used when saving, not saved itself */
+	bool bWriteCompactInventory;
+
+	/** Set when loading hit corrupt data, not saved itself */
+	bool bLoadFailed;
+
 	/** Overridden to allow version fixups */
 	virtual void Serialize(FArchive& Ar) override;
+
+	/**
+	 * Reads or writes InventoryData and SlottedItems as an interned table of asset type and name strings followed by the entries
+	 * as packed integers indexing into it. Tagged serialization repeats the property, struct and name strings for every entry
+	 */
+	void SerializeCompactInventory(FArchive& Ar);
 };
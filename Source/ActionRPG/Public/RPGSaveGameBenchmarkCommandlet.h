@@ -0,0 +1,38 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ActionRPG.h"
+#include "Commandlets/Commandlet.h"
+#include "RPGSaveGame.h"
+#include "RPGSaveGameBenchmarkCommandlet.generated.h"
+
+/**
+ * Compares save size and save/load time of the save game layouts on a synthetic inventory. With a Development editor:
+ * <Editor>-Cmd <Project>.uproject -run=RPGSaveGameBenchmark -nullrhi -unattended -stdout
+ *     [-Items=2000] [-Slots=12] [-Iterations=200] [-StartupLoad]
+ *
+ * Every layout goes through UGameplayStatics::SaveGameToMemory and LoadGameFromMemory, the same path the save slots use,
+ * and the loaded inventory is checked against the original so a broken layout fails the run
+ *
+ * -StartupLoad also writes the save to a benchmark slot and compares the startup load paths of the game instance: how long
+ * LoadOrCreateSaveGame and LoadOrCreateSaveGameAsyncNative block the game thread, and how long until the save game is ready.
+ * Run it from the device being measured, the first iteration is the only one that reads cold storage
+ */
+UCLASS()
+class ACTIONRPG_API URPGSaveGameBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGSaveGameBenchmarkCommandlet();
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	/** Saves and loads SaveGame Iterations times with one layout and logs the results, returns false if the loaded inventory did not match */
+	bool RunFormat(const TCHAR* FormatName, URPGSaveGame* SaveGame, bool bCompactInventory, ERPGSaveGameCompression Compression, int32 NumIterations);
+
+	/** Loads SaveGame from a slot Iterations times through the synchronous and asynchronous game instance paths and logs the results, returns false if a load failed */
+	bool RunStartupLoad(URPGSaveGame* SaveGame, int32 NumIterations);
+};
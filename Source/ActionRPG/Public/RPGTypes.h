@@ -127,6 +127,227 @@ struct ACTIONRPG_API FRPGItemData
 	}
 };
 
+/** Kinds of change that can be recorded in the inventory journal */
+enum class ERPGInventoryJournalOp : uint8
+{
+	/** Item was added to the inventory, ItemData holds the new count/level */
+	ItemAdded,
+	/** Item was removed entirely from the inventory */
+	ItemRemoved,
+	/** Count or level of an existing item changed, ItemData holds the new values */
+	ItemDataChanged,
+	/** Contents of ItemSlot changed, ItemId is invalid if the slot was emptied */
+	SlotChanged,
+};
+
+/** Single change to the inventory, appended to the journal so saves do not need to rewrite the whole inventory */
+struct ACTIONRPG_API FRPGInventoryJournalEntry
+{
+	FRPGInventoryJournalEntry()
+		: Op(ERPGInventoryJournalOp::ItemDataChanged)
+		, Sequence(0)
+		, ItemData(0, 0)
+	{}
+
+	static FRPGInventoryJournalEntry MakeItemChange(ERPGInventoryJournalOp InOp, const FPrimaryAssetId& InItemId, const FRPGItemData& InItemData)
+	{
+		FRPGInventoryJournalEntry Entry;
+		Entry.Op = InOp;
+		Entry.ItemId = InItemId;
+		Entry.ItemData = InItemData;
+		return Entry;
+	}
+
+	static FRPGInventoryJournalEntry MakeSlotChange(const FRPGItemSlot& InItemSlot, const FPrimaryAssetId& InItemId)
+	{
+		FRPGInventoryJournalEntry Entry;
+		Entry.Op = ERPGInventoryJournalOp::SlotChanged;
+		Entry.ItemId = InItemId;
+		Entry.ItemSlot = InItemSlot;
+		return Entry;
+	}
+
+	/** What kind of change this is */
+	ERPGInventoryJournalOp Op;
+
+	/** Monotonic sequence number, entries at or below the snapshot's sequence are already part of the snapshot */
+	int64 Sequence;
+
+	/** Item that changed, or the item now in ItemSlot */
+	FPrimaryAssetId ItemId;
+
+	/** New count/level for item changes */
+	FRPGItemData ItemData;
+
+	/** Slot that changed for slot changes */
+	FRPGItemSlot ItemSlot;
+
+	/** Serializes the entry, names must be written with a name-as-string proxy archive */
+	friend FArchive& operator<<(FArchive& Ar, FRPGInventoryJournalEntry& Entry)
+	{
+		uint8 OpValue = (uint8)Entry.Op;
+		Ar << OpValue;
+		Entry.Op = (ERPGInventoryJournalOp)OpValue;
+
+		Ar << Entry.Sequence;
+
+		FName ItemTypeName = Entry.ItemId.PrimaryAssetType.GetName();
+		Ar << ItemTypeName;
+		Ar << Entry.ItemId.PrimaryAssetName;
+		Entry.ItemId.PrimaryAssetType = ItemTypeName;
+
+		if (Entry.Op == ERPGInventoryJournalOp::SlotChanged)
+		{
+			FName SlotTypeName = Entry.ItemSlot.ItemType.GetName();
+			Ar << SlotTypeName;
+			Ar << Entry.ItemSlot.SlotNumber;
+			Entry.ItemSlot.ItemType = SlotTypeName;
+		}
+		else if (Entry.Op != ERPGInventoryJournalOp::ItemRemoved)
+		{
+			Ar << Entry.ItemData.ItemCount;
+			Ar << Entry.ItemData.ItemLevel;
+		}
+		return Ar;
+	}
+};
+
+/** Aggregated set of inventory changes, dispatched once per frame when notifications are batched */
+USTRUCT(BlueprintType)
+struct ACTIONRPG_API FRPGInventoryChangeSet
+{
+	GENERATED_BODY()
+
+	/** Items that were added or had their count/level increased */
+	UPROPERTY(BlueprintReadOnly, Category = Inventory)
+	TArray<URPGItem*> AddedItems;
+
+	/** Items that were removed or had their count decreased */
+	UPROPERTY(BlueprintReadOnly, Category = Inventory)
+	TArray<URPGItem*> RemovedItems;
+
+	/** Slots whose contents changed, query the inventory for the current item */
+	UPROPERTY(BlueprintReadOnly, Category = Inventory)
+	TArray<FRPGItemSlot> ChangedSlots;
+
+	/** Returns true if nothing changed */
+	bool IsEmpty() const
+	{
+		return AddedItems.Num() == 0 && RemovedItems.Num() == 0 && ChangedSlots.Num() == 0;
+	}
+
+	/** Clears all changes, keeping allocations for the next frame */
+	void Reset()
+	{
+		AddedItems.Reset();
+		RemovedItems.Reset();
+		ChangedSlots.Reset();
+	}
+};
+
+/** Where a patch chunk is in the download and mount process */
+UENUM(BlueprintType)
+enum class ERPGChunkPatchState : uint8
+{
+	/** Waiting for a download slot */
+	Queued,
+	/** Handed to the downloader */
+	Downloading,
+	/** Downloaded and mounting */
+	Mounting,
+	/** Mounted, its content can be used */
+	Mounted,
+	/** Failed to download or mount */
+	Failed,
+};
+
+/** Progress of a single patch chunk */
+USTRUCT(BlueprintType)
+struct ACTIONRPG_API FRPGChunkPatchProgress
+{
+	GENERATED_BODY()
+
+	FRPGChunkPatchProgress()
+		: ChunkId(INDEX_NONE)
+		, Priority(0)
+		, State(ERPGChunkPatchState::Queued)
+		, DownloadSeconds(0.f)
+		, MountSeconds(0.f)
+	{}
+
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	int32 ChunkId;
+
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	int32 Priority;
+
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	ERPGChunkPatchState State;
+
+	/** Seconds spent downloading, so far if still downloading */
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	float DownloadSeconds;
+
+	/** Seconds spent mounting, so far if still mounting */
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	float MountSeconds;
+};
+
+/** Overall patch progress, with throughput averaged over a sliding window */
+USTRUCT(BlueprintType)
+struct ACTIONRPG_API FRPGPatchProgress
+{
+	GENERATED_BODY()
+
+	FRPGPatchProgress()
+		: BytesDownloaded(0)
+		, TotalBytesToDownload(0)
+		, DownloadPercent(0.f)
+		, ChunksMounted(0)
+		, TotalChunksToMount(0)
+		, MountPercent(0.f)
+		, BytesPerSecond(0.f)
+		, EstimatedSecondsRemaining(-1.f)
+		, ElapsedSeconds(0.f)
+	{}
+
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	int64 BytesDownloaded;
+
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	int64 TotalBytesToDownload;
+
+	/** 0 to 100, 100 if there was nothing to download */
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	float DownloadPercent;
+
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	int32 ChunksMounted;
+
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	int32 TotalChunksToMount;
+
+	/** 0 to 100, 100 if there was nothing to mount */
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	float MountPercent;
+
+	/** Download rate over the last few seconds */
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	float BytesPerSecond;
+
+	/** Seconds until the download completes at the current rate, negative if it cannot be estimated yet */
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	float EstimatedSecondsRemaining;
+
+	/** Seconds since patching started */
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	float ElapsedSeconds;
+
+	/** State of every chunk being patched, in queue order */
+	UPROPERTY(BlueprintReadOnly, Category = Patching)
+	TArray<FRPGChunkPatchProgress> Chunks;
+};
+
 /** Delegate called when an inventory item changes */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnInventoryItemChanged, bool, bAdded, URPGItem*, Item);
 DECLARE_MULTICAST_DELEGATE_TwoParams(FOnInventoryItemChangedNative, bool, URPGItem*);
@@ -135,6 +356,10 @@ DECLARE_MULTICAST_DELEGATE_TwoParams(FOnInventoryItemChangedNative, bool, URPGIt
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnSlottedItemChanged, FRPGItemSlot, ItemSlot, URPGItem*, Item);
 DECLARE_MULTICAST_DELEGATE_TwoParams(FOnSlottedItemChangedNative, FRPGItemSlot, URPGItem*);
 
+/** Delegate called with every inventory change, aggregated per frame if notifications are batched */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInventoryChangeSet, const FRPGInventoryChangeSet&, ChangeSet);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnInventoryChangeSetNative, const FRPGInventoryChangeSet&);
+
 /** Delegate called when the entire inventory has been loaded, all items may have been replaced */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnInventoryLoaded);
 DECLARE_MULTICAST_DELEGATE(FOnInventoryLoadedNative);
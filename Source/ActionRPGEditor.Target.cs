@@ -15,7 +15,7 @@ public class ActionRPGEditorTarget : TargetRules
 		Type = TargetType.Editor;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Latest;
 		DefaultBuildSettings = BuildSettingsVersion.Latest;
-		ExtraModuleNames.AddRange( new string[] { "ActionRPG" } );
+		ExtraModuleNames.AddRange( new string[] { "ActionRPG", "ActionRPGEditor" } );
 
 		// Build\BatchFiles\Build.bat -Target="GameEditor Win64 Development" -Project="G:\Client\Game.uproject" -WaitMutex -importcer
 		bool bExportCer = IsContainInCmd("-importcer");
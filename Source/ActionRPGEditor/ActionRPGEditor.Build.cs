@@ -0,0 +1,19 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+// Editor only, so the commandlets and the classes they need never ship in game, client or server builds
+
+public class ActionRPGEditor : ModuleRules
+{
+	public ActionRPGEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PrivatePCHHeaderFile = "Public/ActionRPGEditor.h";
+
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "ActionRPG", "GameplayAbilities", "GameplayTags", "GameplayTasks" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "AIModule" });
+	}
+}
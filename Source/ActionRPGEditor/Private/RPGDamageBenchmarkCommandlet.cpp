@@ -0,0 +1,312 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "RPGDamageBenchmarkCommandlet.h"
+#include "RPGCharacterBase.h"
+#include "Abilities/RPGAttributeSet.h"
+#include "Abilities/RPGDamageExecution.h"
+#include "Abilities/RPGTargetType.h"
+#include "AbilitySystemComponent.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+/** Forwards to the real allocator and counts allocations */
+class FRPGCountingMalloc final : public FMalloc
+{
+public:
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		NumAllocations.Increment();
+		return Inner->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		NumAllocations.Increment();
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		Inner->Free(Original);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return Inner->QuantizeSize(Count, Alignment);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return Inner->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual void Trim(bool bTrimThreadCaches) override
+	{
+		Inner->Trim(bTrimThreadCaches);
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return Inner->IsInternallyThreadSafe();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return TEXT("RPGCountingMalloc");
+	}
+
+	FMalloc* Inner = nullptr;
+	FThreadSafeCounter64 NumAllocations;
+};
+
+/** Counts allocations made through GMalloc while in scope, the previous allocator is put back when it goes out of scope */
+class FRPGScopedAllocationCounter
+{
+public:
+	FRPGScopedAllocationCounter()
+	{
+		// Static, so a thread that read GMalloc just before it is put back can still finish its call through the wrapper
+		static FRPGCountingMalloc CountingMalloc;
+
+		check(GMalloc != &CountingMalloc);
+		CountingMalloc.Inner = GMalloc;
+		CountingMalloc.NumAllocations.Reset();
+
+		Counter = &CountingMalloc;
+		GMalloc = Counter;
+	}
+
+	~FRPGScopedAllocationCounter()
+	{
+		GMalloc = Counter->Inner;
+	}
+
+	/** Allocations on any thread since this was created */
+	int64 GetNumAllocations() const
+	{
+		return Counter->NumAllocations.GetValue();
+	}
+
+private:
+	FRPGCountingMalloc* Counter;
+};
+
+URPGDamageBenchmarkCommandlet::URPGDamageBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 URPGDamageBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 NumCharacters = 64;
+	int32 NumHits = 20000;
+	int32 NumWarmupHits = 500;
+	FString CharacterClassPath;
+
+	FParse::Value(*Params, TEXT("Characters="), NumCharacters);
+	FParse::Value(*Params, TEXT("Hits="), NumHits);
+	FParse::Value(*Params, TEXT("Warmup="), NumWarmupHits);
+	FParse::Value(*Params, TEXT("CharacterClass="), CharacterClassPath);
+	const bool bCountAllocations = !FParse::Param(*Params, TEXT("NoAllocCount"));
+
+	NumCharacters = FMath::Max(NumCharacters, 2);
+	NumHits = FMath::Max(NumHits, 1);
+	NumWarmupHits = FMath::Max(NumWarmupHits, 0);
+
+	TSubclassOf<ARPGCharacterBase> CharacterClass = ARPGCharacterBase::StaticClass();
+	if (!CharacterClassPath.IsEmpty())
+	{
+		CharacterClass = LoadClass<ARPGCharacterBase>(nullptr, *CharacterClassPath);
+		if (!CharacterClass)
+		{
+			UE_LOG(LogActionRPG, Error, TEXT("RPGDamageBenchmark: Failed to load character class %s"), *CharacterClassPath);
+			return 1;
+		}
+	}
+
+	FGameplayTag ContainerTag = FGameplayTag::RequestGameplayTag(FName(TEXT("EffectContainer.Default")), false);
+	if (!ContainerTag.IsValid())
+	{
+		UE_LOG(LogActionRPG, Error, TEXT("RPGDamageBenchmark: EffectContainer.Default gameplay tag is not registered"));
+		return 1;
+	}
+
+	// Set up the ability template before any instance is made from it
+	URPGBenchmarkGameplayAbility* AbilityCDO = GetMutableDefault<URPGBenchmarkGameplayAbility>();
+	FRPGGameplayEffectContainer& Container = AbilityCDO->EffectContainerMap.FindOrAdd(ContainerTag);
+	Container.TargetType = URPGTargetType_UseEventData::StaticClass();
+	Container.TargetGameplayEffectClasses.Reset();
+	Container.TargetGameplayEffectClasses.Add(URPGBenchmarkDamageEffect::StaticClass());
+	AbilityCDO->ContainerTag = ContainerTag;
+	AbilityCDO->bSnapshotSourceAttributes = FParse::Param(*Params, TEXT("Snapshot"));
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("RPGDamageBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	// Lay characters out on a grid so position based target types behave like a crowded fight
+	TArray<ARPGCharacterBase*> Characters;
+	const int32 GridWidth = FMath::CeilToInt(FMath::Sqrt((float)NumCharacters));
+	for (int32 Index = 0; Index < NumCharacters; Index++)
+	{
+		const FVector Location((Index % GridWidth) * 150.f, (Index / GridWidth) * 150.f, 100.f);
+		ARPGCharacterBase* Character = SpawnBenchmarkCharacter(World, CharacterClass, Location);
+		if (Character)
+		{
+			Characters.Add(Character);
+		}
+	}
+
+	int32 Result = 0;
+
+	if (Characters.Num() < 2)
+	{
+		UE_LOG(LogActionRPG, Error, TEXT("RPGDamageBenchmark: Could not spawn enough characters"));
+		Result = 1;
+	}
+	else
+	{
+		for (int32 HitIndex = 0; HitIndex < NumWarmupHits; HitIndex++)
+		{
+			RunHit(Characters[HitIndex % Characters.Num()], Characters[(HitIndex + 1) % Characters.Num()]);
+		}
+
+		TArray<uint64> HitCycles;
+		HitCycles.Reserve(NumHits);
+		int32 NumFailedHits = 0;
+
+		int64 NumAllocations = 0;
+		uint64 TotalCycles = 0;
+		{
+			TOptional<FRPGScopedAllocationCounter> AllocationCounter;
+			if (bCountAllocations)
+			{
+				AllocationCounter.Emplace();
+			}
+
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			for (int32 HitIndex = 0; HitIndex < NumHits; HitIndex++)
+			{
+				// Round robin so every hit lands on a different attacker/victim pair
+				const int32 VictimOffset = 1 + (HitIndex / Characters.Num()) % (Characters.Num() - 1);
+				ARPGCharacterBase* Attacker = Characters[HitIndex % Characters.Num()];
+				ARPGCharacterBase* Victim = Characters[(HitIndex + VictimOffset) % Characters.Num()];
+
+				const uint64 HitStartCycles = FPlatformTime::Cycles64();
+				if (!RunHit(Attacker, Victim))
+				{
+					NumFailedHits++;
+				}
+				HitCycles.Add(FPlatformTime::Cycles64() - HitStartCycles);
+			}
+			TotalCycles = FPlatformTime::Cycles64() - StartCycles;
+
+			if (AllocationCounter.IsSet())
+			{
+				NumAllocations = AllocationCounter->GetNumAllocations();
+			}
+		}
+
+		HitCycles.Sort();
+		auto PercentileMicroseconds = [&HitCycles](float Percentile)
+		{
+			const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * HitCycles.Num()) - 1, 0, HitCycles.Num() - 1);
+			return FPlatformTime::ToMilliseconds64(HitCycles[Index]) * 1000.0;
+		};
+
+		const double TotalSeconds = FPlatformTime::ToSeconds64(TotalCycles);
+
+		UE_LOG(LogActionRPG, Display, TEXT("RPGDamageBenchmark: %d characters (%s), %d hits, %d warmup, %d failed"), Characters.Num(), *CharacterClass->GetName(), NumHits, NumWarmupHits, NumFailedHits);
+		UE_LOG(LogActionRPG, Display, TEXT("RPGDamageBenchmark: per hit us p50 %.2f p90 %.2f p99 %.2f max %.2f"), PercentileMicroseconds(0.5f), PercentileMicroseconds(0.9f), PercentileMicroseconds(0.99f), PercentileMicroseconds(1.f));
+		UE_LOG(LogActionRPG, Display, TEXT("RPGDamageBenchmark: %.0f hits/sec over %.3f s"), TotalSeconds > 0.0 ? NumHits / TotalSeconds : 0.0, TotalSeconds);
+		if (bCountAllocations)
+		{
+			UE_LOG(LogActionRPG, Display, TEXT("RPGDamageBenchmark: %.2f allocations per hit (all threads)"), (double)NumAllocations / NumHits);
+		}
+
+		Result = NumFailedHits > 0 ? 1 : 0;
+	}
+
+	World->DestroyWorld(false);
+	GEngine->DestroyWorldContext(World);
+
+	return Result;
+}
+
+ARPGCharacterBase* URPGDamageBenchmarkCommandlet::SpawnBenchmarkCharacter(UWorld* World, TSubclassOf<ARPGCharacterBase> CharacterClass, const FVector& Location)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ARPGCharacterBase* Character = World->SpawnActor<ARPGCharacterBase>(CharacterClass, Location, FRotator::ZeroRotator, SpawnParams);
+	UAbilitySystemComponent* AbilitySystemComponent = Character ? Character->GetAbilitySystemComponent() : nullptr;
+
+	if (!AbilitySystemComponent)
+	{
+		return nullptr;
+	}
+
+	// There is no controller, so do what PossessedBy would have done for the ability system
+	AbilitySystemComponent->InitAbilityActorInfo(Character, Character);
+	AbilitySystemComponent->GiveAbility(FGameplayAbilitySpec(URPGBenchmarkGameplayAbility::StaticClass(), 1, INDEX_NONE, Character));
+
+	// Nobody should die during the run, death handling is not what we are measuring
+	AbilitySystemComponent->SetNumericAttributeBase(URPGAttributeSet::GetMaxHealthAttribute(), 1.e9f);
+	AbilitySystemComponent->SetNumericAttributeBase(URPGAttributeSet::GetHealthAttribute(), 1.e9f);
+
+	return Character;
+}
+
+bool URPGDamageBenchmarkCommandlet::RunHit(ARPGCharacterBase* Attacker, ARPGCharacterBase* Victim)
+{
+	UAbilitySystemComponent* AbilitySystemComponent = Attacker->GetAbilitySystemComponent();
+	FGameplayAbilitySpec* Spec = AbilitySystemComponent->FindAbilitySpecFromClass(URPGBenchmarkGameplayAbility::StaticClass());
+
+	if (!Spec)
+	{
+		return false;
+	}
+
+	FGameplayEventData Payload;
+	Payload.EventTag = GetDefault<URPGBenchmarkGameplayAbility>()->ContainerTag;
+	Payload.Instigator = Attacker;
+	Payload.Target = Victim;
+
+	return AbilitySystemComponent->TriggerAbilityFromGameplayEvent(Spec->Handle, AbilitySystemComponent->AbilityActorInfo.Get(), Payload.EventTag, &Payload, *AbilitySystemComponent);
+}
+
+URPGBenchmarkGameplayAbility::URPGBenchmarkGameplayAbility()
+{
+	InstancingPolicy = EGameplayAbilityInstancingPolicy::InstancedPerActor;
+	NetExecutionPolicy = EGameplayAbilityNetExecutionPolicy::ServerOnly;
+}
+
+void URPGBenchmarkGameplayAbility::ActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, const FGameplayEventData* TriggerEventData)
+{
+	if (TriggerEventData)
+	{
+		ApplyEffectContainer(ContainerTag, *TriggerEventData);
+	}
+
+	EndAbility(Handle, ActorInfo, ActivationInfo, false, false);
+}
+
+URPGBenchmarkDamageEffect::URPGBenchmarkDamageEffect()
+{
+	DurationPolicy = EGameplayEffectDurationType::Instant;
+
+	// Base damage is fed into the execution's Damage capture, same as the damage effects in content
+	FGameplayEffectExecutionScopedModifierInfo DamageModifier(FGameplayEffectAttributeCaptureDefinition(URPGAttributeSet::GetDamageAttribute(), EGameplayEffectAttributeCaptureSource::Source, true));
+	DamageModifier.ModifierOp = EGameplayModOp::Additive;
+	DamageModifier.ModifierMagnitude = FGameplayEffectModifierMagnitude(FScalableFloat(10.f));
+
+	FGameplayEffectExecutionDefinition DamageExecution;
+	DamageExecution.CalculationClass = URPGDamageExecution::StaticClass();
+	DamageExecution.CalculationModifiers.Add(DamageModifier);
+	Executions.Add(DamageExecution);
+}
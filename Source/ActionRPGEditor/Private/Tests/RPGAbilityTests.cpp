@@ -0,0 +1,78 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#if WITH_DEV_AUTOMATION_TESTS
+#include "RPGCharacterBase.h"
+#include "RPGDamageBenchmarkCommandlet.h"
+#include "Abilities/RPGAbilityTypes.h"
+#include "Abilities/RPGAttributeSet.h"
+#include "AbilitySystemComponent.h"
+#include "Abilities/GameplayAbilityTargetTypes.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRPGAbilityTest_SourceSnapshot, "ActionRPG.Abilities.SourceSnapshot", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FRPGAbilityTest_SourceSnapshot::RunTest(const FString& Parameters)
+{
+	UWorld* TestWorld = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(TestWorld);
+	TestWorld->InitializeActorsForPlay(FURL());
+	TestWorld->BeginPlay();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	TArray<UAbilitySystemComponent*> AbilitySystemComponents;
+	for (int32 Index = 0; Index < 4; Index++)
+	{
+		ARPGCharacterBase* Character = TestWorld->SpawnActor<ARPGCharacterBase>(ARPGCharacterBase::StaticClass(), FVector(Index * 200.f, 0.f, 100.f), FRotator::ZeroRotator, SpawnParams);
+		UAbilitySystemComponent* AbilitySystemComponent = Character->GetAbilitySystemComponent();
+		AbilitySystemComponent->InitAbilityActorInfo(Character, Character);
+		AbilitySystemComponent->SetNumericAttributeBase(URPGAttributeSet::GetMaxHealthAttribute(), 1000.f);
+		AbilitySystemComponent->SetNumericAttributeBase(URPGAttributeSet::GetHealthAttribute(), 1000.f);
+		AbilitySystemComponents.Add(AbilitySystemComponent);
+	}
+
+	UAbilitySystemComponent* Source = AbilitySystemComponents[0];
+	FGameplayEffectSpecHandle SpecHandle = Source->MakeOutgoingSpec(URPGBenchmarkDamageEffect::StaticClass(), 1.f, Source->MakeEffectContext());
+
+	FRPGGameplayEffectContext* Context = FRPGGameplayEffectContext::Get(SpecHandle.Data->GetContext());
+	if (TestNotNull(TEXT("FRPGGameplayEffectContext"), Context))
+	{
+		Context->EnableSourceSnapshot();
+		TSharedPtr<FRPGSourceAttributeSnapshot> Snapshot = Context->SourceSnapshot;
+
+		for (int32 Index = 1; Index < AbilitySystemComponents.Num(); Index++)
+		{
+			// Applying to target data duplicates the context for every target, like ApplyEffectContainerSpec does
+			FGameplayAbilityTargetData_ActorArray* TargetData = new FGameplayAbilityTargetData_ActorArray();
+			TargetData->TargetActorArray.Add(AbilitySystemComponents[Index]->GetAvatarActor());
+			FGameplayAbilityTargetDataHandle TargetDataHandle(TargetData);
+			TargetData->ApplyGameplayEffectSpec(*SpecHandle.Data);
+
+			const float Health = AbilitySystemComponents[Index]->GetNumericAttribute(URPGAttributeSet::GetHealthAttribute());
+
+			if (Index == 1)
+			{
+				// Base damage of 10, AttackPower and DefensePower default to 1
+				TestTrue(TEXT("first target captured the snapshot"), Snapshot->bCaptured);
+				TestEqual(TEXT("first target damage"), Health, 990.f);
+
+				// A target that captures again would ignore this
+				Snapshot->Damage = 30.f;
+			}
+			else
+			{
+				TestEqual(FString::Printf(TEXT("target %d reused the snapshot"), Index), Health, 970.f);
+			}
+		}
+	}
+
+	TestWorld->DestroyWorld(false);
+	GEngine->DestroyWorldContext(TestWorld);
+
+	return true;
+}
+
+#endif
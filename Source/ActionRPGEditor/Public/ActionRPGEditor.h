@@ -0,0 +1,10 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+// ----------------------------------------------------------------------------------------------------------------
+// Editor only module for benchmarks and other development tools that run against the game module
+// Anything here is only built for the editor target, use the game module for code the game needs
+// ----------------------------------------------------------------------------------------------------------------
+
+#include "ActionRPG.h"
@@ -0,0 +1,65 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ActionRPGEditor.h"
+#include "Commandlets/Commandlet.h"
+#include "GameplayEffect.h"
+#include "Abilities/RPGGameplayAbility.h"
+#include "RPGDamageBenchmarkCommandlet.generated.h"
+
+class ARPGCharacterBase;
+
+/**
+ * Headless benchmark for the combat hot path, run with -nullrhi so it works on a server without a GPU:
+ * <Editor>-Cmd <Project>.uproject -run=RPGDamageBenchmark -nullrhi -unattended -stdout
+ *     [-Characters=64] [-Hits=20000] [-Warmup=500] [-CharacterClass=/Game/...] [-NoAllocCount] [-Snapshot]
+ * Timings from a Debug editor are only useful for comparing runs of the same build
+ *
+ * Spawns characters in an empty game world, then every hit triggers an ability on one character that runs the
+ * EffectContainer.Default container against another, going through ApplyEffectContainer, the target type,
+ * URPGDamageExecution and URPGAttributeSet::PostGameplayEffectExecute
+ */
+UCLASS()
+class ACTIONRPGEDITOR_API URPGDamageBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGDamageBenchmarkCommandlet();
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	/** Spawns and initializes one character, gives it the benchmark ability and enough health to survive the run */
+	ARPGCharacterBase* SpawnBenchmarkCharacter(UWorld* World, TSubclassOf<ARPGCharacterBase> CharacterClass, const FVector& Location);
+
+	/** Triggers the benchmark ability on Attacker against Victim, returns false if the ability did not activate */
+	bool RunHit(ARPGCharacterBase* Attacker, ARPGCharacterBase* Victim);
+};
+
+/** Ability used by the benchmark, applies its effect container to the event target and ends immediately */
+UCLASS(NotBlueprintable, Transient)
+class ACTIONRPGEDITOR_API URPGBenchmarkGameplayAbility : public URPGGameplayAbility
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGBenchmarkGameplayAbility();
+	virtual void ActivateAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, const FGameplayEventData* TriggerEventData) override;
+
+	/** Container applied on every activation */
+	FGameplayTag ContainerTag;
+};
+
+/** Instant damage effect using URPGDamageExecution with a fixed base damage, so the benchmark does not depend on content */
+UCLASS(NotBlueprintable, Transient)
+class ACTIONRPGEDITOR_API URPGBenchmarkDamageEffect : public UGameplayEffect
+{
+	GENERATED_BODY()
+
+public:
+	// Constructor and overrides
+	URPGBenchmarkDamageEffect();
+};
@@ -3,16 +3,56 @@
 #include "SlateExtras.h"
 #include "MoviePlayer.h"
 #include "Widgets/Images/SThrobber.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/PackageName.h"
+#include "UObject/UObjectGlobals.h"
+#include <atomic>
 
 
 // This module must be loaded "PreLoadingScreen" in the .uproject file, otherwise it will not hook in time!
 
-struct FRPGLoadingScreenBrush : public FSlateDynamicImageBrush, public FGCObject
+// Version of the logo with text baked in, path is hardcoded because this loads very early in startup
+static const TCHAR* LoadingScreenLogoPath = TEXT("/Game/UI/T_ActionRPG_TransparentLogo.T_ActionRPG_TransparentLogo");
+
+struct FRPGLoadingScreenBrush : public FSlateDynamicImageBrush, public FGCObject, public TSharedFromThis<FRPGLoadingScreenBrush>
 {
-	FRPGLoadingScreenBrush(const FName InTextureName, const FVector2D& InImageSize)
+	/** If bLoadAsync is false the texture is loaded right away, otherwise it is not ready until LoadAsync has finished */
+	FRPGLoadingScreenBrush(const FName InTextureName, const FVector2D& InImageSize, bool bLoadAsync = false)
 		: FSlateDynamicImageBrush(InTextureName, InImageSize)
+		, bIsReady(false)
+	{
+		if (!bLoadAsync)
+		{
+			SetResourceObject(LoadObject<UObject>(NULL, *InTextureName.ToString()));
+			bIsReady = true;
+		}
+	}
+
+	/** Streams the texture in, the brush stays resident afterwards so later loading screens can show it on their first frame */
+	void LoadAsync()
+	{
+		const FString ObjectPath = GetResourceName().ToString();
+		TWeakPtr<FRPGLoadingScreenBrush> WeakThis = AsShared();
+
+		LoadPackageAsync(FPackageName::ObjectPathToPackageName(ObjectPath), FLoadPackageAsyncDelegate::CreateLambda([WeakThis, ObjectPath](const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result)
+		{
+			TSharedPtr<FRPGLoadingScreenBrush> PinnedThis = WeakThis.Pin();
+			UObject* Texture = Result == EAsyncLoadingResult::Succeeded ? FindObject<UObject>(nullptr, *ObjectPath) : nullptr;
+
+			if (PinnedThis.IsValid() && Texture)
+			{
+				PinnedThis->SetResourceObject(Texture);
+
+				// Widgets are painted on the movie player thread, they only look at the resource once this is set
+				PinnedThis->bIsReady.store(true, std::memory_order_release);
+			}
+		}));
+	}
+
+	/** Returns true once the texture can be drawn */
+	bool IsReady() const
 	{
-		SetResourceObject(LoadObject<UObject>(NULL, *InTextureName.ToString()));
+		return bIsReady.load(std::memory_order_acquire);
 	}
 
 	virtual void AddReferencedObjects(FReferenceCollector& Collector)
@@ -27,23 +67,32 @@ struct FRPGLoadingScreenBrush : public FSlateDynamicImageBrush, public FGCObject
 	{
 		return TEXT("FRPGLoadingScreenBrush");
 	}
+
+private:
+	std::atomic<bool> bIsReady;
 };
 
 class SRPGLoadingScreen : public SCompoundWidget
 {
 public:
 	SLATE_BEGIN_ARGS(SRPGLoadingScreen) {}
+		/** Preloaded logo brush, if not set the logo is loaded when the widget is constructed */
+		SLATE_ARGUMENT(TSharedPtr<FRPGLoadingScreenBrush>, LogoBrush)
 	SLATE_END_ARGS()
 
 	void Construct(const FArguments& InArgs)
 	{
-		// Load version of the logo with text baked in, path is hardcoded because this loads very early in startup
-		static const FName LoadingScreenName(TEXT("/Game/UI/T_ActionRPG_TransparentLogo.T_ActionRPG_TransparentLogo"));
+		LoadingScreenBrush = InArgs._LogoBrush;
+		if (!LoadingScreenBrush.IsValid())
+		{
+			LoadingScreenBrush = MakeShareable(new FRPGLoadingScreenBrush(LoadingScreenLogoPath, FVector2D(1024, 256)));
+		}
 
-		LoadingScreenBrush = MakeShareable(new FRPGLoadingScreenBrush(LoadingScreenName, FVector2D(1024, 256)));
+		BackgroundBrush.TintColor = FLinearColor(0.034f, 0.034f, 0.034f, 1.0f);
 
-		FSlateBrush* BGBrush = new FSlateBrush();
-		BGBrush->TintColor = FLinearColor(0.034f, 0.034f, 0.034f, 1.0f);
+		// Solid box the size of the logo, shown while a preloaded logo is still streaming in
+		FallbackBrush.ImageSize = LoadingScreenBrush->ImageSize;
+		FallbackBrush.TintColor = FLinearColor(0.06f, 0.06f, 0.06f, 1.0f);
 
 		ChildSlot
 			[
@@ -53,14 +102,14 @@ public:
 			.VAlign(VAlign_Fill)
 			[
 				SNew(SBorder)
-				.BorderImage(BGBrush)
+				.BorderImage(&BackgroundBrush)
 			]
 			+ SOverlay::Slot()
 			.HAlign(HAlign_Center)
 			.VAlign(VAlign_Center)
 			[
 				SNew(SImage)
-				.Image(LoadingScreenBrush.Get())
+				.Image(this, &SRPGLoadingScreen::GetLogoImage)
 			]
 			+ SOverlay::Slot()
 			.HAlign(HAlign_Fill)
@@ -87,8 +136,18 @@ private:
 		return GetMoviePlayer()->IsLoadingFinished() ? EVisibility::Collapsed : EVisibility::Visible;
 	}
 
+	/** Returns the logo once it has loaded, the fallback before that */
+	const FSlateBrush* GetLogoImage() const
+	{
+		return LoadingScreenBrush->IsReady() ? LoadingScreenBrush.Get() : &FallbackBrush;
+	}
+
 	/** Loading screen image brush */
-	TSharedPtr< FSlateDynamicImageBrush> LoadingScreenBrush;
+	TSharedPtr<FRPGLoadingScreenBrush> LoadingScreenBrush;
+
+	/** Background fill and the stand-in for the logo while it loads */
+	FSlateBrush BackgroundBrush;
+	FSlateBrush FallbackBrush;
 };
 
 
@@ -97,8 +156,21 @@ class FActionRPGLoadingScreenModule : public IActionRPGLoadingScreenModule
 public:
 	virtual void StartupModule() override
 	{
-		// Force load for cooker reference
-		LoadObject<UObject>(nullptr, TEXT("/Game/UI/T_ActionRPG_TransparentLogo.T_ActionRPG_TransparentLogo"));
+		bool bPreloadTextures = true;
+		GConfig->GetBool(TEXT("ActionRPGLoadingScreen"), TEXT("bPreloadTextures"), bPreloadTextures, GGameIni);
+
+		if (bPreloadTextures && !IsRunningCommandlet())
+		{
+			// Resident for the lifetime of the module. The logo streams in while the startup movie set up below is already
+			// playing, so startup does not wait on it, and every loading screen shows the fallback box until it has arrived
+			LogoBrush = MakeShareable(new FRPGLoadingScreenBrush(LoadingScreenLogoPath, FVector2D(1024, 256), true));
+			LogoBrush->LoadAsync();
+		}
+		else
+		{
+			// Force load for cooker reference
+			LoadObject<UObject>(nullptr, LoadingScreenLogoPath);
+		}
 
 		if (IsMoviePlayerEnabled())
 		{
@@ -106,6 +178,11 @@ public:
 		}
 	}
 
+	virtual void ShutdownModule() override
+	{
+		LogoBrush.Reset();
+	}
+
 	virtual bool IsGameModule() const override
 	{
 		return true;
@@ -118,7 +195,7 @@ public:
 		LoadingScreen.bWaitForManualStop = bPlayUntilStopped;
 		LoadingScreen.bAllowEngineTick = bPlayUntilStopped;
 		LoadingScreen.MinimumLoadingScreenDisplayTime = PlayTime;
-		LoadingScreen.WidgetLoadingScreen = SNew(SRPGLoadingScreen);
+		LoadingScreen.WidgetLoadingScreen = SNew(SRPGLoadingScreen).LogoBrush(LogoBrush);
 		GetMoviePlayer()->SetupLoadingScreen(LoadingScreen);
 	}
 
@@ -132,9 +209,13 @@ public:
 		FLoadingScreenAttributes LoadingScreen;
 		LoadingScreen.bAutoCompleteWhenLoadingCompletes = true;
 		LoadingScreen.MinimumLoadingScreenDisplayTime = 3.f;
-		LoadingScreen.WidgetLoadingScreen = SNew(SRPGLoadingScreen);
+		LoadingScreen.WidgetLoadingScreen = SNew(SRPGLoadingScreen).LogoBrush(LogoBrush);
 		GetMoviePlayer()->SetupLoadingScreen(LoadingScreen);
 	}
+
+private:
+	/** Logo brush shared by every loading screen when textures are preloaded */
+	TSharedPtr<FRPGLoadingScreenBrush> LogoBrush;
 };
 
 IMPLEMENT_GAME_MODULE(FActionRPGLoadingScreenModule, ActionRPGLoadingScreen);